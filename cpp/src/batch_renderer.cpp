@@ -0,0 +1,107 @@
+#include "batch_renderer.h"
+#include <algorithm>
+#include <chrono>
+
+BatchRenderer::BatchRenderer() = default;
+
+BatchRenderer::~BatchRenderer() {
+    pool_.stop();
+}
+
+void BatchRenderer::init(float sampleRate) {
+    sampleRate_ = sampleRate;
+}
+
+void BatchRenderer::setSample(const float* data, int channels, int lengthInSamples) {
+    sampleData_ = data;
+    sampleChannels_ = channels;
+    sampleLength_ = data ? std::max(0, lengthInSamples) : 0;
+    spectralFrames_.clear();
+    framesValid_ = false;
+}
+
+void BatchRenderer::setImpulseResponse(const float* data, int lengthInSamples, int channels) {
+    impulseLength_ = data ? std::max(0, lengthInSamples) : 0;
+    impulseChannels_ = std::max(1, channels);
+    impulse_.assign(data, data + static_cast<size_t>(impulseLength_) * impulseChannels_);
+}
+
+void BatchRenderer::addVariation(const BatchVariation& variation) {
+    variations_.push_back(variation);
+}
+
+void BatchRenderer::clearVariations() {
+    variations_.clear();
+}
+
+int BatchRenderer::getNumVariations() const {
+    return static_cast<int>(variations_.size());
+}
+
+void BatchRenderer::setThreads(int count) {
+    pool_.start(std::max(0, count));
+    threads_ = pool_.getNumWorkers() - 1;
+}
+
+int BatchRenderer::getThreads() const {
+    return threads_;
+}
+
+double BatchRenderer::getVariationsPerSecond() const {
+    return variationsPerSecond_;
+}
+
+void BatchRenderer::render(float* output, int64_t numFrames) {
+    const int count = getNumVariations();
+    if (numFrames <= 0 || count == 0) return;
+
+    // Spectral grains read the sample's frame store, analysed once for all
+    if (!framesValid_ && sampleData_) {
+        for (const BatchVariation& variation : variations_) {
+            if (variation.params.grainMode == 1) {
+                spectralFrames_.analyze(sampleData_, sampleLength_);
+                framesValid_ = true;
+                break;
+            }
+        }
+    }
+
+    output_ = output;
+    renderFrames_ = numFrames;
+    const auto start = std::chrono::steady_clock::now();
+    for (firstTask_ = 0; firstTask_ < count; firstTask_ += WorkerPool::kMaxTasks) {
+        pool_.run(&BatchRenderer::renderTask, this,
+                  std::min(WorkerPool::kMaxTasks, count - firstTask_));
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    variationsPerSecond_ = seconds > 0.0 ? count / seconds : 0.0;
+}
+
+void BatchRenderer::renderTask(void* renderer, int task, int /*worker*/) {
+    BatchRenderer& self = *static_cast<BatchRenderer*>(renderer);
+    self.renderVariation(self.firstTask_ + task);
+}
+
+void BatchRenderer::renderVariation(int index) {
+    const BatchVariation& variation = variations_[index];
+    auto engine = std::make_unique<GrainEngine>();
+    engine->init(sampleRate_);
+    engine->setSeed(variation.seed);
+    engine->attachSample(sampleData_, sampleChannels_, sampleLength_,
+                         framesValid_ ? &spectralFrames_ : nullptr);
+    if (variation.params.reverbType == 1 && impulseLength_ > 0) {
+        float* dst = engine->allocateImpulseBuffer(impulseLength_, impulseChannels_);
+        std::copy(impulse_.begin(), impulse_.end(), dst);
+        engine->commitImpulseBuffer();
+    }
+    engine->updateParams(variation.params);
+    engine->start();
+
+    float* outputL = output_ + 2 * static_cast<int64_t>(index) * renderFrames_;
+    float* outputR = outputL + renderFrames_;
+    for (int64_t frame = 0; frame < renderFrames_; frame += SCHEDULE_BLOCK_SIZE) {
+        int n = static_cast<int>(std::min<int64_t>(SCHEDULE_BLOCK_SIZE, renderFrames_ - frame));
+        engine->process(outputL + frame, outputR + frame, n);
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "grain_engine.h"
+#include "spectral_granulator.h"
+#include "worker_pool.h"
+#include <memory>
+#include <vector>
+
+// One entry of a batch: a patch and the seed its random streams start from
+struct BatchVariation {
+    EngineParams params;
+    uint32_t seed = 12345;
+};
+
+// Offline render of many independent variations of a patch over one
+// source sample, for bulk sound-design generation.
+//
+// Each variation is a fresh GrainEngine (params at frame 0, transport
+// started, process() in SCHEDULE_BLOCK_SIZE blocks), so it renders the
+// same samples as it would alone. Variations are the pool's tasks: every
+// worker renders whole variations, all reading the caller's sample in
+// place and one shared spectral analysis. Engines are created per
+// variation (well under a millisecond, small next to any render) rather
+// than reset, so nothing leaks from one variation into the next.
+class BatchRenderer {
+public:
+    BatchRenderer();
+    ~BatchRenderer();
+
+    void init(float sampleRate);
+
+    // Source sample (mono data, read in place: it must outlive render())
+    void setSample(const float* data, int channels, int lengthInSamples);
+
+    // Convolution reverb IR (planar channels, copied), loaded only into
+    // variations with reverbType 1
+    void setImpulseResponse(const float* data, int lengthInSamples, int channels);
+
+    void addVariation(const BatchVariation& variation);
+    void clearVariations();
+    int getNumVariations() const;
+
+    // Render variations on `count` helper threads besides the caller (0 =
+    // one at a time on the caller). Starts threads; not real-time safe.
+    void setThreads(int count);
+    int getThreads() const;
+
+    // Render numFrames of every variation into `output`, planar: variation
+    // v's left channel at output + 2 * v * numFrames, its right channel
+    // right after it
+    void render(float* output, int64_t numFrames);
+
+    // Throughput of the last render()
+    double getVariationsPerSecond() const;
+
+private:
+    static void renderTask(void* renderer, int task, int worker);
+    void renderVariation(int index);
+
+    float sampleRate_ = 48000.0f;
+    const float* sampleData_ = nullptr;
+    int sampleChannels_ = 1;
+    int sampleLength_ = 0;
+    SpectralFrames spectralFrames_;   // Analysed when a variation uses spectral grains
+    bool framesValid_ = false;
+    std::vector<float> impulse_;
+    int impulseLength_ = 0;
+    int impulseChannels_ = 0;
+
+    std::vector<BatchVariation> variations_;
+    WorkerPool pool_;
+    int threads_ = 0;
+
+    // Current render
+    float* output_ = nullptr;
+    int64_t renderFrames_ = 0;
+    int firstTask_ = 0;               // Variation of task 0 in the current pool run
+    double variationsPerSecond_ = 0.0;
+};
@@ -1,5 +1,7 @@
 #include <emscripten/bind.h>
+#include "engine_prep.h"
 #include "grain_engine.h"
+#include "layer_host.h"
 
 using namespace emscripten;
 
@@ -27,12 +29,52 @@ EMSCRIPTEN_BINDINGS(grain_engine) {
         .field("volume", &EngineParams::volume)
         .field("filterFreq", &EngineParams::filterFreq)
         .field("filterRes", &EngineParams::filterRes)
+        .field("filterType", &EngineParams::filterType)
+        .field("grainFilterMode", &EngineParams::grainFilterMode)
+        .field("grainFilterFreq", &EngineParams::grainFilterFreq)
+        .field("grainFilterRes", &EngineParams::grainFilterRes)
+        .field("grainFilterSpread", &EngineParams::grainFilterSpread)
+        .field("grainMode", &EngineParams::grainMode)
+        .field("spectralFormant", &EngineParams::spectralFormant)
+        .field("spectralSmear", &EngineParams::spectralSmear)
+        .field("fxRouting", &EngineParams::fxRouting)
+        .field("sendDelay", &EngineParams::sendDelay)
+        .field("sendReverb", &EngineParams::sendReverb)
+        .field("sendSpread", &EngineParams::sendSpread)
         .field("distAmount", &EngineParams::distAmount)
+        .field("distOversample", &EngineParams::distOversample)
         .field("delayTime", &EngineParams::delayTime)
         .field("delayFeedback", &EngineParams::delayFeedback)
         .field("delayMix", &EngineParams::delayMix)
+        .field("delayDamping", &EngineParams::delayDamping)
         .field("reverbMix", &EngineParams::reverbMix)
         .field("reverbDecay", &EngineParams::reverbDecay)
+        .field("reverbDamping", &EngineParams::reverbDamping)
+        .field("reverbType", &EngineParams::reverbType)
+        .field("limiterMode", &EngineParams::limiterMode)
+        .field("limiterCeiling", &EngineParams::limiterCeiling)
+        .field("limiterRelease", &EngineParams::limiterRelease)
+        .field("noteAttack", &EngineParams::noteAttack)
+        .field("noteDecay", &EngineParams::noteDecay)
+        .field("noteSustain", &EngineParams::noteSustain)
+        .field("noteRelease", &EngineParams::noteRelease)
+        ;
+
+    value_object<ConvolverCost>("ConvolverCost")
+        .field("partitions", &ConvolverCost::partitions)
+        .field("latencyFrames", &ConvolverCost::latencyFrames)
+        .field("flopsPerBlock", &ConvolverCost::flopsPerBlock)
+        .field("mflops", &ConvolverCost::mflops)
+        .field("memoryBytes", &ConvolverCost::memoryBytes)
+        ;
+
+    value_object<EngineStats>("EngineStats")
+        .field("activeGrains", &EngineStats::activeGrains)
+        .field("gainReductionDb", &EngineStats::gainReductionDb)
+        .field("outputPeak", &EngineStats::outputPeak)
+        .field("limiterLatency", &EngineStats::limiterLatency)
+        .field("cpuLoad", &EngineStats::cpuLoad)
+        .field("grainCap", &EngineStats::grainCap)
         ;
 
     class_<GrainEngine>("GrainEngine")
@@ -43,7 +85,13 @@ EMSCRIPTEN_BINDINGS(grain_engine) {
         .function("updateParams", &GrainEngine::updateParams)
         .function("allocateSampleBuffer", &GrainEngine::allocateSampleBuffer, allow_raw_pointers())
         .function("commitSampleBuffer", &GrainEngine::commitSampleBuffer)
+        .function("allocateSpectralFrames", &GrainEngine::allocateSpectralFrames, allow_raw_pointers())
+        .function("getSpectralFramesSize", &GrainEngine::getSpectralFramesSize)
+        .function("commitSpectralFrames", &GrainEngine::commitSpectralFrames)
         .function("process", &GrainEngine::process, allow_raw_pointers())
+        .function("setMorphSnapshot", &GrainEngine::setMorphSnapshot)
+        .function("clearMorphSnapshots", &GrainEngine::clearMorphSnapshots)
+        .function("setMorphPosition", &GrainEngine::setMorphPosition)
         .function("setFrozen", &GrainEngine::setFrozen)
         .function("setDrift", &GrainEngine::setDrift)
         .function("getGrainEventCount", &GrainEngine::getGrainEventCount)
@@ -51,7 +99,87 @@ EMSCRIPTEN_BINDINGS(grain_engine) {
         .function("getGrainEventDuration", &GrainEngine::getGrainEventDuration)
         .function("getGrainEventPan", &GrainEngine::getGrainEventPan)
         .function("clearGrainEvents", &GrainEngine::clearGrainEvents)
+        .function("setSeed", &GrainEngine::setSeed)
+        .function("getSeed", &GrainEngine::getSeed)
+        .function("allocateImpulseBuffer", &GrainEngine::allocateImpulseBuffer, allow_raw_pointers())
+        .function("commitImpulseBuffer", &GrainEngine::commitImpulseBuffer)
+        .function("allocateImpulseSpectra", &GrainEngine::allocateImpulseSpectra, allow_raw_pointers())
+        .function("getImpulseSpectraSize", &GrainEngine::getImpulseSpectraSize)
+        .function("commitImpulseSpectra", &GrainEngine::commitImpulseSpectra)
+        .function("clearImpulseResponse", &GrainEngine::clearImpulseResponse)
+        .function("getImpulseCost", &GrainEngine::getImpulseCost)
         .function("getOutputBufferL", &GrainEngine::getOutputBufferL, allow_raw_pointers())
         .function("getOutputBufferR", &GrainEngine::getOutputBufferR, allow_raw_pointers())
+        .function("getAuxBufferL", &GrainEngine::getAuxBufferL, allow_raw_pointers())
+        .function("getAuxBufferR", &GrainEngine::getAuxBufferR, allow_raw_pointers())
+        .function("collectStats", &GrainEngine::collectStats)
+        .function("setRenderThreads", &GrainEngine::setRenderThreads)
+        .function("getRenderThreads", &GrainEngine::getRenderThreads)
+        .function("setGrainLimit", &GrainEngine::setGrainLimit)
+        .function("getGrainLimit", &GrainEngine::getGrainLimit)
+        .function("getGrainDemand", &GrainEngine::getGrainDemand)
+        .function("setCpuBudget", &GrainEngine::setCpuBudget)
+        .function("getCpuBudget", &GrainEngine::getCpuBudget)
+        .function("setTelemetryEnabled", &GrainEngine::setTelemetryEnabled)
+        .function("getTelemetryBuffer", &GrainEngine::getTelemetryBuffer)
+        .function("getTelemetrySize", &GrainEngine::getTelemetrySize)
+        .function("setMaxBlockSize", &GrainEngine::setMaxBlockSize)
+        .function("getMaxBlockSize", &GrainEngine::getMaxBlockSize)
+        .function("setPolyphonic", &GrainEngine::setPolyphonic)
+        .function("isPolyphonic", &GrainEngine::isPolyphonic)
+        .function("noteOn", &GrainEngine::noteOn)
+        .function("noteOff", &GrainEngine::noteOff)
+        .function("allNotesOff", &GrainEngine::allNotesOff)
+        .function("getActiveNoteCount", &GrainEngine::getActiveNoteCount)
+        .function("captureState", &GrainEngine::captureState)
+        .function("getStateBuffer", &GrainEngine::getStateBuffer)
+        .function("restoreStateBuffer", &GrainEngine::restoreStateBuffer)
+        .function("getStateSize", &GrainEngine::getStateSize)
+        ;
+
+    class_<EnginePrep>("EnginePrep")
+        .constructor<>()
+        .function("allocateInput", &EnginePrep::allocateInput, allow_raw_pointers())
+        .function("prepareImpulse", &EnginePrep::prepareImpulse)
+        .function("getImpulseSpectra", &EnginePrep::getImpulseSpectra)
+        .function("getImpulseSpectraSize", &EnginePrep::getImpulseSpectraSize)
+        .function("prepareSpectralFrames", &EnginePrep::prepareSpectralFrames)
+        .function("getSpectralFrames", &EnginePrep::getSpectralFrames)
+        .function("getSpectralFramesSize", &EnginePrep::getSpectralFramesSize)
+        .function("getAnalysisHop", &EnginePrep::getAnalysisHop)
+        .function("release", &EnginePrep::release)
+        ;
+
+    class_<LayerHost>("LayerHost")
+        .constructor<>()
+        .function("init", &LayerHost::init)
+        .function("setNumLayers", &LayerHost::setNumLayers)
+        .function("getNumLayers", &LayerHost::getNumLayers)
+        .function("getLayer", &LayerHost::getLayer, allow_raw_pointers())
+        .function("setLayerGain", &LayerHost::setLayerGain)
+        .function("setLayerSample", &LayerHost::setLayerSample)
+        .function("allocateSample", &LayerHost::allocateSample, allow_raw_pointers())
+        .function("commitSample", &LayerHost::commitSample)
+        .function("clearSample", &LayerHost::clearSample)
+        .function("allocateSampleFrames", &LayerHost::allocateSampleFrames, allow_raw_pointers())
+        .function("getSampleFramesSize", &LayerHost::getSampleFramesSize)
+        .function("commitSampleFrames", &LayerHost::commitSampleFrames)
+        .function("setLimiter", &LayerHost::setLimiter)
+        .function("setGrainBudget", &LayerHost::setGrainBudget)
+        .function("getGrainBudget", &LayerHost::getGrainBudget)
+        .function("getLayerGrainLimit", &LayerHost::getLayerGrainLimit)
+        .function("start", &LayerHost::start)
+        .function("stop", &LayerHost::stop)
+        .function("process", &LayerHost::process, allow_raw_pointers())
+        .function("setMaxBlockSize", &LayerHost::setMaxBlockSize)
+        .function("getMaxBlockSize", &LayerHost::getMaxBlockSize)
+        .function("getOutputBufferL", &LayerHost::getOutputBufferL, allow_raw_pointers())
+        .function("getOutputBufferR", &LayerHost::getOutputBufferR, allow_raw_pointers())
+        .function("getAuxBufferL", &LayerHost::getAuxBufferL, allow_raw_pointers())
+        .function("getAuxBufferR", &LayerHost::getAuxBufferR, allow_raw_pointers())
+        .function("collectStats", &LayerHost::collectStats)
+        .function("clearGrainEvents", &LayerHost::clearGrainEvents)
+        .function("setRenderThreads", &LayerHost::setRenderThreads)
+        .function("getRenderThreads", &LayerHost::getRenderThreads)
         ;
 }
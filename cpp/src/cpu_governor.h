@@ -0,0 +1,100 @@
+#pragma once
+
+#include "grain.h"
+#include <algorithm>
+
+#if defined(__EMSCRIPTEN__)
+#include <emscripten.h>
+#else
+#include <chrono>
+#endif
+
+// Keeps a render under a CPU budget by capping the grain count.
+//
+// The host reports each process() call's wall-clock cost. The load (cost
+// over the call's real-time duration) is smoothed, rising fast and
+// falling slowly. While it is over the budget the cap drops to 3/4 of the
+// grains sounding, at most once per CUT_INTERVAL_MS so each cut can show
+// before the next. Once the load has stayed under RECOVER_RATIO of the
+// budget for RECOVER_HOLD_MS the cap grows by a quarter, one step per
+// hold, back up to MAX_GRAINS. Between the two thresholds nothing moves.
+//
+// The cap only says how many grains may sound; the engine sheds the
+// excess (it fades the quietest out, spawns nothing until it is back
+// under, then drops spawns over the cap instead of stealing). A budget of
+// 0 turns the governor off.
+class CpuGovernor {
+public:
+    static constexpr int MIN_GRAINS = 4;
+    static constexpr float CUT_INTERVAL_MS = 20.0f;
+    static constexpr float RECOVER_RATIO = 0.75f;
+    static constexpr float RECOVER_HOLD_MS = 500.0f;
+
+    void init(float sampleRate) {
+        sampleRate_ = sampleRate;
+        reset();
+    }
+
+    void reset() {
+        load_ = 0.0f;
+        cap_ = MAX_GRAINS;
+        sinceCutMs_ = CUT_INTERVAL_MS;
+        calmMs_ = 0.0f;
+    }
+
+    // Fraction of each call's real-time duration the render may take
+    void setBudget(float fraction) {
+        budget_ = std::max(0.0f, std::min(1.0f, fraction));
+        if (budget_ == 0.0f) reset();
+    }
+
+    float getBudget() const { return budget_; }
+    bool isEnabled() const { return budget_ > 0.0f; }
+
+    // Feed one call's cost; returns the new grain cap
+    int update(double costMs, int numFrames, int activeGrains) {
+        const float blockMs = numFrames * 1000.0f / sampleRate_;
+        const float ratio = static_cast<float>(costMs) / blockMs;
+        load_ += (ratio > load_ ? 0.5f : 0.05f) * (ratio - load_);
+        sinceCutMs_ += blockMs;
+
+        if (load_ > budget_) {
+            calmMs_ = 0.0f;
+            if (sinceCutMs_ >= CUT_INTERVAL_MS) {
+                cap_ = std::max(MIN_GRAINS, std::min(cap_, activeGrains) * 3 / 4);
+                sinceCutMs_ = 0.0f;
+            }
+        } else if (load_ < budget_ * RECOVER_RATIO && cap_ < MAX_GRAINS) {
+            calmMs_ += blockMs;
+            if (calmMs_ >= RECOVER_HOLD_MS) {
+                cap_ = std::min(MAX_GRAINS, cap_ + std::max(2, cap_ / 4));
+                calmMs_ = 0.0f;
+            }
+        } else {
+            calmMs_ = 0.0f;
+        }
+        return cap_;
+    }
+
+    // Smoothed load (1 = a call took as long as it plays)
+    float getLoad() const { return load_; }
+    int getCap() const { return cap_; }
+
+    // Monotonic wall clock in milliseconds
+    static double nowMs() {
+#if defined(__EMSCRIPTEN__)
+        return emscripten_get_now();
+#else
+        using namespace std::chrono;
+        return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+private:
+    float sampleRate_ = 48000.0f;
+    float budget_ = 0.0f;
+    float load_ = 0.0f;
+    int cap_ = MAX_GRAINS;
+    float sinceCutMs_ = CUT_INTERVAL_MS;
+    float calmMs_ = 0.0f;
+};
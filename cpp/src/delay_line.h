@@ -0,0 +1,119 @@
+#pragma once
+
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Stereo feedback delay with fractional (4-point Hermite) reads.
+//
+// Frames are stored interleaved (L, R) in a power-of-two ring that is
+// written twice, at pos and pos + capacity, so the four frames an
+// interpolated read needs are always contiguous: one read is two vector
+// loads and one weighted sum for both channels. The ring is allocated in
+// init(); process() never allocates.
+//
+// Delay time, feedback and mix arrive as per-frame arrays so the caller can
+// smooth and modulate them (time changes glide like tape rather than step).
+class StereoDelay {
+public:
+    static constexpr int kMinDelayFrames = 2;   // Hermite needs one frame ahead
+
+    // Allocate the ring for delays up to maxDelaySeconds (not real-time safe)
+    void init(float sampleRate, float maxDelaySeconds) {
+        sampleRate_ = sampleRate;
+        int needed = static_cast<int>(std::ceil(maxDelaySeconds * sampleRate)) + 4;
+        capacity_ = 1;
+        while (capacity_ < needed) capacity_ <<= 1;
+        mask_ = capacity_ - 1;
+        buffer_.assign(static_cast<size_t>(capacity_) * 2 * 2, 0.0f);
+        reset();
+    }
+
+    void reset() {
+        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+        writePos_ = 0;
+        dampL_ = dampR_ = 0.0f;
+    }
+
+    // Longest delay process() honours, in frames
+    float getMaxDelayFrames() const { return static_cast<float>(capacity_ - 4); }
+
+    // One-pole lowpass in the feedback path: 0 = off, 1 = 200 Hz
+    void setDamping(float amount) {
+        amount = std::max(0.0f, std::min(1.0f, amount));
+        if (amount <= 0.0f) {
+            dampCoeff_ = 1.0f;
+            return;
+        }
+        // 20 kHz down to 200 Hz, exponentially
+        float cutoff = 20000.0f * std::exp2(-6.643856f * amount);
+        dampCoeff_ = 1.0f - std::exp(-2.0f * static_cast<float>(M_PI) * cutoff / sampleRate_);
+    }
+
+    // Process a block in place. delayFrames is clamped to
+    // [kMinDelayFrames, getMaxDelayFrames()]; feedback should stay below 1.
+    void process(float* left, float* right, const float* delayFrames,
+                 const float* feedback, const float* mix, int numFrames) {
+        using namespace simd;
+        const float maxDelay = getMaxDelayFrames();
+        float* buf = buffer_.data();
+        const int stride = capacity_ * 2;   // Offset of the mirror copy, in floats
+
+        for (int i = 0; i < numFrames; ++i) {
+            float d = std::max(static_cast<float>(kMinDelayFrames), std::min(delayFrames[i], maxDelay));
+            int di = static_cast<int>(d);
+            float t = 1.0f - (d - static_cast<float>(di));
+
+            // Frames x[-1], x[0], x[1], x[2] with the read point t between x[0] and x[1]
+            int start = (writePos_ - di - 2) & mask_;
+            const float* p = buf + start * 2;
+            f32x4 lo = load(p);       // xm1L xm1R x0L x0R
+            f32x4 hi = load(p + 4);   // x1L  x1R  x2L x2R
+
+            float wm1 = ((-0.5f * t + 1.0f) * t - 0.5f) * t;
+            float w0 = (1.5f * t - 2.5f) * t * t + 1.0f;
+            float w1 = ((-1.5f * t + 2.0f) * t + 0.5f) * t;
+            float w2 = (0.5f * t - 0.5f) * t * t;
+            f32x4 sum = lo * set(wm1, wm1, w0, w0) + hi * set(w1, w1, w2, w2);
+            float wetL = lane<0>(sum) + lane<2>(sum);
+            float wetR = lane<1>(sum) + lane<3>(sum);
+
+            // Damp the recirculating signal only, so the first echo stays bright
+            dampL_ += (wetL - dampL_) * dampCoeff_;
+            dampR_ += (wetR - dampR_) * dampCoeff_;
+
+            float inL = left[i];
+            float inR = right[i];
+            float fb = feedback[i];
+            float writeL = inL + fb * dampL_;
+            float writeR = inR + fb * dampR_;
+            float* w = buf + writePos_ * 2;
+            w[0] = w[stride] = writeL;
+            w[1] = w[stride + 1] = writeR;
+            writePos_ = (writePos_ + 1) & mask_;
+
+            float m = mix[i];
+            left[i] = inL + (wetL - inL) * m;
+            right[i] = inR + (wetR - inR) * m;
+        }
+
+        // Flush denormals from the damping state once the tail has died out
+        if (std::fabs(dampL_) < 1e-15f) dampL_ = 0.0f;
+        if (std::fabs(dampR_) < 1e-15f) dampR_ = 0.0f;
+    }
+
+private:
+    std::vector<float> buffer_;   // 2 * capacity frames (ring + mirror), interleaved
+    int capacity_ = 1;
+    int mask_ = 0;
+    int writePos_ = 0;
+    float sampleRate_ = 48000.0f;
+    float dampCoeff_ = 1.0f;
+    float dampL_ = 0.0f;
+    float dampR_ = 0.0f;
+};
@@ -0,0 +1,247 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Polyphase halfband FIR for 2x up/downsampling.
+//
+// Only the odd taps of a halfband filter are non-zero (plus the 0.5 centre
+// tap), so each stage costs SideTaps multiply-adds per output pair.
+// Coefficients are a Kaiser-windowed sinc computed at construction; more
+// taps narrow the transition band around a quarter of the 2x rate.
+template <int SideTaps>
+class HalfbandFilter {
+public:
+    static constexpr int kSideTaps = SideTaps;          // Non-zero odd taps per side
+    static constexpr int kLatency = 2 * kSideTaps - 1;  // In 2x-rate samples
+
+    HalfbandFilter() {
+        constexpr double beta = 8.0;
+        constexpr double halfLength = 2.0 * kSideTaps;
+        double sum = 0.0;
+        for (int j = 0; j < kSideTaps; ++j) {
+            double n = 2.0 * j + 1.0;
+            double sinc = std::sin(M_PI * n * 0.5) / (M_PI * n);
+            double r = n / halfLength;
+            double window = besselI0(beta * std::sqrt(1.0 - r * r)) / besselI0(beta);
+            coeffs_[j] = sinc * window;
+            sum += coeffs_[j];
+        }
+        // Normalize for unity DC gain: 0.5 + 2 * sum(coeffs) = 1
+        for (int j = 0; j < kSideTaps; ++j) {
+            coeffs_[j] = static_cast<float>(coeffs_[j] * 0.25 / sum);
+        }
+        reset();
+    }
+
+    void reset() {
+        std::memset(upHistory_, 0, sizeof(upHistory_));
+        std::memset(downHistory_, 0, sizeof(downHistory_));
+        upPos_ = 0;
+        downPos_ = 0;
+    }
+
+    // One input sample -> two output samples at twice the rate
+    void upsample(float x, float& out0, float& out1) {
+        // Double-written ring so the last kUpLen samples are always contiguous
+        upHistory_[upPos_] = x;
+        upHistory_[upPos_ + kUpLen] = x;
+        upPos_ = (upPos_ + 1) % kUpLen;
+        const float* h = upHistory_ + upPos_;   // h[kUpLen - 1] is the newest
+
+        // Centre of the window is x[m - kSideTaps]
+        float odd = 0.0f;
+        for (int j = 0; j < kSideTaps; ++j) {
+            odd += coeffs_[j] * (h[kSideTaps - 1 - j] + h[kSideTaps + j]);
+        }
+        out0 = h[kSideTaps - 1];
+        out1 = 2.0f * odd;
+    }
+
+    // Two input samples at the high rate -> one output sample
+    float downsample(float x0, float x1) {
+        downHistory_[downPos_] = x0;
+        downHistory_[downPos_ + kDownLen] = x0;
+        downHistory_[downPos_ + 1] = x1;
+        downHistory_[downPos_ + 1 + kDownLen] = x1;
+        downPos_ = (downPos_ + 2) % kDownLen;
+        const float* h = downHistory_ + downPos_;   // h[kDownLen - 1] is the newest
+
+        // Centre tap sits kLatency samples before the newest sample
+        const int centre = kDownLen - 1 - kLatency;
+        float acc = 0.5f * h[centre];
+        for (int j = 0; j < kSideTaps; ++j) {
+            int d = 2 * j + 1;
+            acc += coeffs_[j] * (h[centre - d] + h[centre + d]);
+        }
+        return acc;
+    }
+
+private:
+    static constexpr int kUpLen = 2 * kSideTaps;
+    static constexpr int kDownLen = 4 * kSideTaps;   // Even, >= 2 * kLatency + 1
+
+    static double besselI0(double x) {
+        double sum = 1.0, term = 1.0;
+        for (int k = 1; k < 32; ++k) {
+            double t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+        }
+        return sum;
+    }
+
+    float coeffs_[kSideTaps];
+    float upHistory_[2 * kUpLen];
+    float downHistory_[2 * kDownLen];
+    int upPos_ = 0;
+    int downPos_ = 0;
+};
+
+// Stereo waveshaping distortion with first-order antiderivative
+// anti-aliasing (ADAA) and optional 2x/4x halfband oversampling.
+//
+// The curve is the JS engine's WaveShaper curve,
+// (3 + k) * x * (pi / 9) / (pi + k|x|) with k = amount * 100, times a 3x
+// makeup gain: f(x) = (3 + k) * x * (pi / 3) / (pi + k|x|), input clamped to
+// [-1, 1]. Its slope at 0 is 1 + k / 3, so the stage is unity-gain as the
+// drive goes to 0 (matching the bypass it fades in from). The peak,
+// f(1) = (3 + k) * pi / (3 * (pi + k)), stays under pi / 3 (about 1.046 at
+// amount 1); the master limiter, when on, catches the overshoot.
+class Distortion {
+public:
+    static constexpr int kMaxChunk = 128;
+
+    void reset() {
+        for (int c = 0; c < 2; ++c) {
+            stage1_[c].reset();
+            stage2_[c].reset();
+            prevX_[c] = 0.0;
+            prevF_[c] = 0.0;
+            prevK_[c] = -1.0;
+        }
+    }
+
+    // 1, 2 or 4
+    void setOversampling(int factor) {
+        int f = factor >= 4 ? 4 : (factor >= 2 ? 2 : 1);
+        if (f != oversampling_) {
+            oversampling_ = f;
+            reset();
+        }
+    }
+
+    int getOversampling() const { return oversampling_; }
+
+    // Distort a block in place; drive[i] is the (smoothed) amount 0..1 per frame
+    void process(float* left, float* right, const float* drive, int numFrames) {
+        float* channels[2] = { left, right };
+        for (int offset = 0; offset < numFrames; offset += kMaxChunk) {
+            int n = std::min(kMaxChunk, numFrames - offset);
+            for (int c = 0; c < 2; ++c) {
+                processChannel(c, channels[c] + offset, drive + offset, n);
+            }
+        }
+    }
+
+private:
+    void processChannel(int c, float* x, const float* drive, int n) {
+        if (oversampling_ == 1) {
+            for (int i = 0; i < n; ++i) x[i] = shape(c, x[i], drive[i]);
+            return;
+        }
+
+        // Upsample into scratch
+        int factor = oversampling_;
+        auto& stage1 = stage1_[c];
+        auto& stage2 = stage2_[c];
+        for (int i = 0; i < n; ++i) {
+            float a, b;
+            stage1.upsample(x[i], a, b);
+            if (factor == 2) {
+                scratch_[2 * i] = a;
+                scratch_[2 * i + 1] = b;
+            } else {
+                stage2.upsample(a, scratch_[4 * i], scratch_[4 * i + 1]);
+                stage2.upsample(b, scratch_[4 * i + 2], scratch_[4 * i + 3]);
+            }
+        }
+
+        // Nonlinearity at the high rate (drive held per base-rate frame)
+        for (int i = 0; i < n; ++i) {
+            for (int p = 0; p < factor; ++p) {
+                float& s = scratch_[i * factor + p];
+                s = shape(c, s, drive[i]);
+            }
+        }
+
+        // Downsample back (stages run in reverse order)
+        for (int i = 0; i < n; ++i) {
+            if (factor == 2) {
+                x[i] = stage1.downsample(scratch_[2 * i], scratch_[2 * i + 1]);
+            } else {
+                float a = stage2.downsample(scratch_[4 * i], scratch_[4 * i + 1]);
+                float b = stage2.downsample(scratch_[4 * i + 2], scratch_[4 * i + 3]);
+                x[i] = stage1.downsample(a, b);
+            }
+        }
+    }
+
+    // First-order ADAA: (F(x) - F(x_prev)) / (x - x_prev)
+    float shape(int c, float xf, float amount) {
+        double k = static_cast<double>(amount) * 100.0;
+        double x = xf;
+        if (k != prevK_[c]) {
+            // Drive changed: both antiderivative values must use the same curve
+            prevK_[c] = k;
+            prevF_[c] = antiderivative(prevX_[c], k);
+        }
+
+        double fx = antiderivative(x, k);
+        double dx = x - prevX_[c];
+        double y = (std::fabs(dx) > 1e-5)
+            ? (fx - prevF_[c]) / dx
+            : curve(0.5 * (x + prevX_[c]), k);
+        prevX_[c] = x;
+        prevF_[c] = fx;
+        return static_cast<float>(y);
+    }
+
+    static double curve(double x, double k) {
+        x = std::max(-1.0, std::min(1.0, x));
+        double c = (3.0 + k) * M_PI / 3.0;
+        return c * x / (M_PI + k * std::fabs(x));
+    }
+
+    // Antiderivative of curve() (even function, F(0) = 0)
+    static double antiderivative(double x, double k) {
+        double ax = std::fabs(x);
+        double u = std::min(ax, 1.0);
+        double c = (3.0 + k) * M_PI / 3.0;
+        double f;
+        if (k < 1e-2) {
+            // Series form avoids cancellation at tiny drive
+            f = c * (u * u / (2.0 * M_PI) - k * u * u * u / (3.0 * M_PI * M_PI));
+        } else {
+            f = (c / k) * (u - (M_PI / k) * std::log1p(k * u / M_PI));
+        }
+        // Past the clamp the curve is flat, so F grows linearly
+        if (ax > 1.0) f += curve(1.0, k) * (ax - 1.0);
+        return f;
+    }
+
+    int oversampling_ = 4;
+    // Stage 1 (base <-> 2x) must stop everything above the base Nyquist, so
+    // it is long; stage 2 (2x <-> 4x) only guards content stage 1 removes
+    HalfbandFilter<16> stage1_[2];
+    HalfbandFilter<6> stage2_[2];
+    double prevX_[2] = { 0.0, 0.0 };
+    double prevF_[2] = { 0.0, 0.0 };
+    double prevK_[2] = { -1.0, -1.0 };
+    float scratch_[kMaxChunk * 4];
+};
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+// Parameters mirroring GranularParams from types.ts
+// Only the subset relevant to the grain engine (Phase 1)
+struct EngineParams {
+    // Grain
+    float grainSize = 0.3f;        // seconds (0.01 - 0.5)
+    float density = 0.15f;         // seconds between grains (0.005 - 0.5)
+    float spread = 0.0f;           // position offset (0 - 2)
+    float position = 0.0f;         // normalized playhead (0 - 1)
+    float grainReversalChance = 0.0f; // (0 - 1)
+
+    // Stereo
+    float pan = 0.0f;              // (-1 to 1)
+    float panSpread = 0.0f;        // (0 to 1)
+
+    // Pitch & FM
+    float pitch = 0.0f;            // semitones (-24 to +24)
+    float detune = 0.0f;           // cents (0 - 100)
+    float fmFreq = 0.0f;           // Hz
+    float fmAmount = 0.0f;         // (0 - 100)
+
+    // Envelope
+    float attack = 0.5f;           // ratio of grain size (0 - 1)
+    float release = 0.5f;          // ratio of grain size (0 - 1)
+    int envelopeCurve = 0;         // 0=linear, 1=exponential
+
+    // LFO
+    float lfoRate = 1.0f;          // Hz (0.1 - 20)
+    float lfoAmount = 0.0f;        // depth (0 - 1)
+    int lfoShape = 0;              // 0=sine, 1=triangle, 2=square, 3=sawtooth
+
+    // LFO targets (bitfield for efficiency)
+    // Bit positions match the order in MOD_SCALES
+    uint32_t lfoTargetMask = 0;
+
+    // Volume (last stage of the engine FX chain)
+    float volume = 0.8f;
+
+    // Filter (stereo SVF after grain summation; LFO_FILTER_* modulate it)
+    float filterFreq = 20000.0f;   // Hz (20 - 20000)
+    float filterRes = 0.0f;        // resonance like BiquadFilterNode.Q: dB for LP/HP, linear Q for BP/notch (0 - 20)
+    int filterType = 0;            // 0=lowpass, 1=bandpass, 2=highpass, 3=notch
+
+    // Per-grain filter (optional; each grain gets its own randomized SVF)
+    int grainFilterMode = 0;       // 0=off, 1=lowpass, 2=bandpass, 3=highpass, 4=notch
+    float grainFilterFreq = 2000.0f; // centre cutoff Hz (20 - 20000)
+    float grainFilterRes = 0.0f;   // centre resonance, read like filterRes (0 - 20)
+    float grainFilterSpread = 0.0f; // randomization (0 - 1): up to +-4 octaves, +-10 resonance
+
+    // Grain synthesis mode (spectral grains ignore the per-grain filter)
+    int grainMode = 0;             // 0=time-domain, 1=spectral (phase vocoder)
+    float spectralFormant = 1.0f;  // spectral formant preservation when pitched (0 - 1)
+    float spectralSmear = 0.0f;    // spectral phase randomization per hop (0 - 1)
+
+    // FX params (distortion -> delay -> reverb, all run in the engine)
+    int fxRouting = 0;             // 0=insert chain, 1=aux sends (engine returns),
+                                   // 2=aux sends as separate outputs (host returns)
+    float sendDelay = 0.0f;        // per-grain delay send level (0 - 1)
+    float sendReverb = 0.0f;       // per-grain reverb send level (0 - 1)
+    float sendSpread = 0.0f;       // per-grain send randomization (0 - 1)
+    float distAmount = 0.0f;       // drive (0 - 1); 0 bypasses the stage
+    int distOversample = 4;        // 1, 2 or 4 (halfband oversampling factor)
+    float delayTime = 0.3f;        // seconds (0 - 1)
+    float delayFeedback = 0.3f;    // (0 - 0.95)
+    float delayMix = 0.0f;         // wet mix (0 - 1); 0 bypasses the stage
+    float delayDamping = 0.0f;     // feedback lowpass (0 = off, 1 = 200 Hz)
+    float reverbMix = 0.0f;        // wet mix (0 - 1); 0 bypasses the stage
+    float reverbDecay = 2.0f;      // T60 in seconds (0.1 - 4)
+    float reverbDamping = 0.3f;    // in-loop lowpass (0 = off, 1 = 200 Hz)
+    int reverbType = 0;            // 0=FDN, 1=convolution with the loaded IR (FDN if none)
+    int limiterMode = 1;           // 0=off, 1=lookahead true-peak limiter, 2=soft clip
+    float limiterCeiling = -1.0f;  // output ceiling in dBFS (-24 - 0)
+    float limiterRelease = 0.1f;   // limiter release in seconds (0.01 - 1)
+
+    // Note amplitude envelope (polyphonic mode), shared by every note
+    float noteAttack = 0.01f;      // seconds (0 - 10)
+    float noteDecay = 0.1f;        // seconds (0 - 10)
+    float noteSustain = 1.0f;      // level (0 - 1)
+    float noteRelease = 0.3f;      // seconds (0 - 10)
+};
+
+// Per-field dirty bits, one per EngineParams field in declaration order.
+// Every field is a 4-byte scalar, so field i is 32-bit word i of the struct.
+enum ParamField : uint64_t {
+    PARAM_GRAIN_SIZE           = 1ull << 0,
+    PARAM_DENSITY              = 1ull << 1,
+    PARAM_SPREAD               = 1ull << 2,
+    PARAM_POSITION             = 1ull << 3,
+    PARAM_REVERSAL_CHANCE      = 1ull << 4,
+    PARAM_PAN                  = 1ull << 5,
+    PARAM_PAN_SPREAD           = 1ull << 6,
+    PARAM_PITCH                = 1ull << 7,
+    PARAM_DETUNE               = 1ull << 8,
+    PARAM_FM_FREQ              = 1ull << 9,
+    PARAM_FM_AMOUNT            = 1ull << 10,
+    PARAM_ATTACK               = 1ull << 11,
+    PARAM_RELEASE              = 1ull << 12,
+    PARAM_ENVELOPE_CURVE       = 1ull << 13,
+    PARAM_LFO_RATE             = 1ull << 14,
+    PARAM_LFO_AMOUNT           = 1ull << 15,
+    PARAM_LFO_SHAPE            = 1ull << 16,
+    PARAM_LFO_TARGET_MASK      = 1ull << 17,
+    PARAM_VOLUME               = 1ull << 18,
+    PARAM_FILTER_FREQ          = 1ull << 19,
+    PARAM_FILTER_RES           = 1ull << 20,
+    PARAM_FILTER_TYPE          = 1ull << 21,
+    PARAM_GRAIN_FILTER_MODE    = 1ull << 22,
+    PARAM_GRAIN_FILTER_FREQ    = 1ull << 23,
+    PARAM_GRAIN_FILTER_RES     = 1ull << 24,
+    PARAM_GRAIN_FILTER_SPREAD  = 1ull << 25,
+    PARAM_GRAIN_MODE           = 1ull << 26,
+    PARAM_SPECTRAL_FORMANT     = 1ull << 27,
+    PARAM_SPECTRAL_SMEAR       = 1ull << 28,
+    PARAM_FX_ROUTING           = 1ull << 29,
+    PARAM_SEND_DELAY           = 1ull << 30,
+    PARAM_SEND_REVERB          = 1ull << 31,
+    PARAM_SEND_SPREAD          = 1ull << 32,
+    PARAM_DIST_AMOUNT          = 1ull << 33,
+    PARAM_DIST_OVERSAMPLE      = 1ull << 34,
+    PARAM_DELAY_TIME           = 1ull << 35,
+    PARAM_DELAY_FEEDBACK       = 1ull << 36,
+    PARAM_DELAY_MIX            = 1ull << 37,
+    PARAM_DELAY_DAMPING        = 1ull << 38,
+    PARAM_REVERB_MIX           = 1ull << 39,
+    PARAM_REVERB_DECAY         = 1ull << 40,
+    PARAM_REVERB_DAMPING       = 1ull << 41,
+    PARAM_REVERB_TYPE          = 1ull << 42,
+    PARAM_LIMITER_MODE         = 1ull << 43,
+    PARAM_LIMITER_CEILING      = 1ull << 44,
+    PARAM_LIMITER_RELEASE      = 1ull << 45,
+    PARAM_NOTE_ATTACK          = 1ull << 46,
+    PARAM_NOTE_DECAY           = 1ull << 47,
+    PARAM_NOTE_SUSTAIN         = 1ull << 48,
+    PARAM_NOTE_RELEASE         = 1ull << 49,
+};
+
+static constexpr int NUM_PARAM_FIELDS = 50;
+static constexpr uint64_t PARAM_ALL = (1ull << NUM_PARAM_FIELDS) - 1;
+
+static_assert(sizeof(EngineParams) == NUM_PARAM_FIELDS * sizeof(uint32_t),
+              "EngineParams fields must stay 4-byte scalars; update ParamField");
+
+// Bitmask of fields that differ between two parameter sets
+inline uint64_t diffParams(const EngineParams& a, const EngineParams& b) {
+    uint32_t wa[NUM_PARAM_FIELDS];
+    uint32_t wb[NUM_PARAM_FIELDS];
+    std::memcpy(wa, &a, sizeof(wa));
+    std::memcpy(wb, &b, sizeof(wb));
+
+    uint64_t dirty = 0;
+    for (int i = 0; i < NUM_PARAM_FIELDS; ++i) {
+        if (wa[i] != wb[i]) dirty |= 1ull << i;
+    }
+    return dirty;
+}
+
+// LFO target bit positions
+enum LfoTarget : uint32_t {
+    LFO_GRAIN_SIZE     = 1 << 0,
+    LFO_DENSITY        = 1 << 1,
+    LFO_SPREAD         = 1 << 2,
+    LFO_POSITION       = 1 << 3,
+    LFO_PITCH          = 1 << 4,
+    LFO_FM_FREQ        = 1 << 5,
+    LFO_FM_AMOUNT      = 1 << 6,
+    LFO_FILTER_FREQ    = 1 << 7,
+    LFO_FILTER_RES     = 1 << 8,
+    LFO_ATTACK         = 1 << 9,
+    LFO_RELEASE        = 1 << 10,
+    LFO_DIST_AMOUNT    = 1 << 11,
+    LFO_DELAY_MIX      = 1 << 12,
+    LFO_DELAY_TIME     = 1 << 13,
+    LFO_DELAY_FEEDBACK = 1 << 14,
+    LFO_PAN            = 1 << 15,
+    LFO_PAN_SPREAD     = 1 << 16,
+};
+
+// Modulation scales (matching MOD_SCALES in App.tsx)
+struct ModScales {
+    static constexpr float grainSize   = 0.2f;
+    static constexpr float density     = 0.1f;
+    static constexpr float spread      = 1.0f;
+    static constexpr float position    = 0.5f;
+    static constexpr float pitch       = 24.0f;
+    static constexpr float fmFreq      = 200.0f;
+    static constexpr float fmAmount    = 50.0f;
+    static constexpr float filterFreq  = 5000.0f;
+    static constexpr float filterRes   = 10.0f;
+    static constexpr float attack      = 0.5f;
+    static constexpr float release     = 0.5f;
+    static constexpr float distAmount  = 0.5f;
+    static constexpr float delayMix    = 0.5f;
+    static constexpr float delayTime   = 0.5f;
+    static constexpr float delayFeedback = 0.5f;
+    static constexpr float pan         = 1.0f;
+    static constexpr float panSpread   = 1.0f;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "fft.h"
+#include "partitioned_convolver.h"
+#include "spectral_granulator.h"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Preparation work the engines must not do on the audio thread, for a
+// helper with its own WASM instance (the web build's prep worker). The
+// caller writes input into the staging buffer, runs a prepare call, then
+// copies the result out of this object's heap and transfers it to the
+// engines, which only copy it in.
+class EnginePrep {
+public:
+    EnginePrep() : fft_(PartitionedConvolver::kFftSize) {}
+
+    // Staging buffer for the next prepare call's input
+    float* allocateInput(int floats) {
+        input_.assign(std::max(1, floats), 0.0f);
+        return input_.data();
+    }
+
+    // Convolution IR spectra (PartitionedConvolver layout) of the planar IR
+    // in the staging buffer; returns the partition count, 0 if the input
+    // does not hold `channels` x `length` floats
+    int prepareImpulse(int channels, int length) {
+        channels = std::max(1, std::min(2, channels));
+        if (length < 1 || input_.size() < static_cast<size_t>(channels) * length) {
+            spectra_.clear();
+            return 0;
+        }
+        const int partitions = PartitionedConvolver::partitionsFor(length);
+        spectra_.assign(PartitionedConvolver::spectraSize(channels, partitions), 0.0f);
+        const float* planar[2] = { input_.data(), input_.data() + (channels > 1 ? length : 0) };
+        PartitionedConvolver::transform(fft_, planar, channels, length, spectra_.data());
+        return partitions;
+    }
+
+    uintptr_t getImpulseSpectra() const { return reinterpret_cast<uintptr_t>(spectra_.data()); }
+    int getImpulseSpectraSize() const { return static_cast<int>(spectra_.size()); }
+
+    // STFT frame store (SpectralFrames layout) of the mono sample of
+    // `length` floats in the staging buffer; returns the frame count, 0 if
+    // the input is shorter
+    int prepareSpectralFrames(int length) {
+        if (length < 1 || input_.size() < static_cast<size_t>(length)) {
+            frames_.clear();
+            return 0;
+        }
+        frames_.analyze(input_.data(), length);
+        return frames_.numFrames;
+    }
+
+    uintptr_t getSpectralFrames() const { return reinterpret_cast<uintptr_t>(frames_.data.data()); }
+    int getSpectralFramesSize() const { return static_cast<int>(frames_.data.size()); }
+    int getAnalysisHop() const { return frames_.analysisHop; }
+
+    // Free the input and results once they have been copied out
+    void release() {
+        input_ = std::vector<float>();
+        spectra_ = std::vector<float>();
+        frames_.clear();
+    }
+
+private:
+    RealFft fft_;
+    std::vector<float> input_;
+    std::vector<float> spectra_;
+    SpectralFrames frames_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "engine_params.h"
+#include "grain.h"
+#include "grain_filter.h"
+#include "note_voice.h"
+#include "param_smoother.h"
+#include "preset_morph.h"
+#include "rng.h"
+#include <cstdint>
+#include <type_traits>
+
+// Snapshot format. Bump the version whenever EngineSnapshot, or any type
+// stored in it, changes layout.
+static constexpr uint32_t ENGINE_SNAPSHOT_MAGIC = 0x5353474e;   // "NGSS"
+static constexpr uint32_t ENGINE_SNAPSHOT_VERSION = 3;
+
+struct EngineSnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;           // sizeof(EngineSnapshot) in the writing build
+    uint32_t maxGrains;      // MAX_GRAINS in the writing build
+    float sampleRate;
+    int32_t sampleLength;    // Length of the sample the grains were reading
+};
+
+// Everything the next blocks of a GrainEngine depend on besides the sample,
+// the convolution IR and the effect tails, as one plain block of memory:
+// copied with memcpy, written to disk or moved between WASM modules built
+// from the same sources. Filled by GrainEngine::saveState().
+struct EngineSnapshot {
+    EngineSnapshotHeader header;
+
+    // Transport and timing (the LFO phase follows currentTime)
+    bool playing;
+    double currentTime;
+    double nextGrainTime;
+
+    // Params as applied (after morphing), and the morph itself
+    EngineParams params;
+    PresetMorph morph;
+    ParamSmoother morphSmoother;
+    bool morphActive;
+    float appliedMorphPosition;
+
+    // Smoothed controls
+    ParamSmoother pitch;
+    ParamSmoother position;
+    ParamSmoother grainSize;
+    ParamSmoother pan;
+    ParamSmoother volume;
+    ParamSmoother filterFreq;
+    ParamSmoother filterRes;
+    ParamSmoother distAmount;
+    ParamSmoother delayTime;
+    ParamSmoother delayFeedback;
+    ParamSmoother delayMix;
+    ParamSmoother reverbMix;
+
+    // Freeze / drift
+    bool frozen;
+    float frozenPosition;
+    bool drifting;
+    float driftPosition;
+    float driftBasePosition;
+    float driftSpeed;
+    float driftReturnTendency;
+
+    // Random streams (seed and draw counters)
+    CounterRng rng;
+
+    // Grain pool, per-grain filters and note voices
+    int32_t grainLimit;
+    Grain grains[MAX_GRAINS];
+    GrainFilterBank grainFilters;
+    NoteVoice notes[MAX_NOTES];
+    bool polyphonic;
+    bool fadingGrains;
+    uint32_t noteCounter;
+};
+
+static_assert(std::is_trivially_copyable<EngineSnapshot>::value,
+              "EngineSnapshot must stay copyable with memcpy");
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Bins of the block-cost histogram, each 1/TELEMETRY_BINS_PER_BLOCK of a
+// call's real-time duration wide; the last bin also counts anything slower
+static constexpr int TELEMETRY_COST_BINS = 16;
+static constexpr int TELEMETRY_BINS_PER_BLOCK = 8;
+
+// Engine telemetry, rewritten at the end of every process() call while
+// enabled, for readers on other threads (or, mirrored into shared memory,
+// the main thread) that must not message or lock the audio thread.
+//
+// Seqlock: the engine makes `sequence` odd, writes the fields, then makes
+// it even again. A reader copies the block and keeps the copy if it saw
+// the same even sequence before and after. Every field is 4 bytes, in
+// declaration order, so JS can read the block with a DataView. Totals
+// count from the moment telemetry was enabled and wrap at 2^32.
+struct EngineTelemetry {
+    std::atomic<uint32_t> sequence;
+    uint32_t blocks;              // process() calls
+
+    // Grain pool after the last call
+    int32_t activeGrains;
+    int32_t grainCap;             // Limit, lowered by the CPU governor
+
+    // Totals: grains spawned, stolen by new ones, and ended
+    uint32_t spawns;
+    uint32_t steals;
+    uint32_t endsNatural;         // Envelope ran to its end
+    uint32_t endsBoundary;        // Read position left the sample
+    uint32_t endsFaded;           // Faded or cut: note ends, stop, CPU shedding
+
+    // Last call, in milliseconds of wall clock
+    float spawnMs;                // Scheduling and spawning
+    float renderMs;               // Grain layer
+    float fxMs;                   // Post-mix chain and sends
+    float blockLoad;              // Whole call over its real-time duration
+
+    // Last call's main output, left and right
+    float peak[2];
+    float rms[2];
+
+    // Calls by cost: bin k holds loads in [k, k + 1) / TELEMETRY_BINS_PER_BLOCK
+    uint32_t costHistogram[TELEMETRY_COST_BINS];
+};
+
+static_assert(sizeof(EngineTelemetry) == (17 + TELEMETRY_COST_BINS) * 4,
+              "EngineTelemetry must stay a packed block of 4-byte fields");
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Bounded-error replacements for the libm calls on the grain spawn path.
+//
+// Every kernel comes in two flavours: a scalar inline function and a batch
+// function that runs 4 lanes per instruction (see simd.h). exp2 and sin/cos
+// evaluate the same polynomial in both flavours.
+//
+// Error bounds (checked against double-precision libm):
+//   exp2(x)           relative error < 4e-7   for x in [-126, 126]
+//   sinTurns(t)       absolute error < 2e-7   for |t| < 2^22
+//   sin(x), cos(x)    as sinTurns, plus the float rounding of x / 2pi;
+//                     reduce large phases in double and call sinTurns instead
+//   equalPowerPan     absolute error < 5e-6   for pan in [-1, 1]
+namespace fastmath {
+
+namespace detail {
+
+// Taylor coefficients of 2^f around 0 (f in [-0.5, 0.5] after reduction)
+constexpr float kExp2C1 = 0.6931471805599453f;
+constexpr float kExp2C2 = 0.2402265069591007f;
+constexpr float kExp2C3 = 0.05550410866482158f;
+constexpr float kExp2C4 = 0.009618129107628477f;
+constexpr float kExp2C5 = 0.0013333558146428441f;
+constexpr float kExp2C6 = 0.00015403530393381606f;
+
+// Taylor coefficients of sin(2*pi*r) for r in turns, |r| <= 0.25
+constexpr float kSinC1 = 6.283185307179586f;
+constexpr float kSinC3 = -41.341702240399755f;
+constexpr float kSinC5 = 81.60524927607504f;
+constexpr float kSinC7 = -76.70585975306136f;
+constexpr float kSinC9 = 42.058693944897634f;
+constexpr float kSinC11 = -15.094642576822984f;
+
+constexpr float kInvTwoPi = static_cast<float>(1.0 / (2.0 * M_PI));
+
+inline float exp2Poly(float f) {
+    return 1.0f + f * (kExp2C1 + f * (kExp2C2 + f * (kExp2C3 +
+           f * (kExp2C4 + f * (kExp2C5 + f * kExp2C6)))));
+}
+
+inline simd::f32x4 exp2Poly(simd::f32x4 f) {
+    using namespace simd;
+    f32x4 p = splat(kExp2C6);
+    p = p * f + splat(kExp2C5);
+    p = p * f + splat(kExp2C4);
+    p = p * f + splat(kExp2C3);
+    p = p * f + splat(kExp2C2);
+    p = p * f + splat(kExp2C1);
+    return p * f + splat(1.0f);
+}
+
+inline float sinPoly(float r) {
+    float r2 = r * r;
+    return r * (kSinC1 + r2 * (kSinC3 + r2 * (kSinC5 + r2 * (kSinC7 +
+           r2 * (kSinC9 + r2 * kSinC11)))));
+}
+
+inline simd::f32x4 sinPoly(simd::f32x4 r) {
+    using namespace simd;
+    f32x4 r2 = r * r;
+    f32x4 p = splat(kSinC11);
+    p = p * r2 + splat(kSinC9);
+    p = p * r2 + splat(kSinC7);
+    p = p * r2 + splat(kSinC5);
+    p = p * r2 + splat(kSinC3);
+    p = p * r2 + splat(kSinC1);
+    return p * r;
+}
+
+inline float roundNearest(float x) {
+    return static_cast<float>(static_cast<int32_t>(x + (x >= 0.0f ? 0.5f : -0.5f)));
+}
+
+// Equal-power pan table: cos(theta) for theta in [0, pi/2], plus a guard entry
+static constexpr int kPanTableSize = 256;
+
+struct PanTable {
+    float gain[kPanTableSize + 2];
+
+    PanTable() {
+        for (int i = 0; i <= kPanTableSize; ++i) {
+            double theta = (static_cast<double>(i) / kPanTableSize) * 0.5 * M_PI;
+            gain[i] = static_cast<float>(std::cos(theta));
+        }
+        gain[kPanTableSize] = 0.0f;
+        gain[kPanTableSize + 1] = 0.0f;
+    }
+};
+
+inline const PanTable kPanTable;
+
+inline float panLookup(float u) {
+    int idx = static_cast<int>(u);
+    float frac = u - static_cast<float>(idx);
+    return kPanTable.gain[idx] + (kPanTable.gain[idx + 1] - kPanTable.gain[idx]) * frac;
+}
+
+} // namespace detail
+
+// --- Scalar kernels ---
+
+// 2^x
+inline float exp2(float x) {
+    x = std::max(-126.0f, std::min(126.0f, x));
+    float n = detail::roundNearest(x);
+    float p = detail::exp2Poly(x - n);
+    int32_t bits = (static_cast<int32_t>(n) + 127) << 23;
+    float scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale;
+}
+
+// sin(2 * pi * t), t in turns (cycles)
+inline float sinTurns(float t) {
+    float r = t - detail::roundNearest(t);        // [-0.5, 0.5]
+    if (r > 0.25f) r = 0.5f - r;                  // Fold onto [-0.25, 0.25]
+    else if (r < -0.25f) r = -0.5f - r;
+    return detail::sinPoly(r);
+}
+
+inline float sin(float x) { return sinTurns(x * detail::kInvTwoPi); }
+inline float cos(float x) { return sinTurns(x * detail::kInvTwoPi + 0.25f); }
+
+// Constant-power stereo pan law: pan -1..1 -> (cos, sin) of (pan + 1) * pi/4
+inline void equalPowerPan(float pan, float& gainL, float& gainR) {
+    pan = std::max(-1.0f, std::min(1.0f, pan));
+    float u = (pan + 1.0f) * 0.5f * static_cast<float>(detail::kPanTableSize);
+    gainL = detail::panLookup(u);
+    gainR = detail::panLookup(static_cast<float>(detail::kPanTableSize) - u);
+}
+
+// --- Vector kernels (4 lanes) ---
+
+inline simd::f32x4 exp2(simd::f32x4 x) {
+    using namespace simd;
+    x = max(splat(-126.0f), min(splat(126.0f), x));
+    i32x4 n = roundToInt(x);
+    f32x4 p = detail::exp2Poly(x - toFloat(n));
+    f32x4 scale = asFloat(shl(n + splatInt(127), 23));
+    return p * scale;
+}
+
+inline simd::f32x4 sinTurns(simd::f32x4 t) {
+    using namespace simd;
+    f32x4 r = t - toFloat(roundToInt(t));
+    f32x4 half = select(cmpLt(r, splat(0.0f)), splat(-0.5f), splat(0.5f));
+    f32x4 folded = half - r;
+    r = select(cmpGt(abs(r), splat(0.25f)), folded, r);
+    return detail::sinPoly(r);
+}
+
+inline simd::f32x4 sin(simd::f32x4 x) {
+    return sinTurns(x * simd::splat(detail::kInvTwoPi));
+}
+
+inline simd::f32x4 cos(simd::f32x4 x) {
+    return sinTurns(x * simd::splat(detail::kInvTwoPi) + simd::splat(0.25f));
+}
+
+// Vector pan law. WASM SIMD has no gather, so the vector path evaluates the
+// sine polynomial instead of reading the table (same error bound or better).
+inline void equalPowerPan(simd::f32x4 pan, simd::f32x4& gainL, simd::f32x4& gainR) {
+    using namespace simd;
+    pan = max(splat(-1.0f), min(splat(1.0f), pan));
+    f32x4 turns = (pan + splat(1.0f)) * splat(0.125f);
+    gainL = sinTurns(turns + splat(0.25f));
+    gainR = sinTurns(turns);
+}
+
+// --- Batch helpers over contiguous arrays (in-place allowed) ---
+
+inline void exp2(const float* x, float* out, int count) {
+    int i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        simd::store(out + i, exp2(simd::load(x + i)));
+    }
+    for (; i < count; ++i) out[i] = exp2(x[i]);
+}
+
+inline void sin(const float* x, float* out, int count) {
+    int i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        simd::store(out + i, sin(simd::load(x + i)));
+    }
+    for (; i < count; ++i) out[i] = sin(x[i]);
+}
+
+inline void equalPowerPan(const float* pan, float* gainL, float* gainR, int count) {
+    int i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        simd::f32x4 l, r;
+        equalPowerPan(simd::load(pan + i), l, r);
+        simd::store(gainL + i, l);
+        simd::store(gainR + i, r);
+    }
+    for (; i < count; ++i) equalPowerPan(pan[i], gainL[i], gainR[i]);
+}
+
+} // namespace fastmath
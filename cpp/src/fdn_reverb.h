@@ -0,0 +1,170 @@
+#pragma once
+
+#include "fast_math.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// 16-line feedback delay network reverb.
+//
+// The lines run four per vector (lines 4k..4k+3 in vector k). Line state is
+// stored frame-major, 16 floats per frame, so the write of all lines is four
+// contiguous vector stores; the reads are a per-line gather since every line
+// has its own length.
+//
+// Feedback matrix: a 4x4 Householder reflection inside each vector followed
+// by a 4-point Hadamard across the vectors. Both are orthogonal, so the
+// product is a dense 16x16 orthogonal matrix (every entry +-1/4) that costs
+// four lane sums and eight vector adds per frame.
+//
+// Decay and damping only change per-line gains and a one-pole coefficient,
+// so they can be swept live without touching the tail.
+class FdnReverb {
+public:
+    static constexpr int kLines = 16;
+    static constexpr int kVectors = kLines / simd::kLanes;
+
+    // Allocate the delay lines for this sample rate (not real-time safe)
+    void init(float sampleRate) {
+        using namespace simd;
+        sampleRate_ = sampleRate;
+
+        // Mutually prime lengths at 48 kHz, spread roughly exponentially
+        static constexpr int kBaseLengths[kLines] = {
+            727, 797, 877, 953, 1049, 1151, 1259, 1373,
+            1499, 1637, 1789, 1951, 2129, 2333, 2543, 2777,
+        };
+        int longest = 0;
+        for (int i = 0; i < kLines; ++i) {
+            // Interleave short and long lines across the vectors and channels
+            int src = (i % 2 == 0) ? i / 2 : kLines - 1 - i / 2;
+            length_[i] = std::max(1, static_cast<int>(kBaseLengths[src] * sampleRate / 48000.0f + 0.5f));
+            longest = std::max(longest, length_[i]);
+        }
+        int size = 1;
+        while (size <= longest) size <<= 1;
+        mask_ = size - 1;
+        buffer_.assign(static_cast<size_t>(size) * kLines, 0.0f);
+
+        reset();
+        setDecay(decaySeconds_);
+        setDamping(damping_);
+    }
+
+    void reset() {
+        std::fill(buffer_.begin(), buffer_.end(), 0.0f);
+        for (int k = 0; k < kVectors; ++k) lowpass_[k] = simd::splat(0.0f);
+        writePos_ = 0;
+    }
+
+    // Time for the tail to fall by 60 dB (low frequencies)
+    void setDecay(float seconds) {
+        using namespace simd;
+        decaySeconds_ = std::max(0.05f, seconds);
+
+        // g = 10^(-3 * length / (T60 * sr)) = 2^(-3 * log2(10) * length / (T60 * sr))
+        const f32x4 scale = splat(-9.965784f / (decaySeconds_ * sampleRate_));
+        alignas(16) float lengths[kLines];
+        for (int i = 0; i < kLines; ++i) lengths[i] = static_cast<float>(length_[i]);
+        float meanGainSq = 0.0f;
+        for (int k = 0; k < kVectors; ++k) {
+            gain_[k] = fastmath::exp2(load(lengths + k * kLanes) * scale);
+            meanGainSq += lane<0>(sumLanes(gain_[k] * gain_[k]));
+        }
+        meanGainSq /= kLines;
+
+        // A lossless loop with gain g has energy gain 1 / (1 - g^2); scale the
+        // wet signal by the inverse so loudness stays steady as decay moves
+        wetGain_ = std::sqrt(std::max(1e-6f, 1.0f - meanGainSq)) * kOutputTrim;
+    }
+
+    // One-pole lowpass inside every line: 0 = off, 1 = 200 Hz
+    void setDamping(float amount) {
+        damping_ = std::max(0.0f, std::min(1.0f, amount));
+        float coeff = 1.0f;
+        if (damping_ > 0.0f) {
+            float cutoff = 20000.0f * std::exp2(-6.643856f * damping_);
+            coeff = 1.0f - std::exp(-2.0f * static_cast<float>(M_PI) * cutoff / sampleRate_);
+        }
+        dampCoeff_ = simd::splat(coeff);
+    }
+
+    // Process a block in place; mix[i] is the per-frame wet amount (0..1)
+    void process(float* left, float* right, const float* mix, int numFrames) {
+        using namespace simd;
+        float* buf = buffer_.data();
+        const f32x4 half = splat(0.5f);
+        const f32x4 inGain = splat(0.5f);
+
+        for (int i = 0; i < numFrames; ++i) {
+            // Gather, damp and attenuate each line's output
+            f32x4 x[kVectors];
+            for (int k = 0; k < kVectors; ++k) {
+                const int* len = length_ + k * kLanes;
+                const int lane0 = k * kLanes;
+                f32x4 d = set(buf[((writePos_ - len[0]) & mask_) * kLines + lane0],
+                              buf[((writePos_ - len[1]) & mask_) * kLines + lane0 + 1],
+                              buf[((writePos_ - len[2]) & mask_) * kLines + lane0 + 2],
+                              buf[((writePos_ - len[3]) & mask_) * kLines + lane0 + 3]);
+                lowpass_[k] = lowpass_[k] + (d - lowpass_[k]) * dampCoeff_;
+                x[k] = lowpass_[k] * gain_[k];
+            }
+
+            // Even lanes feed the left output, odd lanes the right
+            f32x4 out = (x[0] - x[1]) + (x[2] - x[3]);
+            float wetL = (lane<0>(out) + lane<2>(out)) * wetGain_;
+            float wetR = (lane<1>(out) + lane<3>(out)) * wetGain_;
+
+            // Householder within each vector: v - 0.5 * sum(v)
+            for (int k = 0; k < kVectors; ++k) {
+                x[k] = x[k] - half * sumLanes(x[k]);
+            }
+            // Hadamard across vectors (scaled by 1/2 to stay orthogonal)
+            f32x4 a = x[0] + x[1], b = x[0] - x[1];
+            f32x4 c = x[2] + x[3], e = x[2] - x[3];
+            f32x4 m[kVectors] = { (a + c) * half, (b + e) * half,
+                                  (a - c) * half, (b - e) * half };
+
+            // Inject the input (left into even lanes, right into odd) and write
+            const float inL = left[i];
+            const float inR = right[i];
+            f32x4 in = set(inL, inR, inL, inR) * inGain;
+            float* w = buf + writePos_ * kLines;
+            store(w,                  m[0] + in);
+            store(w + kLanes,         m[1] - in);
+            store(w + 2 * kLanes,     m[2] + in);
+            store(w + 3 * kLanes,     m[3] - in);
+            writePos_ = (writePos_ + 1) & mask_;
+
+            float wet = mix[i];
+            left[i] = inL + (wetL - inL) * wet;
+            right[i] = inR + (wetR - inR) * wet;
+        }
+
+        // Flush denormals from the damping state once the tail has died out
+        for (int k = 0; k < kVectors; ++k) {
+            if (lane<0>(sumLanes(abs(lowpass_[k]))) < 1e-15f) lowpass_[k] = splat(0.0f);
+        }
+    }
+
+private:
+    // Brings the wet RMS to roughly the dry RMS for steady noise input
+    static constexpr float kOutputTrim = 2.0f;
+
+    std::vector<float> buffer_;   // size * kLines, frame-major
+    int length_[kLines] = {};
+    int mask_ = 0;
+    int writePos_ = 0;
+    float sampleRate_ = 48000.0f;
+    float decaySeconds_ = 2.0f;
+    float damping_ = 0.3f;
+    float wetGain_ = 0.0f;
+    simd::f32x4 gain_[kVectors];
+    simd::f32x4 lowpass_[kVectors];
+    simd::f32x4 dampCoeff_ = simd::splat(1.0f);
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cmath>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Real-input FFT of a fixed power-of-two size.
+//
+// A length-N real transform is computed as a length-N/2 complex radix-2 FFT
+// of the even/odd samples packed as re/im, followed by a split step. Spectra
+// are split arrays (re, im) of N/2 + 1 bins. forward() is unscaled and
+// inverse() scales by 1/N, so inverse(forward(x)) == x.
+//
+// Tables are built in the constructor; forward()/inverse() never allocate.
+class RealFft {
+public:
+    explicit RealFft(int size) : size_(size), half_(size / 2) {
+        int bits = 0;
+        while ((1 << bits) < half_) ++bits;
+        bitRev_.resize(half_);
+        for (int i = 0; i < half_; ++i) {
+            int r = 0;
+            for (int b = 0; b < bits; ++b) r |= ((i >> b) & 1) << (bits - 1 - b);
+            bitRev_[i] = r;
+        }
+        // Complex FFT twiddles e^(-2 pi i k / half) and split twiddles e^(-2 pi i k / size)
+        twRe_.resize(half_ / 2);
+        twIm_.resize(half_ / 2);
+        for (int k = 0; k < half_ / 2; ++k) {
+            twRe_[k] = static_cast<float>(std::cos(2.0 * M_PI * k / half_));
+            twIm_[k] = static_cast<float>(-std::sin(2.0 * M_PI * k / half_));
+        }
+        splitRe_.resize(half_ + 1);
+        splitIm_.resize(half_ + 1);
+        for (int k = 0; k <= half_; ++k) {
+            splitRe_[k] = static_cast<float>(std::cos(2.0 * M_PI * k / size_));
+            splitIm_[k] = static_cast<float>(-std::sin(2.0 * M_PI * k / size_));
+        }
+        workRe_.resize(half_);
+        workIm_.resize(half_);
+    }
+
+    int getSize() const { return size_; }
+    int getNumBins() const { return half_ + 1; }
+
+    // in: size samples -> re/im: size/2 + 1 bins
+    void forward(const float* in, float* re, float* im) {
+        float* zr = workRe_.data();
+        float* zi = workIm_.data();
+        for (int n = 0; n < half_; ++n) {
+            int r = bitRev_[n];
+            zr[r] = in[2 * n];
+            zi[r] = in[2 * n + 1];
+        }
+        butterflies(zr, zi, false);
+
+        // X[k] = E[k] + W^k O[k], with E/O recovered from Z[k] and conj(Z[M - k])
+        for (int k = 0; k <= half_; ++k) {
+            int a = k % half_;
+            int b = (half_ - k) % half_;
+            float er = 0.5f * (zr[a] + zr[b]);
+            float ei = 0.5f * (zi[a] - zi[b]);
+            float or_ = 0.5f * (zi[a] + zi[b]);
+            float oi = -0.5f * (zr[a] - zr[b]);
+            float wr = splitRe_[k], wi = splitIm_[k];
+            re[k] = er + wr * or_ - wi * oi;
+            im[k] = ei + wr * oi + wi * or_;
+        }
+    }
+
+    // re/im: size/2 + 1 bins -> out: size samples
+    void inverse(const float* re, const float* im, float* out) {
+        float* zr = workRe_.data();
+        float* zi = workIm_.data();
+        for (int k = 0; k < half_; ++k) {
+            // E = (X[k] + conj(X[M - k])) / 2, O = (X[k] - conj(X[M - k])) / (2 W^k)
+            int b = half_ - k;
+            float er = 0.5f * (re[k] + re[b]);
+            float ei = 0.5f * (im[k] - im[b]);
+            float dr = 0.5f * (re[k] - re[b]);
+            float di = 0.5f * (im[k] + im[b]);
+            float wr = splitRe_[k], wi = -splitIm_[k];   // 1 / W^k = conj(W^k)
+            float or_ = dr * wr - di * wi;
+            float oi = dr * wi + di * wr;
+            // Z = E + i O, stored bit-reversed for the in-place pass
+            int r = bitRev_[k];
+            zr[r] = er - oi;
+            zi[r] = ei + or_;
+        }
+        butterflies(zr, zi, true);
+
+        const float scale = 1.0f / half_;
+        for (int n = 0; n < half_; ++n) {
+            out[2 * n] = zr[n] * scale;
+            out[2 * n + 1] = zi[n] * scale;
+        }
+    }
+
+private:
+    // In-place iterative radix-2 on bit-reversed input
+    void butterflies(float* re, float* im, bool inverse) const {
+        const float sign = inverse ? -1.0f : 1.0f;
+        for (int len = 2; len <= half_; len <<= 1) {
+            int step = half_ / len;
+            int halfLen = len / 2;
+            for (int start = 0; start < half_; start += len) {
+                for (int j = 0; j < halfLen; ++j) {
+                    float wr = twRe_[j * step];
+                    float wi = sign * twIm_[j * step];
+                    int a = start + j;
+                    int b = a + halfLen;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+    }
+
+    int size_;
+    int half_;
+    std::vector<int> bitRev_;
+    std::vector<float> twRe_, twIm_;
+    std::vector<float> splitRe_, splitIm_;
+    std::vector<float> workRe_, workIm_;
+};
@@ -9,8 +9,11 @@ struct Grain {
     // Playback
     float position;          // Current read position in samples (float for interpolation)
     float playbackRate;      // Includes pitch + FM + reversal sign
-    int32_t samplesRemaining;
+    int32_t samplesRemaining; // Until the grain ends or its read position leaves the buffer
     int32_t totalSamples;
+    bool endsAtEdge;         // samplesRemaining runs out at the buffer edge, not the envelope end
+    bool testsEdges;         // Ends when its read position leaves the buffer (carried over
+                             // from spectral rendering, so samplesRemaining ignores the edges)
 
     // Envelope
     float envPhase;          // 0..1 progress through grain
@@ -19,14 +22,37 @@ struct Grain {
     float releaseRatio;      // Fraction of grain that is release (0-1)
     bool exponentialEnv;
 
+    // Spectral mode: bin phases are seeded on the grain's first hop
+    bool spectralStarted;
+
+    // Owning note voice (polyphonic mode), or GRAIN_FREE_RUNNING /
+    // GRAIN_FADING, and the note gain ramp across the current block
+    int note;
+    float gain;
+    float gainStep;
+
     // Panning (pre-computed equal-power coefficients)
     float panL;
     float panR;
 
+    // Aux send levels (post-pan), used when fxRouting != 0
+    float sendDelay;
+    float sendReverb;
+
     // Visualization
     float normPos;           // Normalized position in buffer (0-1) for grain events
     float duration;          // Grain duration in seconds
     float pan;               // Pan value (-1 to 1)
 };
 
-static constexpr int MAX_GRAINS = 128;
+// Pool size. Native hosts rendering dense clouds can raise it at build time
+// (e.g. -DNODEGRAIN_MAX_GRAINS=4096); the web build keeps the default.
+#ifndef NODEGRAIN_MAX_GRAINS
+#define NODEGRAIN_MAX_GRAINS 128
+#endif
+
+static constexpr int MAX_GRAINS = NODEGRAIN_MAX_GRAINS;
+
+// Grain.note for grains that belong to no note voice
+static constexpr int GRAIN_FREE_RUNNING = -1;  // The global stream (unity gain)
+static constexpr int GRAIN_FADING = -2;        // Orphaned; fades out over one block
@@ -1,4 +1,6 @@
 #include "grain_engine.h"
+#include "fast_math.h"
+#include "simd.h"
 #include <cmath>
 #include <cstring>
 #include <algorithm>
@@ -9,13 +11,19 @@
 
 GrainEngine::GrainEngine() {
     std::memset(grains_, 0, sizeof(grains_));
-    std::memset(outputL_, 0, sizeof(outputL_));
-    std::memset(outputR_, 0, sizeof(outputR_));
+    setMaxBlockSize(SCHEDULE_BLOCK_SIZE);
+    setRenderThreads(0);
     std::memset(grainEvents_, 0, sizeof(grainEvents_));
+    std::fill(unityMix_, unityMix_ + FX_CHUNK_SIZE, 1.0f);
 }
 
 GrainEngine::~GrainEngine() {
     delete[] sampleBuffer_;
+    delete[] impulseStaging_;
+    delete impulseSpectraStaging_;
+    delete convolver_;
+    delete pendingConvolver_.load();
+    delete retiredConvolver_.load();
 }
 
 void GrainEngine::init(float sampleRate) {
@@ -24,13 +32,28 @@ void GrainEngine::init(float sampleRate) {
     currentTime_ = 0.0;
     nextGrainTime_ = 0.0;
 
-    // Reset all grains
+    // Reset all grains and notes
     for (int i = 0; i < MAX_GRAINS; ++i) {
         grains_[i].active = false;
     }
+    for (NoteVoice& voice : notes_) {
+        voice.active = false;
+        voice.env.reset();
+        voice.env.setTimes(params_.noteAttack, params_.noteDecay, params_.noteSustain,
+                           params_.noteRelease, sampleRate);
+    }
+    fadingGrains_ = false;
 
     grainEventCount_ = 0;
 
+    // Smoothers are reset below, so the next updateParams() must re-target
+    // every field and the spawn cache must be rebuilt
+    paramsValid_ = false;
+    spawnCacheValid_ = false;
+
+    // Rewind random streams so renders are reproducible from the seed
+    rng_.setSeed(rng_.getSeed());
+
     // Initialize parameter smoothers (10ms smoothing time)
     pitchSmoother_.init(sampleRate, 10.0f);
     positionSmoother_.init(sampleRate, 10.0f);
@@ -43,11 +66,54 @@ void GrainEngine::init(float sampleRate) {
     grainSizeSmoother_.setImmediate(0.1f);
     panSmoother_.setImmediate(0.0f);
     volumeSmoother_.setImmediate(0.8f);
+
+    filterFreqSmoother_.init(sampleRate, 10.0f);
+    filterResSmoother_.init(sampleRate, 10.0f);
+    filterFreqSmoother_.setImmediate(20000.0f);
+    filterResSmoother_.setImmediate(0.0f);
+    filter_.reset();
+    filterActive_ = false;
+
+    distAmountSmoother_.init(sampleRate, 10.0f);
+    distAmountSmoother_.setImmediate(0.0f);
+    distortion_.reset();
+    distortionActive_ = false;
+
+    // Delay time glides slowly (like the old setTargetAtTime ramp) so
+    // modulation bends pitch instead of stepping
+    delayTimeSmoother_.init(sampleRate, 100.0f);
+    delayFeedbackSmoother_.init(sampleRate, 10.0f);
+    delayMixSmoother_.init(sampleRate, 10.0f);
+    delayTimeSmoother_.setImmediate(0.3f);
+    delayFeedbackSmoother_.setImmediate(0.3f);
+    delayMixSmoother_.setImmediate(0.0f);
+    delay_.init(sampleRate, MAX_DELAY_SECONDS);
+    delayActive_ = false;
+
+    reverbMixSmoother_.init(sampleRate, 10.0f);
+    reverbMixSmoother_.setImmediate(0.0f);
+    reverb_.init(sampleRate);
+    reverbActive_ = false;
+
+    limiter_.init(sampleRate);
+    limiter_.resetMode();
+    for (LatencyAligner& aligner : auxAligners_) aligner.init(limiter_.getLatency());
+    outputPeak_ = 0.0f;
+
+    // The CPU budget survives re-init; the load history does not
+    governor_.init(sampleRate);
+    governorCap_ = governor_.getCap();
+
+    // Morph position glides over 20ms so 60Hz control updates stay smooth
+    morphSmoother_.init(sampleRate, 20.0f);
+    morphSmoother_.setImmediate(0.0f);
+    appliedMorphPosition_ = -1.0f;
 }
 
 float* GrainEngine::allocateSampleBuffer(int lengthInSamples) {
     delete[] sampleBuffer_;
     sampleBuffer_ = new float[lengthInSamples];
+    sampleData_ = sampleBuffer_;
     sampleBufferLength_ = lengthInSamples;
     return sampleBuffer_;
 }
@@ -55,44 +121,234 @@ float* GrainEngine::allocateSampleBuffer(int lengthInSamples) {
 void GrainEngine::commitSampleBuffer(int channels, int lengthInSamples) {
     sampleBufferChannels_ = channels;
     sampleBufferLength_ = lengthInSamples;
+
+    // The previous sample's frames don't fit; new ones come when needed
+    spectral_.setFrames(nullptr);
+    spectral_.getOwnFrames().clear();
+}
+
+float* GrainEngine::allocateSpectralFrames(int numFrames, int analysisHop) {
+    spectral_.setFrames(nullptr);
+    return spectral_.getOwnFrames().allocate(numFrames, analysisHop);
+}
+
+int GrainEngine::getSpectralFramesSize() const {
+    return static_cast<int>(spectral_.getOwnFrames().data.size());
+}
+
+bool GrainEngine::commitSpectralFrames() {
+    SpectralFrames& frames = spectral_.getOwnFrames();
+    const int length = sampleBufferLength_;
+    if (length <= 0 || frames.analysisHop != SpectralFrames::hopFor(length) ||
+        frames.data.size() != SpectralFrames::sizeFor(SpectralFrames::framesFor(length))) {
+        frames.clear();
+        return false;
+    }
+    frames.publish();
+    return true;
+}
+
+void GrainEngine::attachSample(const float* data, int channels, int lengthInSamples,
+                               const SpectralFrames* frames) {
+    delete[] sampleBuffer_;
+    sampleBuffer_ = nullptr;
+    sampleData_ = data;
+    sampleBufferChannels_ = channels;
+    sampleBufferLength_ = data ? lengthInSamples : 0;
+    spectral_.getOwnFrames().clear();
+    spectral_.setFrames(frames);
 }
 
 void GrainEngine::start() {
     if (isPlaying_) return;
     isPlaying_ = true;
     nextGrainTime_ = currentTime_;
+    spectralActive_ = false;
+    filter_.reset();
+    distortion_.reset();
+    delay_.reset();   // Drop the previous run's echoes and tail
+    reverb_.reset();
+    if (convolver_) convolver_->reset();
+    limiter_.reset();
+    limiter_.resetMode();
+    for (LatencyAligner& aligner : auxAligners_) aligner.reset();
+    governor_.reset();
+    governorCap_ = governor_.getCap();
+
+    // Nothing is ringing, so send-bus effects sleep until a grain sends
+    std::fill(auxIdleFrames_, auxIdleFrames_ + NUM_AUX_BUSES, INT32_MAX / 2);
 }
 
 void GrainEngine::stop() {
     isPlaying_ = false;
-    // Deactivate all grains for clean stop
+    // Deactivate all grains (and notes) for clean stop
     for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (grains_[i].active) endsFaded_++;
         grains_[i].active = false;
     }
+    for (NoteVoice& voice : notes_) {
+        voice.active = false;
+        voice.env.reset();
+    }
+    fadingGrains_ = false;
 }
 
 void GrainEngine::updateParams(const EngineParams& params) {
+    // Only touch state for fields that actually changed
+    uint64_t dirty = paramsValid_ ? diffParams(params_, params) : PARAM_ALL;
+    if (dirty == 0) return;
+    const bool grainFiltersWereOff = !paramsValid_ || params_.grainFilterMode <= 0;
     params_ = params;
-    lfo_.setRate(params.lfoRate);
-    lfo_.setShape(static_cast<LfoShape>(params.lfoShape));
+    paramsValid_ = true;
+    dirtyParams_ |= dirty;
+
+    if (dirty & PARAM_LFO_RATE) lfo_.setRate(params.lfoRate);
+    if (dirty & PARAM_LFO_SHAPE) lfo_.setShape(static_cast<LfoShape>(params.lfoShape));
 
     // Update smoother targets for continuous parameters
-    pitchSmoother_.setTarget(params.pitch);
-    positionSmoother_.setTarget(params.position);
-    grainSizeSmoother_.setTarget(params.grainSize);
-    panSmoother_.setTarget(params.pan);
-    volumeSmoother_.setTarget(params.volume);
+    if (dirty & PARAM_PITCH) pitchSmoother_.setTarget(params.pitch);
+    if (dirty & PARAM_POSITION) positionSmoother_.setTarget(params.position);
+    if (dirty & PARAM_GRAIN_SIZE) grainSizeSmoother_.setTarget(params.grainSize);
+    if (dirty & PARAM_PAN) panSmoother_.setTarget(params.pan);
+    if (dirty & PARAM_VOLUME) volumeSmoother_.setTarget(params.volume);
+    if (dirty & PARAM_FILTER_FREQ) filterFreqSmoother_.setTarget(params.filterFreq);
+    if (dirty & PARAM_FILTER_RES) filterResSmoother_.setTarget(params.filterRes);
+    if (dirty & PARAM_DIST_OVERSAMPLE) distortion_.setOversampling(params.distOversample);
+    if (dirty & PARAM_DELAY_DAMPING) delay_.setDamping(params.delayDamping);
+    if (dirty & PARAM_REVERB_DECAY) reverb_.setDecay(params.reverbDecay);
+    if (dirty & PARAM_REVERB_DAMPING) reverb_.setDamping(params.reverbDamping);
+    if (dirty & PARAM_REVERB_MIX) reverbMixSmoother_.setTarget(params.reverbMix);
+    if (dirty & PARAM_LIMITER_CEILING) limiter_.setCeiling(params.limiterCeiling);
+    if (dirty & PARAM_LIMITER_RELEASE) limiter_.setRelease(params.limiterRelease);
+    if (dirty & PARAM_FX_ROUTING) {
+        // Don't replay sends left in the alignment lines from earlier routing
+        for (LatencyAligner& aligner : auxAligners_) aligner.reset();
+    }
+    if ((dirty & PARAM_GRAIN_FILTER_MODE) && params.grainFilterMode > 0) {
+        int mode = std::min(4, params.grainFilterMode) - 1;
+        grainFilters_.setMode(static_cast<FilterMode>(mode));
+        if (grainFiltersWereOff) primeGrainFilters();
+    }
+    if (dirty & PARAM_FILTER_TYPE) {
+        filter_.setMode(static_cast<FilterMode>(std::max(0, std::min(3, params.filterType))));
+    }
+    if (dirty & (PARAM_NOTE_ATTACK | PARAM_NOTE_DECAY | PARAM_NOTE_SUSTAIN | PARAM_NOTE_RELEASE)) {
+        for (NoteVoice& voice : notes_) {
+            voice.env.setTimes(params.noteAttack, params.noteDecay, params.noteSustain,
+                               params.noteRelease, sampleRate_);
+        }
+    }
+}
+
+void GrainEngine::primeGrainFilters() {
+    SpawnBatch& b = spawnBatch_;
+    int n = 0;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (grains_[i].active) b.slot[n++] = i;
+    }
+    if (n == 0) return;
+
+    // No spread: the random draws belong to the grains spawned from here on
+    const float cutoff = std::max(20.0f, params_.grainFilterFreq);
+    const float resDb = std::max(0.0f, std::min(20.0f, params_.grainFilterRes));
+    const float q = fastmath::exp2(resDb * 0.16609640f);
+    int padded = (n + simd::kLanes - 1) & ~(simd::kLanes - 1);
+    for (int i = 0; i < padded; ++i) {
+        b.cutoff[i] = cutoff;
+        b.q[i] = q;
+    }
+    grainFilters_.setGrains(b.slot, b.cutoff, b.q, n, sampleRate_);
+
+    // Settle each filter on the grain's next dry sample (read from a copy,
+    // so the grain does not advance; b.start is free scratch here), or the
+    // switch would step to zero
+    for (int i = 0; i < n; ++i) {
+        Grain probe = grains_[b.slot[i]];
+        b.start[i] = renderGrainSample(probe);
+    }
+    grainFilters_.settleGrains(b.slot, b.start, n);
+}
+
+void GrainEngine::setMaxBlockSize(int frames) {
+    maxBlockSize_ = std::max(SCHEDULE_BLOCK_SIZE, std::min(MAX_BLOCK_SIZE, frames));
+    outputL_.assign(maxBlockSize_, 0.0f);
+    outputR_.assign(maxBlockSize_, 0.0f);
+    for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+        auxOutL_[b].assign(maxBlockSize_, 0.0f);
+        auxOutR_[b].assign(maxBlockSize_, 0.0f);
+    }
+}
+
+int GrainEngine::getMaxBlockSize() const {
+    return maxBlockSize_;
 }
 
 void GrainEngine::process(float* outputL, float* outputR, int numFrames) {
+    const bool governed = governor_.isEnabled() && offlinePass_ == OfflinePass::None;
+    const bool timed = governed || telemetryEnabled_;
+    const double startMs = timed ? CpuGovernor::nowMs() : 0.0;
+    spawnMs_ = renderMs_ = fxMs_ = 0.0;
+    for (int offset = 0; offset < numFrames; offset += SCHEDULE_BLOCK_SIZE) {
+        int n = std::min(SCHEDULE_BLOCK_SIZE, numFrames - offset);
+        processBlock(outputL + offset, outputR + offset, n, offset);
+    }
+    if (!timed || numFrames <= 0) return;
+
+    const double costMs = CpuGovernor::nowMs() - startMs;
+    if (governed) governBlock(costMs, numFrames);
+    if (telemetryEnabled_) publishTelemetry(outputL, outputR, numFrames, costMs);
+}
+
+void GrainEngine::governBlock(double costMs, int numFrames) {
+    int active = 0;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (grains_[i].active && grains_[i].note != GRAIN_FADING) active++;
+    }
+    governorCap_ = governor_.update(costMs, numFrames, active);
+
+    // Fade the quietest grains over the cap out across the next block
+    // (they still count until they are gone, which holds spawns off).
+    // Ties go to the lower slot, so the choice is deterministic.
+    const int excess = active - grainCap();
+    if (excess <= 0) return;
+
+    int count = 0;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        const Grain& grain = grains_[i];
+        if (!grain.active || grain.note == GRAIN_FADING) continue;
+        shedCandidates_[count++] = { computeEnvelope(grain) * grain.gain, i };
+    }
+    ShedCandidate* first = shedCandidates_;
+    ShedCandidate* last = shedCandidates_ + count;
+    std::nth_element(first, first + (excess - 1), last,
+                     [](const ShedCandidate& a, const ShedCandidate& b) {
+                         return a.level < b.level || (a.level == b.level && a.slot < b.slot);
+                     });
+    for (int k = 0; k < excess; ++k) {
+        Grain& grain = grains_[shedCandidates_[k].slot];
+        grain.note = GRAIN_FADING;
+        grain.gainStep = 0.0f;
+    }
+    fadingGrains_ = true;
+}
+
+void GrainEngine::processBlock(float* outputL, float* outputR, int numFrames, int offset) {
     // Clear output
     std::memset(outputL, 0, numFrames * sizeof(float));
     std::memset(outputR, 0, numFrames * sizeof(float));
+    dryCursor_ = offset;
 
-    if (!isPlaying_ || !sampleBuffer_ || sampleBufferLength_ == 0) {
+    if (!isPlaying_ || !sampleData_ || sampleBufferLength_ == 0) {
         currentTime_ += numFrames * invSampleRate_;
         return;
     }
+    const bool timed = telemetryEnabled_;
+    const double startMs = timed ? CpuGovernor::nowMs() : 0.0;
+
+    // Morph runs before the LFO so a morphed lfoRate/lfoShape applies this block
+    if (morphActive_) {
+        updateMorph(numFrames);
+    }
 
     // Cache LFO value for this block (LFO rates are < 20Hz, per-block is fine)
     currentLfoValue_ = lfo_.getValue(static_cast<float>(currentTime_));
@@ -103,7 +359,6 @@ void GrainEngine::process(float* outputL, float* outputR, int numFrames) {
         positionSmoother_.process();
         grainSizeSmoother_.process();
         panSmoother_.process();
-        volumeSmoother_.process();
     }
 
     // Update drift if active
@@ -111,15 +366,856 @@ void GrainEngine::process(float* outputL, float* outputR, int numFrames) {
         updateDrift(numFrames * invSampleRate_);
     }
 
-    // Schedule new grains
-    double blockEndTime = currentTime_ + numFrames * invSampleRate_;
-    while (nextGrainTime_ < blockEndTime) {
-        spawnGrain();
+    // Refresh derived spawn constants (no-op unless their inputs changed)
+    updateSpawnCache();
 
+    // Schedule new grains. Modulation is constant within a block, so every
+    // grain due before the block end is generated in one batch.
+    double blockEndTime = currentTime_ + numFrames * invSampleRate_;
+    if (polyphonic_) {
+        scheduleNotes(numFrames, blockEndTime);
+    } else if (fadingGrains_) {
+        updateGrainGains(numFrames);
+    }
+    if (!polyphonic_ && nextGrainTime_ < blockEndTime) {
         // Advance next grain time by density (possibly LFO-modulated)
-        float density = getModulated(params_.density, LFO_DENSITY,
-                                     ModScales::density, 0.005f, 10.0f);
-        nextGrainTime_ += density;
+        float density = spawnParams_.density;
+        int dueCount = 0;
+        while (nextGrainTime_ < blockEndTime) {
+            nextGrainTime_ += density;
+            dueCount++;
+        }
+        spawnGrains(dueCount);
+    }
+    const double spawnedMs = timed ? CpuGovernor::nowMs() : 0.0;
+    const double renderedMs = renderMs_;
+
+    // Render all active grains, then the post-mix chain
+    if (offlinePass_ == OfflinePass::Skip) {
+        ageGrains(numFrames);
+    } else if (offlinePass_ == OfflinePass::Dry) {
+        // The grain layer as the FX chain would receive it (one chunk, as
+        // numFrames <= FX_CHUNK_SIZE)
+        sendsActive_ = params_.fxRouting != 0;
+        renderMix(outputL, outputR, numFrames);
+        for (int b = 0; b < NUM_AUX_BUSES && sendsActive_; ++b) {
+            std::memcpy(dryOut_[2 + 2 * b] + offset, auxBusL_[b], numFrames * sizeof(float));
+            std::memcpy(dryOut_[3 + 2 * b] + offset, auxBusR_[b], numFrames * sizeof(float));
+        }
+        sendsActive_ = false;
+    } else if (params_.fxRouting == 0) {
+        renderMix(outputL, outputR, numFrames);
+        processFxChain(outputL, outputR, numFrames);
+        int clear = std::min(numFrames, maxBlockSize_ - offset);
+        for (int b = 0; b < NUM_AUX_BUSES && clear > 0; ++b) {
+            std::fill_n(auxOutL_[b].data() + offset, clear, 0.0f);
+            std::fill_n(auxOutR_[b].data() + offset, clear, 0.0f);
+        }
+    } else {
+        processSendChain(outputL, outputR, numFrames, offset);
+    }
+
+    if (timed) {
+        spawnMs_ += spawnedMs - startMs;
+        fxMs_ += CpuGovernor::nowMs() - spawnedMs - (renderMs_ - renderedMs);
+    }
+    currentTime_ = blockEndTime;
+}
+
+void GrainEngine::skip(int numFrames) {
+    offlinePass_ = OfflinePass::Skip;
+    for (int offset = 0; offset < numFrames; offset += SCHEDULE_BLOCK_SIZE) {
+        int n = std::min(SCHEDULE_BLOCK_SIZE, numFrames - offset);
+        processBlock(outputL_.data(), outputR_.data(), n, 0);
+    }
+    offlinePass_ = OfflinePass::None;
+}
+
+void GrainEngine::renderDry(float* const* dry, int numFrames) {
+    std::copy(dry, dry + RENDER_CHANNELS, dryOut_);
+    offlinePass_ = OfflinePass::Dry;
+    process(dry[0], dry[1], numFrames);
+    offlinePass_ = OfflinePass::None;
+}
+
+void GrainEngine::processDry(const float* const* dry, float* outputL, float* outputR,
+                             int numFrames) {
+    std::copy(dry, dry + RENDER_CHANNELS, dryIn_);
+    offlinePass_ = OfflinePass::Wet;
+    process(outputL, outputR, numFrames);
+    offlinePass_ = OfflinePass::None;
+}
+
+void GrainEngine::ageGrains(int numFrames) {
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        Grain& grain = grains_[i];
+        if (!grain.active) continue;
+        if (grain.testsEdges) {
+            // Same sum and edge test as renderGrainSample()
+            const float length = static_cast<float>(sampleBufferLength_);
+            for (int n = 0; n < numFrames && grain.active; ++n) {
+                grain.position += grain.playbackRate;
+                if (--grain.samplesRemaining <= 0 || grain.position < 0.0f || grain.position >= length) {
+                    grain.active = false;
+                }
+            }
+            continue;
+        }
+        grain.samplesRemaining -= numFrames;
+        if (grain.samplesRemaining <= 0) grain.active = false;
+    }
+}
+
+void GrainEngine::computeSpawnParams(SpawnParams& sp) const {
+    // Get modulated parameters (using smoothed values for continuous params)
+    float grainSize = getModulated(grainSizeSmoother_.getCurrent(), LFO_GRAIN_SIZE,
+                                   ModScales::grainSize, 0.01f, MAX_GRAIN_SECONDS);
+    float pitch = getModulated(pitchSmoother_.getCurrent(), LFO_PITCH,
+                               ModScales::pitch, -24.0f, 24.0f);
+
+    sp.density = getModulated(params_.density, LFO_DENSITY,
+                              ModScales::density, 0.005f, 10.0f);
+    sp.fmFreq = getModulated(params_.fmFreq, LFO_FM_FREQ,
+                             ModScales::fmFreq, 0.0f, 1000.0f);
+    sp.fmAmount = getModulated(params_.fmAmount, LFO_FM_AMOUNT,
+                               ModScales::fmAmount, 0.0f, 100.0f);
+    sp.spread = getModulated(params_.spread, LFO_SPREAD,
+                             ModScales::spread, 0.0f, 2.0f);
+    sp.attack = getModulated(params_.attack, LFO_ATTACK,
+                             ModScales::attack, 0.01f, 0.9f);
+    sp.release = getModulated(params_.release, LFO_RELEASE,
+                              ModScales::release, 0.01f, 0.9f);
+    sp.panCenter = getModulated(panSmoother_.getCurrent(), LFO_PAN,
+                                ModScales::pan, -1.0f, 1.0f);
+    sp.panSpread = getModulated(params_.panSpread, LFO_PAN_SPREAD,
+                                ModScales::panSpread, 0.0f, 1.0f);
+    sp.position = getModulated(getBasePosition(), LFO_POSITION,
+                               ModScales::position, 0.0f, 1.0f);
+
+    // Calculate grain duration in samples
+    sp.grainDuration = std::max(0.01f, grainSize);
+    sp.grainSamples = sp.grainDuration * sampleRate_;
+    sp.totalSamples = static_cast<int>(sp.grainSamples);
+    if (sp.totalSamples < 1) sp.totalSamples = 1;
+    sp.envIncrement = 1.0f / static_cast<float>(sp.totalSamples);
+
+    // Pitch: semitones -> cents -> playback rate (detune is applied per grain)
+    sp.pitchCents = pitch * 100.0f;
+    sp.pitchRate = fastmath::exp2(sp.pitchCents * (1.0f / 1200.0f));
+    sp.detune = params_.detune;
+    sp.reversalChance = params_.grainReversalChance;
+    sp.exponentialEnv = (params_.envelopeCurve == 1);
+
+    sp.grainFilterMode = params_.grainFilterMode;
+    sp.grainFilterFreq = params_.grainFilterFreq;
+    sp.grainFilterRes = params_.grainFilterRes;
+    sp.grainFilterSpread = params_.grainFilterSpread;
+
+    sp.sendsActive = params_.fxRouting != 0;
+    sp.sendDelay = params_.sendDelay;
+    sp.sendReverb = params_.sendReverb;
+    sp.sendSpread = params_.sendSpread;
+
+    // Pan gains at the pan centre (used directly when panSpread is 0)
+    fastmath::equalPowerPan(sp.panCenter, sp.centerPanL, sp.centerPanR);
+
+    // Buffer-derived constants
+    sp.bufferLength = static_cast<float>(sampleBufferLength_);
+    sp.invBufferLength = (sampleBufferLength_ > 0) ? 1.0f / sp.bufferLength : 0.0f;
+    sp.lastSample = static_cast<float>(sampleBufferLength_ - 1);
+    sp.centerSample = sp.position * sp.bufferLength;
+    sp.offsetScale = sp.spread * sp.bufferLength * 0.5f;
+}
+
+float GrainEngine::getBasePosition() const {
+    // Position: frozen > drift > manual (use smoothed position for manual)
+    return isFrozen_ ? frozenPosition_ :
+           (isDrifting_ ? driftPosition_ : positionSmoother_.getCurrent());
+}
+
+void GrainEngine::updateSpawnCache() {
+    // Inputs that vary per block without a params update
+    SpawnCacheKey key;
+    key.grainSize = grainSizeSmoother_.getCurrent();
+    key.pitch = pitchSmoother_.getCurrent();
+    key.pan = panSmoother_.getCurrent();
+    key.basePosition = getBasePosition();
+    key.lfoValue = (params_.lfoAmount != 0.0f && params_.lfoTargetMask != 0)
+                   ? currentLfoValue_ : 0.0f;
+    key.bufferLength = sampleBufferLength_;
+
+    if ((dirtyParams_ & kSpawnParamMask) || !spawnCacheValid_ ||
+        std::memcmp(&key, &spawnCacheKey_, sizeof(key)) != 0) {
+        computeSpawnParams(spawnParams_);
+        spawnCacheKey_ = key;
+        spawnCacheValid_ = true;
+    }
+    dirtyParams_ &= ~kSpawnParamMask;
+
+    // FM phase advances every block (taken at block start, shared by the batch)
+    spawnParams_.fmMod = 0.0f;
+    if (spawnParams_.fmAmount > 0.0f) {
+        // Reduce the phase in double so long sessions keep full precision
+        double fmTurns = currentTime_ * spawnParams_.fmFreq * (0.5 / M_PI);
+        fmTurns -= std::floor(fmTurns);
+        spawnParams_.fmMod = fastmath::sinTurns(static_cast<float>(fmTurns)) *
+                             (spawnParams_.fmAmount * 0.01f);
+    }
+}
+
+void GrainEngine::scheduleNotes(int numFrames, double blockEndTime) {
+    // Envelopes run at control rate; grains ramp between the block's ends
+    for (int v = 0; v < MAX_NOTES; ++v) {
+        NoteVoice& voice = notes_[v];
+        if (!voice.active) continue;
+        if (voice.env.isIdle()) {
+            // Released to silence by the end of the last block
+            voice.active = false;
+            for (int i = 0; i < MAX_GRAINS; ++i) {
+                if (grains_[i].active && grains_[i].note == v) {
+                    grains_[i].active = false;
+                    endsFaded_++;
+                }
+            }
+            continue;
+        }
+        voice.gainStart = voice.velocity * voice.env.getLevel();
+        float gainEnd = voice.velocity * voice.env.advance(numFrames);
+        voice.gainStep = (gainEnd - voice.gainStart) / static_cast<float>(numFrames);
+    }
+    updateGrainGains(numFrames);
+    updateNoteShares();
+
+    // Each note is its own stream at the shared (modulated) density
+    const float density = spawnParams_.density;
+    for (int v = 0; v < MAX_NOTES; ++v) {
+        NoteVoice& voice = notes_[v];
+        if (!voice.active || voice.env.isIdle()) continue;
+        int dueCount = 0;
+        while (voice.nextGrainTime < blockEndTime) {
+            voice.nextGrainTime += density;
+            dueCount++;
+        }
+        if (dueCount > 0) spawnGrains(dueCount, v);
+    }
+}
+
+void GrainEngine::updateGrainGains(int numFrames) {
+    const float invFrames = 1.0f / static_cast<float>(numFrames);
+    bool fading = false;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        Grain& grain = grains_[i];
+        if (!grain.active) continue;
+        if (grain.note >= 0) {
+            const NoteVoice& voice = notes_[grain.note];
+            grain.gain = voice.gainStart;
+            grain.gainStep = voice.gainStep;
+        } else if (grain.note == GRAIN_FADING || polyphonic_) {
+            // A fading grain with a falling ramp has just finished its fade
+            if (grain.gain <= 0.0f || (grain.note == GRAIN_FADING && grain.gainStep < 0.0f)) {
+                grain.active = false;
+                endsFaded_++;
+                continue;
+            }
+            grain.note = GRAIN_FADING;
+            grain.gainStep = -grain.gain * invFrames;
+            fading = true;
+        }
+    }
+    fadingGrains_ = fading;
+}
+
+void GrainEngine::updateNoteShares() {
+    // Every note asks for the same steady-state grain count; split the
+    // limit by priority-weighted max-min fairness (notes that would get
+    // more than they ask keep just that, the rest split the remainder)
+    const float demand = std::ceil(spawnParams_.grainDuration /
+                                   std::max(spawnParams_.density, 1e-6f));
+    bool open[MAX_NOTES];
+    float share[MAX_NOTES];
+    float remaining = static_cast<float>(grainCap());
+    float weight = 0.0f;
+    for (int v = 0; v < MAX_NOTES; ++v) {
+        open[v] = notes_[v].active;
+        share[v] = 0.0f;
+        if (open[v]) weight += notes_[v].priority();
+    }
+    bool settled = false;
+    while (!settled && weight > 0.0f) {
+        settled = true;
+        const float perWeight = remaining / weight;
+        for (int v = 0; v < MAX_NOTES; ++v) {
+            if (!open[v] || perWeight * notes_[v].priority() < demand) continue;
+            share[v] = demand;
+            open[v] = false;
+            remaining -= demand;
+            weight -= notes_[v].priority();
+            settled = false;
+        }
+    }
+    if (weight > 0.0f) {
+        const float perWeight = remaining / weight;
+        for (int v = 0; v < MAX_NOTES; ++v) {
+            if (open[v]) share[v] = perWeight * notes_[v].priority();
+        }
+    }
+
+    // Whole grains summing to at most the limit: round down, then hand the
+    // leftover out by largest fraction
+    int left = grainCap();
+    for (int v = 0; v < MAX_NOTES; ++v) {
+        noteShare_[v] = static_cast<int>(share[v]);
+        share[v] -= static_cast<float>(noteShare_[v]);
+        left -= noteShare_[v];
+    }
+    while (left > 0) {
+        int best = -1;
+        for (int v = 0; v < MAX_NOTES; ++v) {
+            if (share[v] > 0.0f && (best < 0 || share[v] > share[best])) best = v;
+        }
+        if (best < 0) break;
+        noteShare_[best]++;
+        share[best] = 0.0f;
+        left--;
+    }
+}
+
+int GrainEngine::pickVictimNote(const int* noteGrains) const {
+    // The note furthest above its share, if any is above it
+    int victim = -1;
+    int worst = 0;
+    for (int v = 0; v < MAX_NOTES; ++v) {
+        int excess = noteGrains[v] - noteShare_[v];
+        if (excess > worst) {
+            worst = excess;
+            victim = v;
+        }
+    }
+    return victim;
+}
+
+int GrainEngine::acquireGrainSlots(int* slots, int count, int note) {
+    int active = 0;
+    int noteGrains[MAX_NOTES] = {};
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (!grains_[i].active) continue;
+        active++;
+        if (grains_[i].note >= 0) noteGrains[grains_[i].note]++;
+    }
+    // Over the limit (it was just lowered): spawn nothing until the excess
+    // has finished, rather than stealing and holding the count up
+    const int limit = grainCap();
+    if (active > limit) return 0;
+
+    // A note never grows past its share, so the slots others free go to
+    // the notes below theirs
+    if (note >= 0) {
+        int room = noteShare_[note] - noteGrains[note];
+        count = std::min(count, std::max(0, room));
+    }
+
+    // Free slots first, in pool order, as far as the grain limit allows
+    int fresh = std::min(count, limit - active);
+    int found = 0;
+    for (int i = 0; i < MAX_GRAINS && found < fresh; ++i) {
+        if (!grains_[i].active) slots[found++] = i;
+    }
+
+    if (note >= 0) {
+        // Notes never cut grains off: with the pool full, a note below its
+        // share fades out the grain closest to finishing of the note
+        // furthest above its own, and spawns into the slot once it is free
+        for (int k = found; k < count; ++k) {
+            int victim = pickVictimNote(noteGrains);
+            if (victim < 0) break;
+
+            int oldestSlot = -1;
+            int32_t leastRemaining = INT32_MAX;
+            for (int i = 0; i < MAX_GRAINS; ++i) {
+                const Grain& grain = grains_[i];
+                if (grain.active && grain.note == victim && grain.samplesRemaining < leastRemaining) {
+                    leastRemaining = grain.samplesRemaining;
+                    oldestSlot = i;
+                }
+            }
+            if (oldestSlot < 0) break;
+            grains_[oldestSlot].note = GRAIN_FADING;
+            grains_[oldestSlot].gainStep = 0.0f;
+            fadingGrains_ = true;
+            noteGrains[victim]--;
+        }
+        return found;
+    }
+
+    // Throttled by the CPU governor: drop the spawns over the cap rather
+    // than cut sounding grains off
+    if (governorCap_ < grainLimit_) return found;
+
+    // Steal the grains closest to finishing for the remainder
+    while (found < count) {
+        int oldestSlot = -1;
+        int32_t leastRemaining = INT32_MAX;
+        for (int i = 0; i < MAX_GRAINS; ++i) {
+            if (grains_[i].active && grains_[i].samplesRemaining < leastRemaining) {
+                leastRemaining = grains_[i].samplesRemaining;
+                oldestSlot = i;
+            }
+        }
+        if (oldestSlot < 0) break; // Should never happen with count <= MAX_GRAINS
+
+        // Mark as taken so the next pass picks a different victim
+        grains_[oldestSlot].samplesRemaining = INT32_MAX;
+        slots[found++] = oldestSlot;
+        stealCount_++;
+    }
+    return found;
+}
+
+void GrainEngine::retimeGrains(bool spectral) {
+    for (Grain& grain : grains_) {
+        if (!grain.active) continue;
+        if (spectral) {
+            // What is left of the envelope; the hops test the edges
+            const int32_t elapsed = static_cast<int32_t>(grain.envPhase * grain.totalSamples);
+            grain.samplesRemaining = std::max(1, grain.totalSamples - elapsed);
+            grain.endsAtEdge = false;
+            grain.testsEdges = false;
+        } else {
+            // Finding the edge up front means replaying the position sum
+            // (grainLifetime), too slow for every grain in one block: test
+            // it per sample instead, as the spectral hops did
+            grain.testsEdges = true;
+        }
+    }
+    lifetimesSpectral_ = spectral ? 1 : 0;
+}
+
+int32_t GrainEngine::grainLifetime(float start, float rate, int32_t totalSamples) const {
+    const float length = static_cast<float>(sampleBufferLength_);
+
+    // The float sum drifts by at most half an ulp of the position per step;
+    // grains that stay further than that from both edges play out in full
+    const double travel = std::fabs(static_cast<double>(rate)) * totalSamples;
+    const double reach = std::fabs(static_cast<double>(start)) + travel + 1.0;
+    const double drift = totalSamples * reach * (1.0 / 8388608.0) + 1.0;
+    if (rate >= 0.0f ? start + travel + drift < length : start - travel - drift >= 0.0) {
+        return totalSamples;
+    }
+
+    // Same sum and bounds test as renderGrainSample()
+    float position = start;
+    for (int32_t n = 1; n < totalSamples; ++n) {
+        position += rate;
+        if (position < 0.0f || position >= length) return n;
+    }
+    return totalSamples;
+}
+
+void GrainEngine::spawnGrains(int count, int note) {
+    // Grains beyond the limit would only steal earlier grains of this batch
+    if (count > grainCap()) count = grainCap();
+
+    const SpawnParams& sp = spawnParams_;
+
+    SpawnBatch& b = spawnBatch_;
+    int n = acquireGrainSlots(b.slot, count, note);
+    if (n <= 0) return;
+    spawnCount_ += n;
+
+    // Random draws, one stream per purpose (unused tail lanes are zeroed)
+    int padded = (n + simd::kLanes - 1) & ~(simd::kLanes - 1);
+    rng_.fill(RngStream::Pitch, b.rDetune, n);
+    rng_.fill(RngStream::Reversal, b.rReverse, n);
+    rng_.fill(RngStream::Position, b.rOffset, n);
+    rng_.fill(RngStream::Pan, b.rPan, n);
+    for (int i = n; i < padded; ++i) {
+        b.rDetune[i] = b.rReverse[i] = b.rOffset[i] = b.rPan[i] = 0.0f;
+    }
+
+    // Vectorized pass: rates, start positions and pan gains for the batch
+    {
+        using namespace simd;
+        const f32x4 zero = splat(0.0f);
+        const f32x4 one = splat(1.0f);
+        const f32x4 two = splat(2.0f);
+        const f32x4 detune = splat(sp.detune);
+        const f32x4 pitchRate = splat(note >= 0 ? sp.pitchRate * notes_[note].pitchRatio
+                                                : sp.pitchRate);
+        const f32x4 reversalChance = splat(sp.reversalChance);
+        const f32x4 fmMod = splat(sp.fmMod);
+        const f32x4 minRate = splat(0.1f);
+        const f32x4 grainSamples = splat(sp.grainSamples);
+        const f32x4 len = splat(sp.bufferLength);
+        const f32x4 lastSample = splat(sp.lastSample);
+        const f32x4 centerSample = splat(sp.centerSample);
+        const f32x4 offsetScale = splat(sp.offsetScale);
+        const f32x4 panCenter = splat(sp.panCenter);
+        const f32x4 panSpread = splat(sp.panSpread);
+        const f32x4 invLength = splat(sp.invBufferLength);
+        const bool hasDetune = sp.detune != 0.0f;
+        const bool hasPanSpread = sp.panSpread != 0.0f;
+
+        for (int i = 0; i < padded; i += kLanes) {
+            // Playback rate = pitch rate (cached) * detune + FM
+            f32x4 rate = pitchRate;
+            if (hasDetune) {
+                f32x4 cents = load(b.rDetune + i) * detune * two - detune;
+                rate = rate * fastmath::exp2(cents * splat(1.0f / 1200.0f));
+            }
+
+            // Grain reversal
+            f32x4 reversed = cmpLt(load(b.rReverse + i), reversalChance);
+            f32x4 signedRate = select(reversed, zero - rate, rate);
+            f32x4 absRate = max(minRate, abs(signedRate + fmMod));
+            store(b.rate + i, select(reversed, zero - absRate, absRate));
+
+            // Start position, clamped so the grain fits in the buffer
+            f32x4 randomOffset = (load(b.rOffset + i) * two - one) * offsetScale;
+            f32x4 startSample = centerSample + randomOffset;
+            f32x4 maxStart = max(zero, len - grainSamples * absRate);
+            startSample = max(zero, min(startSample, maxStart));
+
+            // Reversed grains start at the end of the region
+            startSample = select(reversed, min(startSample + grainSamples, lastSample),
+                                 startSample);
+            store(b.start + i, startSample);
+            store(b.normPos + i, startSample * invLength);
+
+            // Pan (constant gains when there is no spread)
+            if (hasPanSpread) {
+                f32x4 randomPan = (load(b.rPan + i) * two - one) * panSpread;
+                f32x4 finalPan = max(zero - one, min(one, panCenter + randomPan));
+                store(b.pan + i, finalPan);
+
+                f32x4 panL, panR;
+                fastmath::equalPowerPan(finalPan, panL, panR);
+                store(b.panL + i, panL);
+                store(b.panR + i, panR);
+            } else {
+                store(b.pan + i, panCenter);
+                store(b.panL + i, splat(sp.centerPanL));
+                store(b.panR + i, splat(sp.centerPanR));
+            }
+        }
+    }
+
+    // Per-grain filters: cutoff spread in octaves, resonance around the centre
+    if (sp.grainFilterMode > 0) {
+        using namespace simd;
+        rng_.fill(RngStream::GrainFilter, b.rCutoff, n);
+        rng_.fill(RngStream::GrainFilter, b.rRes, n);
+        for (int i = n; i < padded; ++i) b.rCutoff[i] = b.rRes[i] = 0.0f;
+
+        const f32x4 one = splat(1.0f);
+        const f32x4 two = splat(2.0f);
+        const f32x4 centreOctave = splat(std::log2(std::max(20.0f, sp.grainFilterFreq)));
+        const f32x4 octaveSpread = splat(sp.grainFilterSpread * 4.0f);
+        const f32x4 centreRes = splat(sp.grainFilterRes);
+        const f32x4 resSpread = splat(sp.grainFilterSpread * 10.0f);
+
+        // Resonance reads like the main filter's: dB for lowpass and
+        // highpass (linear Q = 10^(dB / 20)), linear Q for bandpass and notch
+        const bool linearQ = sp.grainFilterMode == 2 || sp.grainFilterMode == 4;
+        for (int i = 0; i < padded; i += kLanes) {
+            f32x4 octave = centreOctave + (load(b.rCutoff + i) * two - one) * octaveSpread;
+            store(b.cutoff + i, fastmath::exp2(octave));
+
+            f32x4 res = centreRes + (load(b.rRes + i) * two - one) * resSpread;
+            res = max(splat(0.0f), min(splat(20.0f), res));
+            store(b.q + i, linearQ ? res : fastmath::exp2(res * splat(0.16609640f)));
+        }
+        grainFilters_.setGrains(b.slot, b.cutoff, b.q, n, sampleRate_);
+    }
+
+    // Aux send levels, spread around the centre like pan
+    if (sp.sendsActive) {
+        using namespace simd;
+        const bool hasSpread = sp.sendSpread > 0.0f;
+        if (hasSpread) {
+            rng_.fill(RngStream::Send, b.rSendDelay, n);
+            rng_.fill(RngStream::Send, b.rSendReverb, n);
+            for (int i = n; i < padded; ++i) b.rSendDelay[i] = b.rSendReverb[i] = 0.0f;
+        }
+
+        const f32x4 zero = splat(0.0f);
+        const f32x4 one = splat(1.0f);
+        const f32x4 two = splat(2.0f);
+        const f32x4 spread = splat(sp.sendSpread);
+        const f32x4 delay = splat(sp.sendDelay);
+        const f32x4 reverb = splat(sp.sendReverb);
+        for (int i = 0; i < padded; i += kLanes) {
+            f32x4 d = delay, r = reverb;
+            if (hasSpread) {
+                d = d + (load(b.rSendDelay + i) * two - one) * spread;
+                r = r + (load(b.rSendReverb + i) * two - one) * spread;
+            }
+            store(b.sendDelay + i, max(zero, min(one, d)));
+            store(b.sendReverb + i, max(zero, min(one, r)));
+        }
+    }
+
+    // Write the batch into the pool. Spectral grains walk the frames at one
+    // sample per sample whatever their pitch and test the edges per hop,
+    // so they live their full length unless they reach one.
+    const bool spectral = spectralGrains();
+    for (int i = 0; i < n; ++i) {
+        Grain& grain = grains_[b.slot[i]];
+        grain.active = true;
+        grain.position = b.start[i];
+        grain.playbackRate = b.rate[i];
+        grain.totalSamples = sp.totalSamples;
+        grain.samplesRemaining = spectral ? sp.totalSamples
+                                          : grainLifetime(b.start[i], b.rate[i], sp.totalSamples);
+        grain.endsAtEdge = grain.samplesRemaining < sp.totalSamples;
+        grain.testsEdges = false;
+        grain.envPhase = 0.0f;
+        grain.envIncrement = sp.envIncrement;
+        grain.attackRatio = sp.attack;
+        grain.releaseRatio = sp.release;
+        grain.exponentialEnv = sp.exponentialEnv;
+        grain.spectralStarted = false;
+        grain.note = note;
+        grain.gain = note >= 0 ? notes_[note].gainStart : 1.0f;
+        grain.gainStep = note >= 0 ? notes_[note].gainStep : 0.0f;
+        grain.panL = b.panL[i];
+        grain.panR = b.panR[i];
+        grain.sendDelay = sp.sendsActive ? b.sendDelay[i] : 0.0f;
+        grain.sendReverb = sp.sendsActive ? b.sendReverb[i] : 0.0f;
+
+        // Store visualization data
+        grain.normPos = b.normPos[i];
+        grain.duration = sp.grainDuration;
+        grain.pan = b.pan[i];
+
+        // Emit grain event
+        if (grainEventCount_ < MAX_GRAIN_EVENTS) {
+            grainEvents_[grainEventCount_].normPos = grain.normPos;
+            grainEvents_[grainEventCount_].duration = grain.duration;
+            grainEvents_[grainEventCount_].pan = grain.pan;
+            grainEventCount_++;
+        }
+    }
+}
+
+void GrainEngine::renderMix(float* outputL, float* outputR, int numFrames) {
+    if (offlinePass_ == OfflinePass::Wet) {
+        // Rendered by an earlier renderDry() pass over the same timeline
+        std::memcpy(outputL, dryIn_[0] + dryCursor_, numFrames * sizeof(float));
+        std::memcpy(outputR, dryIn_[1] + dryCursor_, numFrames * sizeof(float));
+        for (int b = 0; b < NUM_AUX_BUSES && sendsActive_; ++b) {
+            std::memcpy(auxBusL_[b], dryIn_[2 + 2 * b] + dryCursor_, numFrames * sizeof(float));
+            std::memcpy(auxBusR_[b], dryIn_[3 + 2 * b] + dryCursor_, numFrames * sizeof(float));
+        }
+        dryCursor_ += numFrames;
+        ageGrains(numFrames);
+        return;
+    }
+
+    if (!telemetryEnabled_) {
+        renderGrainLayer(outputL, outputR, numFrames);
+        return;
+    }
+
+    // Time the render and sort the grains it ends by cause
+    bool wasActive[MAX_GRAINS];
+    for (int i = 0; i < MAX_GRAINS; ++i) wasActive[i] = grains_[i].active;
+    const double startMs = CpuGovernor::nowMs();
+    renderGrainLayer(outputL, outputR, numFrames);
+    renderMs_ += CpuGovernor::nowMs() - startMs;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (!wasActive[i] || grains_[i].active) continue;
+        if (grains_[i].endsAtEdge) endsBoundary_++;
+        else endsNatural_++;
+    }
+}
+
+void GrainEngine::renderGrainLayer(float* outputL, float* outputR, int numFrames) {
+    const bool spectral = spectralGrains();
+    if (lifetimesSpectral_ != (spectral ? 1 : 0)) retimeGrains(spectral);
+
+    if (spectral) {
+        renderGrainsSpectral(outputL, outputR, numFrames);
+
+        // Spectral grains share one synthesis spectrum, so they send as a
+        // mix at the centre levels rather than per grain
+        if (sendsActive_) {
+            const float sends[NUM_AUX_BUSES] = { params_.sendDelay, params_.sendReverb };
+            for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+                for (int i = 0; i < numFrames; ++i) {
+                    auxBusL_[b][i] = outputL[i] * sends[b];
+                    auxBusR_[b][i] = outputR[i] * sends[b];
+                }
+            }
+        }
+        return;
+    }
+
+    // Grouped whatever the thread count (the groups run inline without
+    // helpers), so the mix doesn't depend on it
+    spectralActive_ = false;
+    renderGrainsParallel(outputL, outputR, numFrames);
+}
+
+void GrainEngine::renderGrainsParallel(float* outputL, float* outputR, int numFrames) {
+    using namespace simd;
+    const bool filtered = params_.grainFilterMode > 0;
+    float* dest[RENDER_CHANNELS] = { outputL, outputR, auxBusL_[0], auxBusR_[0],
+                                     auxBusL_[1], auxBusR_[1] };
+    renderChannels_ = sendsActive_ ? RENDER_CHANNELS : 2;
+
+    int active = 0;
+    for (int g = 0; g < MAX_GRAINS; ++g) {
+        if (grains_[g].active) renderSlots_[active++] = g;
+    }
+    if (active < PARALLEL_MIN_GRAINS) {
+        if (filtered) {
+            renderGrainsFiltered(outputL, outputR, numFrames);
+        } else {
+            renderGrains(outputL, outputR, numFrames);
+        }
+        return;
+    }
+
+    // Spread whole quads evenly over the groups
+    int quads = (active + kLanes - 1) / kLanes;
+    int groups = std::min(RENDER_GROUPS, quads);
+    int quad = 0;
+    for (int j = 0; j < groups; ++j) {
+        groupStart_[j] = std::min(quad * kLanes, active);
+        quad += quads / groups + (j < quads % groups ? 1 : 0);
+    }
+    groupStart_[groups] = active;
+
+    renderFrames_ = numFrames;
+    renderPool_.run(&GrainEngine::renderGroupTask, this, groups);
+
+    // Reduce the groups in a fixed order, four frames per vector
+    const int stride = RENDER_CHANNELS * RENDER_CHUNK;
+    for (int c = 0; c < renderChannels_; ++c) {
+        const float* acc = groupAcc_.data() + c * RENDER_CHUNK;
+        float* out = dest[c];
+        int i = 0;
+        for (; i + kLanes <= numFrames; i += kLanes) {
+            f32x4 sum = load(acc + i);
+            for (int j = 1; j < groups; ++j) sum = sum + load(acc + j * stride + i);
+            store(out + i, sum);
+        }
+        for (; i < numFrames; ++i) {
+            float sum = acc[i];
+            for (int j = 1; j < groups; ++j) sum += acc[j * stride + i];
+            out[i] = sum;
+        }
+    }
+}
+
+void GrainEngine::renderGroupTask(void* engine, int group, int worker) {
+    static_cast<GrainEngine*>(engine)->renderGroup(group, worker);
+}
+
+void GrainEngine::renderGroup(int group, int worker) {
+    using namespace simd;
+    const int n = renderFrames_;
+    const int* slots = renderSlots_ + groupStart_[group];
+    const int count = groupStart_[group + 1] - groupStart_[group];
+
+    float* acc = groupAcc_.data() + group * RENDER_CHANNELS * RENDER_CHUNK;
+    float* accL = acc;
+    float* accR = acc + RENDER_CHUNK;
+    float* sendL[NUM_AUX_BUSES] = { acc + 2 * RENDER_CHUNK, acc + 4 * RENDER_CHUNK };
+    float* sendR[NUM_AUX_BUSES] = { acc + 3 * RENDER_CHUNK, acc + 5 * RENDER_CHUNK };
+    std::memset(acc, 0, renderChannels_ * RENDER_CHUNK * sizeof(float));
+
+    if (params_.grainFilterMode > 0) {
+        // Same as renderGrainsFiltered, over this group's quads
+        GrainLaneScratch& scratch = workerScratch_[worker];
+        for (int offset = 0; offset < n; offset += GRAIN_FILTER_CHUNK) {
+            int m = std::min(GRAIN_FILTER_CHUNK, n - offset);
+            std::memset(scratch.accL, 0, m * kLanes * sizeof(float));
+            std::memset(scratch.accR, 0, m * kLanes * sizeof(float));
+            if (sendsActive_) {
+                for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+                    std::memset(scratch.sendL[b], 0, m * kLanes * sizeof(float));
+                    std::memset(scratch.sendR[b], 0, m * kLanes * sizeof(float));
+                }
+            }
+            for (int q = 0; q < count; q += kLanes) {
+                renderFilteredGroup(slots + q, std::min(kLanes, count - q), m, scratch);
+            }
+            for (int i = 0; i < m; ++i) {
+                const float* l = scratch.accL + i * kLanes;
+                const float* r = scratch.accR + i * kLanes;
+                accL[offset + i] = (l[0] + l[1]) + (l[2] + l[3]);
+                accR[offset + i] = (r[0] + r[1]) + (r[2] + r[3]);
+            }
+            if (sendsActive_) {
+                for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+                    for (int i = 0; i < m; ++i) {
+                        const float* l = scratch.sendL[b] + i * kLanes;
+                        const float* r = scratch.sendR[b] + i * kLanes;
+                        sendL[b][offset + i] = (l[0] + l[1]) + (l[2] + l[3]);
+                        sendR[b][offset + i] = (r[0] + r[1]) + (r[2] + r[3]);
+                    }
+                }
+            }
+        }
+        return;
+    }
+
+    // Grain-major: each grain's state stays in registers across the chunk
+    for (int k = 0; k < count; ++k) {
+        Grain& grain = grains_[slots[k]];
+        if (sendsActive_) {
+            for (int i = 0; i < n && grain.active; ++i) {
+                float gL, gR;
+                processGrain(grain, gL, gR);
+                accL[i] += gL;
+                accR[i] += gR;
+                sendL[0][i] += gL * grain.sendDelay;
+                sendR[0][i] += gR * grain.sendDelay;
+                sendL[1][i] += gL * grain.sendReverb;
+                sendR[1][i] += gR * grain.sendReverb;
+            }
+        } else {
+            for (int i = 0; i < n && grain.active; ++i) {
+                float gL, gR;
+                processGrain(grain, gL, gR);
+                accL[i] += gL;
+                accR[i] += gR;
+            }
+        }
+    }
+}
+
+void GrainEngine::renderGrains(float* outputL, float* outputR, int numFrames) {
+    if (sendsActive_) {
+        // Same sum, plus each grain's panned signal scaled into the send buses
+        for (int i = 0; i < numFrames; ++i) {
+            float sumL = 0.0f, sumR = 0.0f;
+            float delayL = 0.0f, delayR = 0.0f;
+            float reverbL = 0.0f, reverbR = 0.0f;
+
+            for (int g = 0; g < MAX_GRAINS; ++g) {
+                Grain& grain = grains_[g];
+                if (!grain.active) continue;
+
+                float gL, gR;
+                processGrain(grain, gL, gR);
+                sumL += gL;
+                sumR += gR;
+                delayL += gL * grain.sendDelay;
+                delayR += gR * grain.sendDelay;
+                reverbL += gL * grain.sendReverb;
+                reverbR += gR * grain.sendReverb;
+            }
+
+            outputL[i] = sumL;
+            outputR[i] = sumR;
+            auxBusL_[0][i] = delayL;
+            auxBusR_[0][i] = delayR;
+            auxBusL_[1][i] = reverbL;
+            auxBusR_[1][i] = reverbR;
+        }
+        return;
     }
 
     // Process all active grains sample-by-sample
@@ -140,144 +1236,182 @@ void GrainEngine::process(float* outputL, float* outputR, int numFrames) {
         outputL[i] = sumL;
         outputR[i] = sumR;
     }
+}
+
+void GrainEngine::renderGrainsSpectral(float* outputL, float* outputR, int numFrames) {
+    if (!spectralActive_) {
+        // Don't replay a hop left over from an earlier spectral run
+        spectral_.reset();
+        spectralActive_ = true;
+    }
 
-    currentTime_ = blockEndTime;
+    // Synthesis runs hop by hop; blocks read whatever the last hop produced
+    int done = 0;
+    while (done < numFrames) {
+        if (spectral_.available() == 0) synthesizeSpectralHop();
+        int n = std::min(spectral_.available(), numFrames - done);
+        spectral_.read(outputL + done, outputR + done, n);
+        done += n;
+    }
 }
 
-void GrainEngine::spawnGrain() {
-    // Find an inactive grain slot
-    int slot = -1;
-    int oldestSlot = -1;
-    int32_t leastRemaining = INT32_MAX;
+void GrainEngine::synthesizeSpectralHop() {
+    constexpr int hop = SpectralGranulator::kHop;
+    const float formant = std::max(0.0f, std::min(1.0f, params_.spectralFormant));
+    const float smear = std::max(0.0f, std::min(1.0f, params_.spectralSmear));
+    const float length = static_cast<float>(sampleBufferLength_);
 
-    for (int i = 0; i < MAX_GRAINS; ++i) {
-        if (!grains_[i].active) {
-            slot = i;
-            break;
+    for (int g = 0; g < MAX_GRAINS; ++g) {
+        Grain& grain = grains_[g];
+        if (!grain.active) continue;
+
+        if (!grain.spectralStarted) {
+            spectral_.startGrain(g, rng_);
+            grain.spectralStarted = true;
         }
-        // Track oldest for stealing
-        if (grains_[i].samplesRemaining < leastRemaining) {
-            leastRemaining = grains_[i].samplesRemaining;
-            oldestSlot = i;
+
+        // Envelope (and note gain) at the middle of the hop
+        Grain mid = grain;
+        mid.envPhase += grain.envIncrement * (0.5f * hop);
+        float env = computeEnvelope(mid) *
+                    std::max(0.0f, grain.gain + grain.gainStep * (0.5f * hop));
+
+        // |rate| is the pitch ratio; the frames themselves play at unity speed
+        float rate = grain.playbackRate;
+        spectral_.addGrain(g, grain.position, std::fabs(rate),
+                           env * grain.panL, env * grain.panR, formant, smear, rng_);
+
+        // Walk the frames forward (or backward when reversed); freeze holds them
+        if (!isFrozen_) grain.position += (rate < 0.0f) ? -hop : hop;
+        grain.envPhase += grain.envIncrement * hop;
+        grain.gain += grain.gainStep * hop;
+        grain.samplesRemaining -= hop;
+        if (grain.samplesRemaining <= 0) {
+            grain.active = false;
+        } else if (grain.position < 0.0f || grain.position >= length) {
+            grain.active = false;
+            grain.endsAtEdge = true;
         }
     }
 
-    // Steal oldest if no free slot
-    if (slot < 0) {
-        slot = oldestSlot;
-        if (slot < 0) return; // Should never happen with MAX_GRAINS > 0
+    spectral_.finishHop();
+}
+
+void GrainEngine::renderGrainsFiltered(float* outputL, float* outputR, int numFrames) {
+    using namespace simd;
+    GrainLaneScratch& scratch = laneScratch_;
+
+    for (int offset = 0; offset < numFrames; offset += GRAIN_FILTER_CHUNK) {
+        int n = std::min(GRAIN_FILTER_CHUNK, numFrames - offset);
+        std::memset(scratch.accL, 0, n * kLanes * sizeof(float));
+        std::memset(scratch.accR, 0, n * kLanes * sizeof(float));
+        if (sendsActive_) {
+            for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+                std::memset(scratch.sendL[b], 0, n * kLanes * sizeof(float));
+                std::memset(scratch.sendR[b], 0, n * kLanes * sizeof(float));
+            }
+        }
+
+        // Walk the pool in groups of four active grains
+        int group[kLanes];
+        int groupSize = 0;
+        for (int g = 0; g < MAX_GRAINS; ++g) {
+            if (!grains_[g].active) continue;
+            group[groupSize++] = g;
+            if (groupSize == kLanes) {
+                renderFilteredGroup(group, groupSize, n, scratch);
+                groupSize = 0;
+            }
+        }
+        if (groupSize > 0) {
+            renderFilteredGroup(group, groupSize, n, scratch);
+        }
+
+        // Reduce the four lane accumulators into the stereo output
+        for (int i = 0; i < n; ++i) {
+            const float* l = scratch.accL + i * kLanes;
+            const float* r = scratch.accR + i * kLanes;
+            outputL[offset + i] = (l[0] + l[1]) + (l[2] + l[3]);
+            outputR[offset + i] = (r[0] + r[1]) + (r[2] + r[3]);
+        }
+        if (sendsActive_) {
+            for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+                for (int i = 0; i < n; ++i) {
+                    const float* l = scratch.sendL[b] + i * kLanes;
+                    const float* r = scratch.sendR[b] + i * kLanes;
+                    auxBusL_[b][offset + i] = (l[0] + l[1]) + (l[2] + l[3]);
+                    auxBusR_[b][offset + i] = (r[0] + r[1]) + (r[2] + r[3]);
+                }
+            }
+        }
     }
+}
 
-    Grain& grain = grains_[slot];
+void GrainEngine::renderFilteredGroup(const int* group, int groupSize, int numFrames,
+                                      GrainLaneScratch& scratch) {
+    using namespace simd;
+    int slots[kLanes];
+    alignas(16) float panL[kLanes];
+    alignas(16) float panR[kLanes];
+    alignas(16) float send[NUM_AUX_BUSES][kLanes];
+
+    // Render each grain's dry mono signal into its lane
+    for (int l = 0; l < kLanes; ++l) {
+        if (l >= groupSize) {
+            slots[l] = GrainFilterBank::kDummySlot;
+            panL[l] = panR[l] = 0.0f;
+            send[0][l] = send[1][l] = 0.0f;
+            for (int i = 0; i < numFrames; ++i) scratch.lanes[i * kLanes + l] = 0.0f;
+            continue;
+        }
 
-    // Get modulated parameters (using smoothed values for continuous params)
-    float grainSize = getModulated(grainSizeSmoother_.getCurrent(), LFO_GRAIN_SIZE,
-                                   ModScales::grainSize, 0.01f, 0.5f);
-    float spread = getModulated(params_.spread, LFO_SPREAD,
-                                ModScales::spread, 0.0f, 2.0f);
-    float pitch = getModulated(pitchSmoother_.getCurrent(), LFO_PITCH,
-                               ModScales::pitch, -24.0f, 24.0f);
-    float fmFreq = getModulated(params_.fmFreq, LFO_FM_FREQ,
-                                ModScales::fmFreq, 0.0f, 1000.0f);
-    float fmAmount = getModulated(params_.fmAmount, LFO_FM_AMOUNT,
-                                  ModScales::fmAmount, 0.0f, 100.0f);
-    float attack = getModulated(params_.attack, LFO_ATTACK,
-                                ModScales::attack, 0.01f, 0.9f);
-    float release = getModulated(params_.release, LFO_RELEASE,
-                                 ModScales::release, 0.01f, 0.9f);
-    float panCenter = getModulated(panSmoother_.getCurrent(), LFO_PAN,
-                                   ModScales::pan, -1.0f, 1.0f);
-    float panSpread = getModulated(params_.panSpread, LFO_PAN_SPREAD,
-                                   ModScales::panSpread, 0.0f, 1.0f);
+        Grain& grain = grains_[group[l]];
+        slots[l] = group[l];
+        panL[l] = grain.panL;
+        panR[l] = grain.panR;
+        send[0][l] = grain.sendDelay;
+        send[1][l] = grain.sendReverb;
+        for (int i = 0; i < numFrames; ++i) {
+            scratch.lanes[i * kLanes + l] = grain.active ? renderGrainSample(grain) : 0.0f;
+        }
+    }
 
-    // Position: frozen > drift > manual (use smoothed position for manual)
-    float basePosition = isFrozen_ ? frozenPosition_ :
-                         (isDrifting_ ? driftPosition_ : positionSmoother_.getCurrent());
-    float position = getModulated(basePosition, LFO_POSITION,
-                                  ModScales::position, 0.0f, 1.0f);
+    grainFilters_.processGroup(slots, scratch.lanes, numFrames);
 
-    // Calculate grain duration in samples
-    float grainDuration = std::max(0.01f, grainSize);
-    int totalSamples = static_cast<int>(grainDuration * sampleRate_);
-    if (totalSamples < 1) totalSamples = 1;
-
-    // Calculate playback rate from pitch + detune + FM
-    float cents = pitch * 100.0f +
-                  (randomFloat() * params_.detune * 2.0f - params_.detune);
-    float rate = std::pow(2.0f, cents / 1200.0f);
-
-    // Grain reversal
-    bool reversed = randomFloat() < params_.grainReversalChance;
-    if (reversed) {
-        rate = -rate;
-    }
-
-    // FM modulation
-    float fmMod = 0.0f;
-    if (fmAmount > 0.0f) {
-        fmMod = std::sin(static_cast<float>(currentTime_) * fmFreq) * (fmAmount * 0.01f);
-    }
-    float finalRate = std::max(0.1f, std::abs(rate + fmMod));
-    if (reversed) finalRate = -finalRate;
-
-    // Calculate start position in the buffer
-    float bufferDurationSec = static_cast<float>(sampleBufferLength_) * invSampleRate_;
-    float centerSample = position * static_cast<float>(sampleBufferLength_);
-    float randomOffset = (randomFloat() * 2.0f - 1.0f) * spread *
-                         static_cast<float>(sampleBufferLength_) * 0.5f;
-    float startSample = centerSample + randomOffset;
-
-    // Clamp to buffer bounds
-    float maxStart = static_cast<float>(sampleBufferLength_) -
-                     grainDuration * sampleRate_ * std::abs(finalRate);
-    startSample = std::max(0.0f, std::min(startSample, std::max(0.0f, maxStart)));
-
-    // For reversed grains, start at the end of the region
-    if (reversed) {
-        startSample = std::min(startSample + grainDuration * sampleRate_,
-                               static_cast<float>(sampleBufferLength_ - 1));
-    }
-
-    // Calculate pan
-    float randomPan = (randomFloat() * 2.0f - 1.0f) * panSpread;
-    float finalPan = std::max(-1.0f, std::min(1.0f, panCenter + randomPan));
-
-    // Equal-power panning (constant-power stereo pan law)
-    float panAngle = (finalPan + 1.0f) * 0.25f * static_cast<float>(M_PI);
-    float panL = std::cos(panAngle);
-    float panR = std::sin(panAngle);
-
-    // Fill grain struct
-    grain.active = true;
-    grain.position = startSample;
-    grain.playbackRate = finalRate;
-    grain.totalSamples = totalSamples;
-    grain.samplesRemaining = totalSamples;
-    grain.envPhase = 0.0f;
-    grain.envIncrement = 1.0f / static_cast<float>(totalSamples);
-    grain.attackRatio = attack;
-    grain.releaseRatio = release;
-    grain.exponentialEnv = (params_.envelopeCurve == 1);
-    grain.panL = panL;
-    grain.panR = panR;
-
-    // Store visualization data
-    grain.normPos = (bufferDurationSec > 0.0f)
-        ? (startSample / static_cast<float>(sampleBufferLength_))
-        : 0.0f;
-    grain.duration = grainDuration;
-    grain.pan = finalPan;
-
-    // Emit grain event
-    if (grainEventCount_ < MAX_GRAIN_EVENTS) {
-        grainEvents_[grainEventCount_].normPos = grain.normPos;
-        grainEvents_[grainEventCount_].duration = grain.duration;
-        grainEvents_[grainEventCount_].pan = grain.pan;
-        grainEventCount_++;
+    // Pan and accumulate
+    const f32x4 gainL = load(panL);
+    const f32x4 gainR = load(panR);
+    for (int i = 0; i < numFrames; ++i) {
+        f32x4 x = load(scratch.lanes + i * kLanes);
+        store(scratch.accL + i * kLanes, load(scratch.accL + i * kLanes) + x * gainL);
+        store(scratch.accR + i * kLanes, load(scratch.accR + i * kLanes) + x * gainR);
+    }
+
+    // Sends take the panned signal, scaled per grain
+    if (sendsActive_) {
+        for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+            const f32x4 sendL = gainL * load(send[b]);
+            const f32x4 sendR = gainR * load(send[b]);
+            float* accL = scratch.sendL[b];
+            float* accR = scratch.sendR[b];
+            for (int i = 0; i < numFrames; ++i) {
+                f32x4 x = load(scratch.lanes + i * kLanes);
+                store(accL + i * kLanes, load(accL + i * kLanes) + x * sendL);
+                store(accR + i * kLanes, load(accR + i * kLanes) + x * sendR);
+            }
+        }
     }
 }
 
 void GrainEngine::processGrain(Grain& grain, float& outL, float& outR) {
+    float sample = renderGrainSample(grain);
+
+    // Apply panning
+    outL = sample * grain.panL;
+    outR = sample * grain.panR;
+}
+
+float GrainEngine::renderGrainSample(Grain& grain) {
     // Read sample from buffer with linear interpolation
     float sample = 0.0f;
     float pos = grain.position;
@@ -285,31 +1419,33 @@ void GrainEngine::processGrain(Grain& grain, float& outL, float& outR) {
     if (pos >= 0.0f && pos < static_cast<float>(sampleBufferLength_ - 1)) {
         int idx = static_cast<int>(pos);
         float frac = pos - static_cast<float>(idx);
-        sample = sampleBuffer_[idx] * (1.0f - frac) +
-                 sampleBuffer_[idx + 1] * frac;
+        sample = sampleData_[idx] * (1.0f - frac) +
+                 sampleData_[idx + 1] * frac;
     } else if (pos >= 0.0f && pos < static_cast<float>(sampleBufferLength_)) {
-        sample = sampleBuffer_[static_cast<int>(pos)];
+        sample = sampleData_[static_cast<int>(pos)];
     }
 
-    // Apply envelope
+    // Apply envelope (and the note gain ramp)
     float env = computeEnvelope(grain);
-    sample *= env;
-
-    // Apply panning
-    outL = sample * grain.panL;
-    outR = sample * grain.panR;
+    sample *= env * grain.gain;
 
     // Advance position and envelope
     grain.position += grain.playbackRate;
     grain.envPhase += grain.envIncrement;
+    grain.gain += grain.gainStep;
     grain.samplesRemaining--;
 
-    // Deactivate when done or out of bounds
-    if (grain.samplesRemaining <= 0 ||
-        grain.position < 0.0f ||
-        grain.position >= static_cast<float>(sampleBufferLength_)) {
+    // Deactivate when done (the count already stops at the buffer edge,
+    // except for grains carried over from spectral rendering)
+    if (grain.samplesRemaining <= 0) {
         grain.active = false;
+    } else if (grain.testsEdges &&
+               (grain.position < 0.0f || grain.position >= static_cast<float>(sampleBufferLength_))) {
+        grain.active = false;
+        grain.endsAtEdge = true;
     }
+
+    return sample;
 }
 
 float GrainEngine::computeEnvelope(const Grain& grain) const {
@@ -354,15 +1490,190 @@ float GrainEngine::computeEnvelope(const Grain& grain) const {
 
 float GrainEngine::getModulated(float base, uint32_t targetBit, float scale,
                                 float minVal, float maxVal) const {
+    return modulate(base, targetBit, scale, minVal, maxVal, currentLfoValue_);
+}
+
+float GrainEngine::modulate(float base, uint32_t targetBit, float scale,
+                            float minVal, float maxVal, float lfoValue) const {
     if (!(params_.lfoTargetMask & targetBit)) return base;
-    float val = base + (currentLfoValue_ * params_.lfoAmount * scale);
+    float val = base + (lfoValue * params_.lfoAmount * scale);
     return std::max(minVal, std::min(maxVal, val));
 }
 
+void GrainEngine::processFxChain(float* outputL, float* outputR, int numFrames) {
+    // Run every stage over one chunk before moving on, so long host blocks
+    // don't stream the whole buffer through memory once per stage
+    for (int offset = 0; offset < numFrames; offset += FX_CHUNK_SIZE) {
+        int n = std::min(FX_CHUNK_SIZE, numFrames - offset);
+        double startTime = currentTime_ + offset * invSampleRate_;
+        float* left = outputL + offset;
+        float* right = outputR + offset;
+
+        processFilter(left, right, n, startTime);
+        processDistortion(left, right, n, startTime);
+        processDelay(left, right, n, startTime);
+        processReverb(left, right, n);
+        processGain(left, right, n);
+        processLimiter(left, right, n);
+    }
+}
+
+void GrainEngine::processSendChain(float* outputL, float* outputR, int numFrames,
+                                   int auxOffset) {
+    const bool external = params_.fxRouting == 2;
+    sendsActive_ = true;
+
+    for (int offset = 0; offset < numFrames; offset += FX_CHUNK_SIZE) {
+        int n = std::min(FX_CHUNK_SIZE, numFrames - offset);
+        double startTime = currentTime_ + offset * invSampleRate_;
+        float* left = outputL + offset;
+        float* right = outputR + offset;
+
+        renderMix(left, right, n);
+        processFilter(left, right, n, startTime);
+        processDistortion(left, right, n, startTime);
+        if (!external) {
+            processDelay(left, right, n, startTime, auxBusL_[0], auxBusR_[0]);
+            processReverb(left, right, n, auxBusL_[1], auxBusR_[1]);
+        }
+        processGain(left, right, n, external);
+        processLimiter(left, right, n);
+
+        // Keep the buses aligned with the limited main output
+        const int latency = limiter_.getModeLatency();
+        for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+            auxAligners_[b].process(auxBusL_[b], auxBusR_[b], n, latency);
+        }
+
+        // Expose the buses (as far as the aux outputs reach)
+        int at = auxOffset + offset;
+        int copy = std::min(n, maxBlockSize_ - at);
+        if (copy > 0) {
+            for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+                std::memcpy(auxOutL_[b].data() + at, auxBusL_[b], copy * sizeof(float));
+                std::memcpy(auxOutR_[b].data() + at, auxBusR_[b], copy * sizeof(float));
+            }
+        }
+    }
+
+    sendsActive_ = false;
+}
+
+bool GrainEngine::auxBusIdle(int bus, int numFrames, int tailFrames) {
+    float peak = 0.0f;
+    for (int i = 0; i < numFrames; ++i) {
+        peak = std::max(peak, std::max(std::fabs(auxBusL_[bus][i]), std::fabs(auxBusR_[bus][i])));
+    }
+    if (peak > 1e-9f) {
+        auxIdleFrames_[bus] = 0;
+        return false;
+    }
+    if (auxIdleFrames_[bus] <= tailFrames) auxIdleFrames_[bus] += numFrames;
+    return auxIdleFrames_[bus] > tailFrames;
+}
+
+void GrainEngine::processFilter(float* outputL, float* outputR, int numFrames, double startTime) {
+    // Auto-bypass: a lowpass parked at the top of its range with no resonance
+    // is inaudible, so the default patch skips the filter entirely
+    bool modulated = (params_.lfoTargetMask & (LFO_FILTER_FREQ | LFO_FILTER_RES)) &&
+                     params_.lfoAmount > 0.0f;
+    bool open = params_.filterType == 0 && params_.filterFreq >= 20000.0f &&
+                params_.filterRes <= 0.0f && !modulated &&
+                filterFreqSmoother_.getCurrent() >= 19990.0f &&
+                filterResSmoother_.getCurrent() <= 0.01f;
+    if (open && !filterActive_) return;
+
+    // Entering or leaving bypass: crossfade against the dry signal over this
+    // chunk, since even an open filter has some phase shift
+    bool fadeIn = !filterActive_;
+    bool fadeOut = open;
+    if (fadeIn) {
+        filter_.reset();
+        filterActive_ = true;
+    }
+    if (fadeIn || fadeOut) {
+        std::memcpy(filterDryL_, outputL, numFrames * sizeof(float));
+        std::memcpy(filterDryR_, outputR, numFrames * sizeof(float));
+    }
+
+    for (int offset = 0; offset < numFrames; offset += CONTROL_BLOCK_SIZE) {
+        int n = std::min(CONTROL_BLOCK_SIZE, numFrames - offset);
+        for (int i = 0; i < n; ++i) {
+            filterFreqSmoother_.process();
+            filterResSmoother_.process();
+        }
+
+        // Sample the LFO per sub-block so sweeps stay in step with the grains
+        float lfoValue = lfo_.getValue(static_cast<float>(startTime + offset * invSampleRate_));
+        float cutoff = modulate(filterFreqSmoother_.getCurrent(), LFO_FILTER_FREQ,
+                                ModScales::filterFreq, 20.0f, 20000.0f, lfoValue);
+        float res = modulate(filterResSmoother_.getCurrent(), LFO_FILTER_RES,
+                             ModScales::filterRes, 0.0f, 20.0f, lfoValue);
+
+        // Resonance reads like BiquadFilterNode.Q: dB for lowpass and
+        // highpass (linear Q = 10^(dB / 20)), linear Q for bandpass and notch
+        FilterMode mode = filter_.getMode();
+        bool linearQ = mode == FilterMode::Bandpass || mode == FilterMode::Notch;
+        float q = linearQ ? res : fastmath::exp2(res * 0.16609640f);
+        filter_.setCoefficients(cutoff, q, sampleRate_);
+        filter_.process(outputL + offset, outputR + offset, n);
+    }
+
+    if (fadeIn || fadeOut) {
+        float step = 1.0f / numFrames;
+        for (int i = 0; i < numFrames; ++i) {
+            float wet = (i + 1) * step;
+            if (fadeOut) wet = 1.0f - wet;
+            outputL[i] = filterDryL_[i] + (outputL[i] - filterDryL_[i]) * wet;
+            outputR[i] = filterDryR_[i] + (outputR[i] - filterDryR_[i]) * wet;
+        }
+    }
+    if (fadeOut) {
+        filterFreqSmoother_.setImmediate(params_.filterFreq);
+        filterResSmoother_.setImmediate(params_.filterRes);
+        filterActive_ = false;
+    }
+}
+
+void GrainEngine::setMorphSnapshot(int index, const EngineParams& params) {
+    morph_.setSnapshot(index, params);
+    appliedMorphPosition_ = -1.0f; // Force a re-blend
+}
+
+void GrainEngine::clearMorphSnapshots() {
+    morph_.clear();
+    morphActive_ = false;
+}
+
+void GrainEngine::setMorphPosition(float position) {
+    if (!morph_.isReady()) return;
+    position = std::max(0.0f, std::min(1.0f, position));
+    if (!morphActive_) {
+        morphSmoother_.setImmediate(position);
+        appliedMorphPosition_ = -1.0f;
+    }
+    morphSmoother_.setTarget(position);
+    morphActive_ = true;
+}
+
+void GrainEngine::updateMorph(int numFrames) {
+    for (int i = 0; i < numFrames; ++i) {
+        morphSmoother_.process();
+    }
+
+    // Skip the blend entirely while the position is at rest
+    float position = morphSmoother_.getCurrent();
+    if (std::fabs(position - appliedMorphPosition_) < 1e-5f) return;
+    appliedMorphPosition_ = position;
+
+    morph_.blend(position, morphedParams_);
+    updateParams(morphedParams_);
+}
+
 void GrainEngine::updateDrift(float deltaTimeSec) {
     // Random walk step
     float stepSize = driftSpeed_ * deltaTimeSec * 0.5f;
-    float randomStep = (randomFloat() - 0.5f) * 2.0f * stepSize;
+    float randomStep = (rng_.nextFloat(RngStream::Drift) - 0.5f) * 2.0f * stepSize;
 
     // Pull back toward base position
     float distanceFromBase = driftBasePosition_ - driftPosition_;
@@ -413,22 +1724,664 @@ void GrainEngine::clearGrainEvents() {
     grainEventCount_ = 0;
 }
 
+void GrainEngine::setSeed(uint32_t seed) {
+    rng_.setSeed(seed);
+}
+
+uint32_t GrainEngine::getSeed() const {
+    return rng_.getSeed();
+}
+
+void GrainEngine::saveState(EngineSnapshot& snapshot) const {
+    EngineSnapshot& s = snapshot;
+    s.header.magic = ENGINE_SNAPSHOT_MAGIC;
+    s.header.version = ENGINE_SNAPSHOT_VERSION;
+    s.header.size = sizeof(EngineSnapshot);
+    s.header.maxGrains = MAX_GRAINS;
+    s.header.sampleRate = sampleRate_;
+    s.header.sampleLength = sampleBufferLength_;
+
+    s.playing = isPlaying_;
+    s.currentTime = currentTime_;
+    s.nextGrainTime = nextGrainTime_;
+
+    s.params = params_;
+    s.morph = morph_;
+    s.morphSmoother = morphSmoother_;
+    s.morphActive = morphActive_;
+    s.appliedMorphPosition = appliedMorphPosition_;
+
+    s.pitch = pitchSmoother_;
+    s.position = positionSmoother_;
+    s.grainSize = grainSizeSmoother_;
+    s.pan = panSmoother_;
+    s.volume = volumeSmoother_;
+    s.filterFreq = filterFreqSmoother_;
+    s.filterRes = filterResSmoother_;
+    s.distAmount = distAmountSmoother_;
+    s.delayTime = delayTimeSmoother_;
+    s.delayFeedback = delayFeedbackSmoother_;
+    s.delayMix = delayMixSmoother_;
+    s.reverbMix = reverbMixSmoother_;
+
+    s.frozen = isFrozen_;
+    s.frozenPosition = frozenPosition_;
+    s.drifting = isDrifting_;
+    s.driftPosition = driftPosition_;
+    s.driftBasePosition = driftBasePosition_;
+    s.driftSpeed = driftSpeed_;
+    s.driftReturnTendency = driftReturnTendency_;
+
+    s.rng = rng_;
+
+    s.grainLimit = grainLimit_;
+    std::memcpy(s.grains, grains_, sizeof(grains_));
+    s.grainFilters = grainFilters_;
+    std::copy(notes_, notes_ + MAX_NOTES, s.notes);
+    s.polyphonic = polyphonic_;
+    s.fadingGrains = fadingGrains_;
+    s.noteCounter = noteCounter_;
+}
+
+bool GrainEngine::restoreState(const EngineSnapshot& snapshot) {
+    const EngineSnapshot& s = snapshot;
+    if (s.header.magic != ENGINE_SNAPSHOT_MAGIC || s.header.version != ENGINE_SNAPSHOT_VERSION ||
+        s.header.size != sizeof(EngineSnapshot) || s.header.maxGrains != MAX_GRAINS ||
+        s.header.sampleRate != sampleRate_) {
+        return false;
+    }
+
+    // Params first: they re-derive the LFO, filter modes, FX settings and
+    // note envelope times. The saved smoothers and voices then replace what
+    // this retargets, and the spawn cache is rebuilt from the restored inputs.
+    paramsValid_ = false;
+    updateParams(s.params);
+    spawnCacheValid_ = false;
+
+    isPlaying_ = s.playing;
+    currentTime_ = s.currentTime;
+    nextGrainTime_ = s.nextGrainTime;
+
+    morph_ = s.morph;
+    morphSmoother_ = s.morphSmoother;
+    morphActive_ = s.morphActive;
+    appliedMorphPosition_ = s.appliedMorphPosition;
+
+    pitchSmoother_ = s.pitch;
+    positionSmoother_ = s.position;
+    grainSizeSmoother_ = s.grainSize;
+    panSmoother_ = s.pan;
+    volumeSmoother_ = s.volume;
+    filterFreqSmoother_ = s.filterFreq;
+    filterResSmoother_ = s.filterRes;
+    distAmountSmoother_ = s.distAmount;
+    delayTimeSmoother_ = s.delayTime;
+    delayFeedbackSmoother_ = s.delayFeedback;
+    delayMixSmoother_ = s.delayMix;
+    reverbMixSmoother_ = s.reverbMix;
+
+    isFrozen_ = s.frozen;
+    frozenPosition_ = s.frozenPosition;
+    isDrifting_ = s.drifting;
+    driftPosition_ = s.driftPosition;
+    driftBasePosition_ = s.driftBasePosition;
+    driftSpeed_ = s.driftSpeed;
+    driftReturnTendency_ = s.driftReturnTendency;
+
+    rng_ = s.rng;
+
+    grainLimit_ = s.grainLimit;
+    std::copy(s.notes, s.notes + MAX_NOTES, notes_);
+    polyphonic_ = s.polyphonic;
+    fadingGrains_ = s.fadingGrains;
+    noteCounter_ = s.noteCounter;
+
+    // Grains only make sense over the sample they were reading
+    if (s.header.sampleLength == sampleBufferLength_) {
+        std::memcpy(grains_, s.grains, sizeof(grains_));
+        grainFilters_ = s.grainFilters;
+    } else {
+        for (Grain& grain : grains_) grain.active = false;
+    }
+
+    // Spectral phases live in the granulator: restart them per grain. The
+    // lifetimes may be for either render path, so the next render retimes.
+    for (Grain& grain : grains_) grain.spectralStarted = false;
+    spectralActive_ = false;
+    lifetimesSpectral_ = -1;
+    return true;
+}
+
+uintptr_t GrainEngine::captureState() {
+    uintptr_t buffer = getStateBuffer();
+    saveState(*stateBuffer_);
+    return buffer;
+}
+
+uintptr_t GrainEngine::getStateBuffer() {
+    if (!stateBuffer_) stateBuffer_ = std::make_unique<EngineSnapshot>();
+    return reinterpret_cast<uintptr_t>(stateBuffer_.get());
+}
+
+bool GrainEngine::restoreStateBuffer() {
+    return stateBuffer_ && restoreState(*stateBuffer_);
+}
+
+int GrainEngine::getStateSize() const {
+    return static_cast<int>(sizeof(EngineSnapshot));
+}
+
+float* GrainEngine::allocateImpulseBuffer(int lengthInSamples, int channels) {
+    delete[] impulseStaging_;
+    impulseStagingChannels_ = std::max(1, std::min(2, channels));
+    impulseStagingLength_ = std::max(1, lengthInSamples);
+    impulseStaging_ = new float[impulseStagingLength_ * impulseStagingChannels_]();
+    return impulseStaging_;
+}
+
+ConvolverCost GrainEngine::commitImpulseBuffer() {
+    collectRetiredConvolver();
+    if (!impulseStaging_) return impulseCost_;
+
+    auto* convolver = new PartitionedConvolver();
+    if (convolver->preparePlanar(impulseStaging_, impulseStagingChannels_, impulseStagingLength_)) {
+        publishConvolver(convolver);
+    } else {
+        delete convolver;
+    }
+
+    delete[] impulseStaging_;
+    impulseStaging_ = nullptr;
+    return impulseCost_;
+}
+
+float* GrainEngine::allocateImpulseSpectra(int partitions, int channels) {
+    delete impulseSpectraStaging_;
+    impulseSpectraStaging_ = new PartitionedConvolver();
+    return impulseSpectraStaging_->allocate(channels, partitions);
+}
+
+int GrainEngine::getImpulseSpectraSize() const {
+    return impulseSpectraStaging_ ? static_cast<int>(impulseSpectraStaging_->getSpectraSize()) : 0;
+}
+
+ConvolverCost GrainEngine::commitImpulseSpectra() {
+    collectRetiredConvolver();
+    if (!impulseSpectraStaging_) return impulseCost_;
+    publishConvolver(impulseSpectraStaging_);
+    impulseSpectraStaging_ = nullptr;
+    return impulseCost_;
+}
+
+ConvolverCost GrainEngine::publishConvolver(PartitionedConvolver* convolver) {
+    impulseCost_ = convolver->estimateCost(sampleRate_);
+    // Replace (and free) an IR the audio thread has not picked up yet
+    delete pendingConvolver_.exchange(convolver, std::memory_order_acq_rel);
+    return impulseCost_;
+}
+
+void GrainEngine::clearImpulseResponse() {
+    collectRetiredConvolver();
+    delete pendingConvolver_.exchange(nullptr, std::memory_order_acq_rel);
+    clearConvolverRequested_.store(true, std::memory_order_release);
+    impulseCost_ = ConvolverCost{};
+}
+
+ConvolverCost GrainEngine::getImpulseCost() const {
+    return impulseCost_;
+}
+
+void GrainEngine::acquirePendingConvolver() {
+    // Only one convolver can wait for collection; hold off until it is freed
+    if (retiredConvolver_.load(std::memory_order_acquire) != nullptr) return;
+
+    if (clearConvolverRequested_.exchange(false, std::memory_order_acq_rel)) {
+        retiredConvolver_.store(convolver_, std::memory_order_release);
+        convolver_ = nullptr;
+        return;
+    }
+
+    if (pendingConvolver_.load(std::memory_order_relaxed) == nullptr) return;
+    PartitionedConvolver* next = pendingConvolver_.exchange(nullptr, std::memory_order_acq_rel);
+    if (next) {
+        retiredConvolver_.store(convolver_, std::memory_order_release);
+        convolver_ = next;   // Prepared with clean state
+    }
+}
+
+void GrainEngine::collectRetiredConvolver() {
+    delete retiredConvolver_.exchange(nullptr, std::memory_order_acq_rel);
+}
+
 float* GrainEngine::getOutputBufferL() {
-    return outputL_;
+    return outputL_.data();
 }
 
 float* GrainEngine::getOutputBufferR() {
-    return outputR_;
+    return outputR_.data();
+}
+
+float* GrainEngine::getAuxBufferL(int bus) {
+    return auxOutL_[std::max(0, std::min(NUM_AUX_BUSES - 1, bus))].data();
+}
+
+float* GrainEngine::getAuxBufferR(int bus) {
+    return auxOutR_[std::max(0, std::min(NUM_AUX_BUSES - 1, bus))].data();
+}
+
+void GrainEngine::setRenderThreads(int count) {
+    renderPool_.start(std::max(0, count));
+    renderThreads_ = renderPool_.getNumWorkers() - 1;
+    workerScratch_.resize(renderThreads_ + 1);
+    groupAcc_.assign(static_cast<size_t>(RENDER_GROUPS) * RENDER_CHANNELS * RENDER_CHUNK, 0.0f);
+}
+
+int GrainEngine::getRenderThreads() const {
+    return renderThreads_;
 }
 
-// Fast xorshift32 PRNG
-uint32_t GrainEngine::randomUint() {
-    rngState_ ^= rngState_ << 13;
-    rngState_ ^= rngState_ >> 17;
-    rngState_ ^= rngState_ << 5;
-    return rngState_;
+void GrainEngine::setGrainLimit(int limit) {
+    grainLimit_ = std::max(0, std::min(MAX_GRAINS, limit));
 }
 
-float GrainEngine::randomFloat() {
-    return static_cast<float>(randomUint()) / 4294967296.0f;
+int GrainEngine::getGrainLimit() const {
+    return grainLimit_;
 }
+
+void GrainEngine::setLimiterBypass(bool bypass) {
+    limiterBypassed_ = bypass;
+}
+
+void GrainEngine::setCpuBudget(float fraction) {
+    governor_.setBudget(fraction);
+    governorCap_ = governor_.getCap();
+}
+
+float GrainEngine::getCpuBudget() const {
+    return governor_.getBudget();
+}
+
+void GrainEngine::setTelemetryEnabled(bool enabled) {
+    if (enabled && !telemetryEnabled_) {
+        spawnCount_ = stealCount_ = 0;
+        endsNatural_ = endsBoundary_ = endsFaded_ = 0;
+        blockCount_ = 0;
+        std::fill(costHistogram_, costHistogram_ + TELEMETRY_COST_BINS, 0u);
+    }
+    telemetryEnabled_ = enabled;
+}
+
+uintptr_t GrainEngine::getTelemetryBuffer() {
+    return reinterpret_cast<uintptr_t>(&telemetry_);
+}
+
+int GrainEngine::getTelemetrySize() const {
+    return static_cast<int>(sizeof(EngineTelemetry));
+}
+
+void GrainEngine::publishTelemetry(const float* outputL, const float* outputR, int numFrames,
+                                   double costMs) {
+    const double blockMs = numFrames * invSampleRate_ * 1000.0;
+    const float load = static_cast<float>(costMs / blockMs);
+    const int bin = std::min(TELEMETRY_COST_BINS - 1,
+                             static_cast<int>(load * TELEMETRY_BINS_PER_BLOCK));
+    blockCount_++;
+    costHistogram_[bin]++;
+
+    int active = 0;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (grains_[i].active) active++;
+    }
+    float peak[2] = { 0.0f, 0.0f };
+    float sumSquares[2] = { 0.0f, 0.0f };
+    const float* outputs[2] = { outputL, outputR };
+    for (int c = 0; c < 2; ++c) {
+        for (int i = 0; i < numFrames; ++i) {
+            const float x = outputs[c][i];
+            peak[c] = std::max(peak[c], std::fabs(x));
+            sumSquares[c] += x * x;
+        }
+    }
+
+    // Seqlock write: odd while the fields change
+    EngineTelemetry& t = telemetry_;
+    const uint32_t sequence = t.sequence.load(std::memory_order_relaxed);
+    t.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    t.blocks = blockCount_;
+    t.activeGrains = active;
+    t.grainCap = grainCap();
+    t.spawns = spawnCount_;
+    t.steals = stealCount_;
+    t.endsNatural = endsNatural_;
+    t.endsBoundary = endsBoundary_;
+    t.endsFaded = endsFaded_;
+    t.spawnMs = static_cast<float>(spawnMs_);
+    t.renderMs = static_cast<float>(renderMs_);
+    t.fxMs = static_cast<float>(fxMs_);
+    t.blockLoad = load;
+    for (int c = 0; c < 2; ++c) {
+        t.peak[c] = peak[c];
+        t.rms[c] = std::sqrt(sumSquares[c] / numFrames);
+    }
+    std::copy(costHistogram_, costHistogram_ + TELEMETRY_COST_BINS, t.costHistogram);
+
+    t.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+int GrainEngine::getGrainDemand() const {
+    if (!isPlaying_ || !sampleData_ || !spawnCacheValid_) return 0;
+    // Steady state: one grain per density interval, each lasting grainDuration
+    float overlap = spawnParams_.grainDuration / std::max(spawnParams_.density, 1e-6f);
+    if (polyphonic_) overlap *= static_cast<float>(getActiveNoteCount());
+    return static_cast<int>(std::min(static_cast<float>(MAX_GRAINS), std::ceil(overlap)));
+}
+
+void GrainEngine::setPolyphonic(bool enabled) {
+    if (enabled == polyphonic_) return;
+    polyphonic_ = enabled;
+    if (enabled) {
+        // The free-running grains fade out at the next block
+        nextGrainTime_ = currentTime_;
+        return;
+    }
+
+    // Back to the free-running stream: notes end, their grains fade out
+    for (NoteVoice& voice : notes_) {
+        voice.active = false;
+        voice.env.reset();
+    }
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        Grain& grain = grains_[i];
+        if (grain.active && grain.note >= 0) {
+            grain.note = GRAIN_FADING;
+            grain.gainStep = 0.0f;
+            fadingGrains_ = true;
+        }
+    }
+    nextGrainTime_ = currentTime_;
+}
+
+bool GrainEngine::isPolyphonic() const {
+    return polyphonic_;
+}
+
+int GrainEngine::noteOn(int noteId, float pitch, float velocity) {
+    // Retrigger the same note, else take a free voice
+    int index = -1;
+    for (int v = 0; v < MAX_NOTES && index < 0; ++v) {
+        if (notes_[v].active && notes_[v].noteId == noteId) index = v;
+    }
+    for (int v = 0; v < MAX_NOTES && index < 0; ++v) {
+        if (!notes_[v].active) index = v;
+    }
+
+    if (index < 0) {
+        // All busy: replace the lowest-priority (then oldest) note, whose
+        // grains fade out over the next block
+        index = 0;
+        for (int v = 1; v < MAX_NOTES; ++v) {
+            float p = notes_[v].priority();
+            float best = notes_[index].priority();
+            if (p < best || (p == best && notes_[v].age < notes_[index].age)) index = v;
+        }
+        for (int i = 0; i < MAX_GRAINS; ++i) {
+            Grain& grain = grains_[i];
+            if (grain.active && grain.note == index) {
+                grain.note = GRAIN_FADING;
+                grain.gainStep = 0.0f;
+                fadingGrains_ = true;
+            }
+        }
+        notes_[index].active = false;
+        notes_[index].env.reset();
+    }
+
+    NoteVoice& voice = notes_[index];
+    if (!voice.active) {
+        voice.active = true;
+        voice.nextGrainTime = currentTime_;
+    }
+    voice.noteId = noteId;
+    voice.pitchRatio = fastmath::exp2(std::max(-48.0f, std::min(48.0f, pitch)) * (1.0f / 12.0f));
+    voice.velocity = std::max(0.0f, std::min(1.0f, velocity));
+    voice.age = ++noteCounter_;
+    voice.env.gateOn();
+    return index;
+}
+
+void GrainEngine::noteOff(int noteId) {
+    for (NoteVoice& voice : notes_) {
+        if (voice.active && voice.noteId == noteId) voice.env.gateOff();
+    }
+}
+
+void GrainEngine::allNotesOff() {
+    for (NoteVoice& voice : notes_) {
+        if (voice.active) voice.env.gateOff();
+    }
+}
+
+int GrainEngine::getActiveNoteCount() const {
+    int count = 0;
+    for (const NoteVoice& voice : notes_) {
+        if (voice.active) count++;
+    }
+    return count;
+}
+
+EngineStats GrainEngine::collectStats() {
+    EngineStats stats;
+    stats.activeGrains = 0;
+    for (int i = 0; i < MAX_GRAINS; ++i) {
+        if (grains_[i].active) stats.activeGrains++;
+    }
+    stats.gainReductionDb = limiter_.takeGainReductionDb();
+    stats.outputPeak = outputPeak_;
+    stats.limiterLatency = limiter_.getModeLatency();
+    stats.cpuLoad = governor_.getLoad();
+    stats.grainCap = grainCap();
+    outputPeak_ = 0.0f;
+    return stats;
+}
+
+void GrainEngine::processDistortion(float* outputL, float* outputR, int numFrames, double startTime) {
+    // Auto-bypass: a zero drive is the identity curve unless the LFO can raise it
+    bool modulated = (params_.lfoTargetMask & LFO_DIST_AMOUNT) && params_.lfoAmount > 0.0f;
+    if (params_.distAmount <= 0.0f && !modulated) {
+        if (distortionActive_) {
+            distortion_.reset();
+            distAmountSmoother_.setImmediate(0.0f);
+            distortionActive_ = false;
+        }
+        return;
+    }
+    distortionActive_ = true;
+
+    for (int offset = 0; offset < numFrames; offset += CONTROL_BLOCK_SIZE) {
+        int n = std::min(CONTROL_BLOCK_SIZE, numFrames - offset);
+
+        // LFO per sub-block, then glide per frame so drive changes don't click
+        float lfoValue = lfo_.getValue(static_cast<float>(startTime + offset * invSampleRate_));
+        distAmountSmoother_.setTarget(modulate(params_.distAmount, LFO_DIST_AMOUNT,
+                                               ModScales::distAmount, 0.0f, 1.0f, lfoValue));
+        for (int i = 0; i < n; ++i) {
+            distDrive_[i] = distAmountSmoother_.process();
+        }
+        distortion_.process(outputL + offset, outputR + offset, distDrive_, n);
+    }
+}
+
+void GrainEngine::processDelay(float* outputL, float* outputR, int numFrames, double startTime,
+                               float* busL, float* busR) {
+    // Auto-bypass once the wet mix has faded out and nothing can raise it,
+    // or (send bus) once the bus has been silent for longer than the echoes
+    bool modulated = (params_.lfoTargetMask & LFO_DELAY_MIX) && params_.lfoAmount > 0.0f;
+    bool silent = params_.delayMix <= 0.0f && !modulated && delayMixSmoother_.getCurrent() < 1e-4f;
+    if (busL) {
+        // Echoes fall below -80 dB after log(1e-4) / log(feedback) repeats;
+        // assume the longest delay and, if modulated, the highest feedback
+        bool fbModulated = (params_.lfoTargetMask & LFO_DELAY_FEEDBACK) && params_.lfoAmount > 0.0f;
+        float feedback = fbModulated ? 0.95f : std::min(0.95f, params_.delayFeedback);
+        float repeats = feedback > 1e-3f ? -9.21f / std::log(feedback) : 0.0f;
+        int tail = static_cast<int>((repeats + 1.0f) * MAX_DELAY_SECONDS * sampleRate_);
+        silent = silent || auxBusIdle(0, numFrames, tail);
+    }
+    if (silent) {
+        if (delayActive_) {
+            delayMixSmoother_.setImmediate(0.0f);
+            delayActive_ = false;
+        }
+        if (busL) {
+            std::memset(busL, 0, numFrames * sizeof(float));
+            std::memset(busR, 0, numFrames * sizeof(float));
+        }
+        return;
+    }
+    if (!delayActive_) {
+        // Stale echoes from before the bypass would otherwise fade back in,
+        // and the time should not glide from a stale value
+        delay_.reset();
+        delayTimeSmoother_.setImmediate(getModulated(params_.delayTime, LFO_DELAY_TIME,
+                                                     ModScales::delayTime, 0.0f, 1.0f));
+        delayFeedbackSmoother_.setImmediate(getModulated(params_.delayFeedback, LFO_DELAY_FEEDBACK,
+                                                         ModScales::delayFeedback, 0.0f, 0.95f));
+        delayActive_ = true;
+    }
+
+    for (int offset = 0; offset < numFrames; offset += CONTROL_BLOCK_SIZE) {
+        int n = std::min(CONTROL_BLOCK_SIZE, numFrames - offset);
+
+        float lfoValue = lfo_.getValue(static_cast<float>(startTime + offset * invSampleRate_));
+        delayTimeSmoother_.setTarget(modulate(params_.delayTime, LFO_DELAY_TIME,
+                                              ModScales::delayTime, 0.0f, 1.0f, lfoValue));
+        delayFeedbackSmoother_.setTarget(modulate(params_.delayFeedback, LFO_DELAY_FEEDBACK,
+                                                  ModScales::delayFeedback, 0.0f, 0.95f, lfoValue));
+        delayMixSmoother_.setTarget(modulate(params_.delayMix, LFO_DELAY_MIX,
+                                             ModScales::delayMix, 0.0f, 1.0f, lfoValue));
+        for (int i = 0; i < n; ++i) {
+            delayFrames_[i] = delayTimeSmoother_.process() * sampleRate_;
+            delayFeedback_[i] = delayFeedbackSmoother_.process();
+            delayMix_[i] = delayMixSmoother_.process();
+        }
+        if (!busL) {
+            delay_.process(outputL + offset, outputR + offset,
+                           delayFrames_, delayFeedback_, delayMix_, n);
+            continue;
+        }
+
+        // Send bus: fully wet on the bus, mix is the return level
+        float* wetL = busL + offset;
+        float* wetR = busR + offset;
+        delay_.process(wetL, wetR, delayFrames_, delayFeedback_, unityMix_, n);
+        for (int i = 0; i < n; ++i) {
+            outputL[offset + i] += wetL[i] * delayMix_[i];
+            outputR[offset + i] += wetR[i] * delayMix_[i];
+        }
+    }
+}
+
+void GrainEngine::processReverb(float* outputL, float* outputR, int numFrames,
+                                float* busL, float* busR) {
+    acquirePendingConvolver();
+
+    // Convolution needs a loaded IR; fall back to the FDN without one
+    int type = (params_.reverbType == 1 && convolver_) ? 1 : 0;
+
+    // Auto-bypass once the wet mix has faded out (reverb has no LFO target),
+    // or (send bus) once the bus has been silent for longer than the tail
+    bool silent = params_.reverbMix <= 0.0f && reverbMixSmoother_.getCurrent() < 1e-4f;
+    if (busL) {
+        int tail = (type == 1)
+            ? convolver_->getLength() + 2 * PartitionedConvolver::kBlockSize
+            : static_cast<int>(1.5f * params_.reverbDecay * sampleRate_);
+        silent = silent || auxBusIdle(1, numFrames, tail);
+    }
+    if (silent) {
+        if (reverbActive_) {
+            reverbMixSmoother_.setImmediate(0.0f);
+            reverbActive_ = false;
+        }
+        if (busL) {
+            std::memset(busL, 0, numFrames * sizeof(float));
+            std::memset(busR, 0, numFrames * sizeof(float));
+        }
+        return;
+    }
+
+    if (!reverbActive_ || type != activeReverbType_) {
+        // Don't resume a tail from before the bypass or from the other stage
+        if (type == 1) convolver_->reset();
+        else reverb_.reset();
+        activeReverbType_ = type;
+        reverbActive_ = true;
+    }
+
+    for (int i = 0; i < numFrames; ++i) {
+        reverbMix_[i] = reverbMixSmoother_.process();
+    }
+
+    // Send bus: fully wet on the bus, mix is the return level
+    float* wetL = busL ? busL : outputL;
+    float* wetR = busR ? busR : outputR;
+    const float* mix = busL ? unityMix_ : reverbMix_;
+    if (type == 1) {
+        convolver_->process(wetL, wetR, mix, numFrames);
+    } else {
+        reverb_.process(wetL, wetR, mix, numFrames);
+    }
+    if (busL) {
+        for (int i = 0; i < numFrames; ++i) {
+            outputL[i] += wetL[i] * reverbMix_[i];
+            outputR[i] += wetR[i] * reverbMix_[i];
+        }
+    }
+}
+
+void GrainEngine::processGain(float* outputL, float* outputR, int numFrames, bool withAux) {
+    float* left[1 + NUM_AUX_BUSES] = { outputL, auxBusL_[0], auxBusL_[1] };
+    float* right[1 + NUM_AUX_BUSES] = { outputR, auxBusR_[0], auxBusR_[1] };
+    const int buses = withAux ? 1 + NUM_AUX_BUSES : 1;
+
+    // Snap once the glide has converged so steady volumes take the cheap path
+    float target = volumeSmoother_.getTarget();
+    if (std::fabs(volumeSmoother_.getCurrent() - target) < 1e-5f) {
+        volumeSmoother_.setImmediate(target);
+        if (target == 1.0f) return;   // Auto-bypass at unity
+        for (int b = 0; b < buses; ++b) {
+            for (int i = 0; i < numFrames; ++i) {
+                left[b][i] *= target;
+                right[b][i] *= target;
+            }
+        }
+        return;
+    }
+
+    for (int i = 0; i < numFrames; ++i) {
+        float gain = volumeSmoother_.process();
+        for (int b = 0; b < buses; ++b) {
+            left[b][i] *= gain;
+            right[b][i] *= gain;
+        }
+    }
+}
+
+void GrainEngine::processLimiter(float* outputL, float* outputR, int numFrames) {
+    limiter_.processMode(limiterBypassed_ ? 0 : params_.limiterMode, outputL, outputR, numFrames);
+
+    // Output meter
+    using namespace simd;
+    f32x4 peak = splat(0.0f);
+    int i = 0;
+    for (; i + kLanes <= numFrames; i += kLanes) {
+        peak = max(peak, max(abs(load(outputL + i)), abs(load(outputR + i))));
+    }
+    float blockPeak = std::max(std::max(lane<0>(peak), lane<1>(peak)),
+                               std::max(lane<2>(peak), lane<3>(peak)));
+    for (; i < numFrames; ++i) {
+        blockPeak = std::max(blockPeak, std::max(std::fabs(outputL[i]), std::fabs(outputR[i])));
+    }
+    outputPeak_ = std::max(outputPeak_, blockPeak);
+}
+
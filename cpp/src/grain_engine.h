@@ -1,10 +1,29 @@
 #pragma once
 
+#include "cpu_governor.h"
+#include "delay_line.h"
+#include "distortion.h"
 #include "grain.h"
+#include "grain_filter.h"
+#include "engine_params.h"
+#include "engine_snapshot.h"
+#include "engine_telemetry.h"
+#include "fdn_reverb.h"
 #include "lfo.h"
+#include "master_limiter.h"
+#include "note_voice.h"
 #include "param_smoother.h"
+#include "partitioned_convolver.h"
+#include "preset_morph.h"
+#include "rng.h"
+#include "spectral_granulator.h"
+#include "svf_filter.h"
+#include "worker_pool.h"
+#include <atomic>
 #include <cstdint>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 // Grain visualization event (sent back to main thread)
 struct GrainEvent {
@@ -15,98 +34,152 @@ struct GrainEvent {
 
 static constexpr int MAX_GRAIN_EVENTS = 64;
 
-// Parameters mirroring GranularParams from types.ts
-// Only the subset relevant to the grain engine (Phase 1)
-struct EngineParams {
-    // Grain
-    float grainSize = 0.3f;        // seconds (0.01 - 0.5)
-    float density = 0.15f;         // seconds between grains (0.005 - 0.5)
-    float spread = 0.0f;           // position offset (0 - 2)
-    float position = 0.0f;         // normalized playhead (0 - 1)
-    float grainReversalChance = 0.0f; // (0 - 1)
-
-    // Stereo
-    float pan = 0.0f;              // (-1 to 1)
-    float panSpread = 0.0f;        // (0 to 1)
-
-    // Pitch & FM
-    float pitch = 0.0f;            // semitones (-24 to +24)
-    float detune = 0.0f;           // cents (0 - 100)
-    float fmFreq = 0.0f;           // Hz
-    float fmAmount = 0.0f;         // (0 - 100)
-
-    // Envelope
-    float attack = 0.5f;           // ratio of grain size (0 - 1)
-    float release = 0.5f;          // ratio of grain size (0 - 1)
-    int envelopeCurve = 0;         // 0=linear, 1=exponential
+// Engine metering, polled by the host between blocks
+struct EngineStats {
+    int activeGrains;          // Grains sounding when the stats were read
+    float gainReductionDb;     // Largest limiter / soft-clip reduction since the last read
+    float outputPeak;          // Largest |sample| on the main output since the last read
+    int limiterLatency;        // Frames the limiter delays the main output (0 unless limiting)
+    float cpuLoad;             // Smoothed render cost over real time (0 without a CPU budget)
+    int grainCap;              // Grains the CPU governor allows (MAX_GRAINS when not throttling)
+};
 
-    // LFO
-    float lfoRate = 1.0f;          // Hz (0.1 - 20)
-    float lfoAmount = 0.0f;        // depth (0 - 1)
-    int lfoShape = 0;              // 0=sine, 1=triangle, 2=square, 3=sawtooth
-
-    // LFO targets (bitfield for efficiency)
-    // Bit positions match the order in MOD_SCALES
-    uint32_t lfoTargetMask = 0;
-
-    // Volume (applied as final gain in the worklet)
-    float volume = 0.8f;
-
-    // Filter params (Phase 1: passed through to Web Audio nodes, not used in C++)
-    float filterFreq = 20000.0f;
-    float filterRes = 0.0f;
-
-    // FX params (Phase 1: passed through to Web Audio nodes)
-    float distAmount = 0.0f;
-    float delayTime = 0.3f;
-    float delayFeedback = 0.3f;
-    float delayMix = 0.0f;
-    float reverbMix = 0.0f;
-    float reverbDecay = 2.0f;
+// Control-rate sub-block for post-mix stages (filter coefficients, LFO)
+static constexpr int CONTROL_BLOCK_SIZE = 32;
+
+// Scheduling block: process() splits longer blocks into runs of at most this
+// many frames, each with its own grain spawns, modulation and smoothing. The
+// grid restarts with every call, so renders match across host block sizes
+// that are multiples of this (a shorter tail starts a new block early).
+static constexpr int SCHEDULE_BLOCK_SIZE = 128;
+
+// Largest block the output buffers can be sized for (setMaxBlockSize)
+static constexpr int MAX_BLOCK_SIZE = 65536;
+
+// Longest grain (upper clamp of the modulated grain size)
+static constexpr float MAX_GRAIN_SECONDS = 0.5f;
+
+// Frames the post-mix FX chain runs per pass: every stage finishes one chunk
+// before the next chunk starts, so the audio stays in L1 across the chain.
+// One convolution block, so the convolver stays on its zero-latency path.
+static constexpr int FX_CHUNK_SIZE = PartitionedConvolver::kBlockSize;
+
+// Aux send buses (fxRouting != 0): 0 = delay, 1 = reverb
+static constexpr int NUM_AUX_BUSES = 2;
+
+// Longest delay time the delay ring is allocated for (matches the UI range)
+static constexpr float MAX_DELAY_SECONDS = 1.0f;
+
+// Frames rendered per pass when per-grain filters are on (scratch size)
+static constexpr int GRAIN_FILTER_CHUNK = 128;
+
+// Interleaved (frame-major, 4 lanes) scratch for rendering filtered grains
+// four at a time, one per rendering thread
+struct GrainLaneScratch {
+    alignas(16) float lanes[GRAIN_FILTER_CHUNK * simd::kLanes];
+    alignas(16) float accL[GRAIN_FILTER_CHUNK * simd::kLanes];
+    alignas(16) float accR[GRAIN_FILTER_CHUNK * simd::kLanes];
+    alignas(16) float sendL[NUM_AUX_BUSES][GRAIN_FILTER_CHUNK * simd::kLanes];
+    alignas(16) float sendR[NUM_AUX_BUSES][GRAIN_FILTER_CHUNK * simd::kLanes];
 };
 
-// LFO target bit positions
-enum LfoTarget : uint32_t {
-    LFO_GRAIN_SIZE     = 1 << 0,
-    LFO_DENSITY        = 1 << 1,
-    LFO_SPREAD         = 1 << 2,
-    LFO_POSITION       = 1 << 3,
-    LFO_PITCH          = 1 << 4,
-    LFO_FM_FREQ        = 1 << 5,
-    LFO_FM_AMOUNT      = 1 << 6,
-    LFO_FILTER_FREQ    = 1 << 7,
-    LFO_FILTER_RES     = 1 << 8,
-    LFO_ATTACK         = 1 << 9,
-    LFO_RELEASE        = 1 << 10,
-    LFO_DIST_AMOUNT    = 1 << 11,
-    LFO_DELAY_MIX      = 1 << 12,
-    LFO_DELAY_TIME     = 1 << 13,
-    LFO_DELAY_FEEDBACK = 1 << 14,
-    LFO_PAN            = 1 << 15,
-    LFO_PAN_SPREAD     = 1 << 16,
+// Parallel grain rendering (setRenderThreads). Each job renders one
+// scheduling block (RENDER_CHUNK frames at most: grains render block by
+// block whatever the process() call length, so spawns land on their block)
+// of the active grains split into at most RENDER_GROUPS groups of whole
+// quads; every group sums into its own accumulator of RENDER_CHANNELS (main
+// + send buses, L/R). The groups are the same without helper threads, so
+// the sum order depends only on the active grains. Below
+// PARALLEL_MIN_GRAINS grains render directly.
+static constexpr int RENDER_GROUPS = 32;
+static constexpr int RENDER_CHUNK = SCHEDULE_BLOCK_SIZE;
+static constexpr int RENDER_CHANNELS = 2 + 2 * NUM_AUX_BUSES;
+static constexpr int PARALLEL_MIN_GRAINS = 32;
+
+// Block-invariant spawn parameters (modulation is constant within a block).
+// Cached between blocks and only recomputed when an input changes.
+struct SpawnParams {
+    float density;           // seconds between grains (modulated)
+    float grainDuration;     // seconds
+    float grainSamples;      // grainDuration * sampleRate (unrounded)
+    int totalSamples;
+    float envIncrement;      // 1 / totalSamples
+    float pitchCents;
+    float pitchRate;         // 2^(pitchCents / 1200)
+    float detune;
+    float fmFreq;
+    float fmAmount;
+    float fmMod;             // FM offset for this block (refreshed every block)
+    float reversalChance;
+    float spread;
+    float position;
+    float attack;
+    float release;
+    float panCenter;
+    float panSpread;
+    float centerPanL;        // Equal-power gains at panCenter
+    float centerPanR;
+    float bufferLength;      // sampleBufferLength_ as float
+    float invBufferLength;
+    float lastSample;
+    float centerSample;      // position * bufferLength
+    float offsetScale;       // spread * bufferLength / 2
+    bool exponentialEnv;
+    int grainFilterMode;     // 0 = off
+    float grainFilterFreq;
+    float grainFilterRes;
+    float grainFilterSpread;
+    bool sendsActive;        // fxRouting != 0
+    float sendDelay;
+    float sendReverb;
+    float sendSpread;
 };
 
-// Modulation scales (matching MOD_SCALES in App.tsx)
-struct ModScales {
-    static constexpr float grainSize   = 0.2f;
-    static constexpr float density     = 0.1f;
-    static constexpr float spread      = 1.0f;
-    static constexpr float position    = 0.5f;
-    static constexpr float pitch       = 24.0f;
-    static constexpr float fmFreq      = 200.0f;
-    static constexpr float fmAmount    = 50.0f;
-    static constexpr float filterFreq  = 5000.0f;
-    static constexpr float filterRes   = 10.0f;
-    static constexpr float attack      = 0.5f;
-    static constexpr float release     = 0.5f;
-    static constexpr float distAmount  = 0.5f;
-    static constexpr float delayMix    = 0.5f;
-    static constexpr float delayTime   = 0.5f;
-    static constexpr float delayFeedback = 0.5f;
-    static constexpr float pan         = 1.0f;
-    static constexpr float panSpread   = 1.0f;
+// Per-block inputs to SpawnParams that change without a params update
+struct SpawnCacheKey {
+    float grainSize;
+    float pitch;
+    float pan;
+    float basePosition;
+    float lfoValue;
+    int bufferLength;
 };
 
+// Params that feed SpawnParams (everything except volume, filter and FX)
+static constexpr uint64_t kSpawnParamMask =
+    PARAM_GRAIN_SIZE | PARAM_DENSITY | PARAM_SPREAD | PARAM_POSITION |
+    PARAM_REVERSAL_CHANCE | PARAM_PAN | PARAM_PAN_SPREAD | PARAM_PITCH |
+    PARAM_DETUNE | PARAM_FM_FREQ | PARAM_FM_AMOUNT | PARAM_ATTACK |
+    PARAM_RELEASE | PARAM_ENVELOPE_CURVE | PARAM_LFO_AMOUNT |
+    PARAM_LFO_TARGET_MASK | PARAM_GRAIN_FILTER_MODE | PARAM_GRAIN_FILTER_FREQ |
+    PARAM_GRAIN_FILTER_RES | PARAM_GRAIN_FILTER_SPREAD | PARAM_FX_ROUTING |
+    PARAM_SEND_DELAY | PARAM_SEND_REVERB | PARAM_SEND_SPREAD;
+
+// SoA scratch for one spawn batch, sized for a full pool and padded to whole
+// SIMD vectors so the vector pass needs no scalar tail
+static constexpr int SPAWN_BATCH_SIZE = (MAX_GRAINS + simd::kLanes - 1) & ~(simd::kLanes - 1);
+
+struct SpawnBatch {
+    int slot[SPAWN_BATCH_SIZE];
+    alignas(16) float rDetune[SPAWN_BATCH_SIZE];
+    alignas(16) float rReverse[SPAWN_BATCH_SIZE];
+    alignas(16) float rOffset[SPAWN_BATCH_SIZE];
+    alignas(16) float rPan[SPAWN_BATCH_SIZE];
+    alignas(16) float rate[SPAWN_BATCH_SIZE];
+    alignas(16) float start[SPAWN_BATCH_SIZE];
+    alignas(16) float normPos[SPAWN_BATCH_SIZE];
+    alignas(16) float pan[SPAWN_BATCH_SIZE];
+    alignas(16) float panL[SPAWN_BATCH_SIZE];
+    alignas(16) float panR[SPAWN_BATCH_SIZE];
+    alignas(16) float rCutoff[SPAWN_BATCH_SIZE];
+    alignas(16) float rRes[SPAWN_BATCH_SIZE];
+    alignas(16) float cutoff[SPAWN_BATCH_SIZE];
+    alignas(16) float q[SPAWN_BATCH_SIZE];
+    alignas(16) float rSendDelay[SPAWN_BATCH_SIZE];
+    alignas(16) float rSendReverb[SPAWN_BATCH_SIZE];
+    alignas(16) float sendDelay[SPAWN_BATCH_SIZE];
+    alignas(16) float sendReverb[SPAWN_BATCH_SIZE];
+};
 
 class GrainEngine {
 public:
@@ -121,6 +194,22 @@ public:
     float* allocateSampleBuffer(int lengthInSamples);
     void commitSampleBuffer(int channels, int lengthInSamples);
 
+    // Spectral grains (grainMode 1) read the sample's STFT frame store,
+    // analysed off the audio thread (EnginePrep::prepareSpectralFrames) and
+    // copied in: allocate for its frame count and hop, write
+    // getSpectralFramesSize() floats, commit. Commit drops frames that don't
+    // fit the loaded sample and returns false. Until frames are committed,
+    // spectral grains play in the time domain.
+    float* allocateSpectralFrames(int numFrames, int analysisHop);
+    int getSpectralFramesSize() const;
+    bool commitSpectralFrames();
+
+    // Play sample data owned elsewhere instead (LayerHost's shared bank),
+    // with its spectral frame store; nullptr data detaches. Frees the own
+    // buffer. The data must stay valid until the next attach or allocate.
+    void attachSample(const float* data, int channels, int lengthInSamples,
+                      const SpectralFrames* frames);
+
     // Transport
     void start();
     void stop();
@@ -128,10 +217,38 @@ public:
     // Update parameters from main thread
     void updateParams(const EngineParams& params);
 
-    // Process one block of audio (128 samples, stereo interleaved output)
-    // outputL and outputR are pointers into WASM heap
+    // Process one block of audio of any length (stereo, planar output).
+    // Blocks that aren't multiples of SCHEDULE_BLOCK_SIZE move the
+    // scheduling grid, so they render differently from 128-frame calls.
+    // outputL and outputR are pointers into WASM heap, e.g. the engine's
+    // own output buffers for blocks up to getMaxBlockSize() frames.
     void process(float* outputL, float* outputR, int numFrames);
 
+    // Size the output and aux buffers for blocks of up to `frames` frames
+    // (SCHEDULE_BLOCK_SIZE - MAX_BLOCK_SIZE, default SCHEDULE_BLOCK_SIZE).
+    // Allocates and moves the buffers, so call it outside process() and
+    // fetch the buffer pointers again afterwards.
+    void setMaxBlockSize(int frames);
+    int getMaxBlockSize() const;
+
+    // Offline passes (OfflineRenderer). Blocks run exactly as in process(),
+    // with the same scheduling, smoothing and random draws, except that
+    // skip() only counts the grains down (no audio, no FX), renderDry()
+    // stops after the grain layer and writes it to dry[0 - RENDER_CHANNELS)
+    // (main L/R, then each send bus L/R while fxRouting != 0), and
+    // processDry() takes that grain layer from `dry` instead of rendering
+    // it. Time-domain grains only: spectral grains carry synthesis state.
+    void skip(int numFrames);
+    void renderDry(float* const* dry, int numFrames);
+    void processDry(const float* const* dry, float* outputL, float* outputR, int numFrames);
+
+    // Preset morphing: store snapshots, then drive them from one position.
+    // The blended params are applied at control rate (once per block) and
+    // only recomputed when the smoothed morph position moves.
+    void setMorphSnapshot(int index, const EngineParams& params);
+    void clearMorphSnapshots();
+    void setMorphPosition(float position);
+
     // Freeze / Drift
     void setFrozen(bool frozen, float position);
     void setDrift(bool enabled, float basePosition, float speed, float returnTendency);
@@ -143,31 +260,291 @@ public:
     float getGrainEventPan(int index) const;
     void clearGrainEvents();
 
-    // Allocate output buffers in WASM heap (called once)
+    // Random seed. Reseeding rewinds every stream, so the same seed, params
+    // and transport calls reproduce the same render.
+    void setSeed(uint32_t seed);
+    uint32_t getSeed() const;
+
+    // State snapshots. saveState() copies the grains, note voices, random
+    // streams, smoothers, morph, freeze/drift and transport time into a
+    // plain EngineSnapshot; restoreState() adopts one (from this engine,
+    // another one, or a reloaded module) and the grain layer continues
+    // exactly as the saved engine's would. Not captured: the sample (the
+    // grains are dropped if its length differs), the IR, spectral grain
+    // phases (reseeded) and the effect tails, which ring on from this
+    // engine's own state. Returns false if the header does not match this
+    // build or sample rate.
+    void saveState(EngineSnapshot& snapshot) const;
+    bool restoreState(const EngineSnapshot& snapshot);
+
+    // The same through the WASM heap: captureState() saves into the
+    // engine's own snapshot buffer and returns its address, for JS to copy
+    // getStateSize() bytes out; to restore, JS writes a saved copy to
+    // getStateBuffer() and calls restoreStateBuffer(). The buffer is
+    // allocated on first use.
+    uintptr_t captureState();
+    uintptr_t getStateBuffer();
+    bool restoreStateBuffer();
+    int getStateSize() const;
+
+    // Convolution reverb IR (used when reverbType = 1). Native hosts write
+    // planar channel data into the allocated buffer, then commit partitions
+    // and transforms it on the calling thread (never the audio thread). The
+    // new IR is picked up at the next block and its cost estimate returned.
+    float* allocateImpulseBuffer(int lengthInSamples, int channels);
+    ConvolverCost commitImpulseBuffer();
+
+    // The same from IR spectra prepared elsewhere (the web build's prep
+    // worker, see EnginePrep): allocate, copy getImpulseSpectraSize() floats
+    // in, commit. Nothing is transformed, so the worklet only copies.
+    float* allocateImpulseSpectra(int partitions, int channels);
+    int getImpulseSpectraSize() const;
+    ConvolverCost commitImpulseSpectra();
+
+    void clearImpulseResponse();
+    ConvolverCost getImpulseCost() const;
+
+    // Output buffers in WASM heap, getMaxBlockSize() frames each
     float* getOutputBufferL();
     float* getOutputBufferR();
 
+    // Aux bus outputs (bus 0 = delay, 1 = reverb), holding the last block
+    // (up to getMaxBlockSize() frames) like the main output buffers.
+    // fxRouting 1: each effect's wet return before its return level.
+    // fxRouting 2: the raw per-grain sends after volume, for the host to
+    // process and mix. Silent with the insert chain. Delayed by the
+    // limiter's latency, so they line up with the main output.
+    float* getAuxBufferL(int bus);
+    float* getAuxBufferR(int bus);
+
+    // Read the meters and re-arm their peak holds
+    EngineStats collectStats();
+
+    // Render grains on `count` helper threads besides the one calling
+    // process() (0 = single-threaded, the default; always 0 without thread
+    // support, i.e. WASM built without USE_THREADS). Starts threads and
+    // allocates, so call it outside process(). The mix is identical for
+    // every count.
+    void setRenderThreads(int count);
+    int getRenderThreads() const;
+
+    // Cap on simultaneously sounding grains (0 - MAX_GRAINS, default
+    // MAX_GRAINS). At the cap, new grains steal the ones closest to
+    // finishing; lowering it lets the excess die out naturally.
+    void setGrainLimit(int limit);
+    int getGrainLimit() const;
+
+    // Skip the master limiter / soft clip whatever params.limiterMode says
+    // (a host limiting the mix, e.g. LayerHost); the output meter still runs
+    void setLimiterBypass(bool bypass);
+
+    // Grains the current settings keep sounding at once (grain duration
+    // over spawn interval, times the sounding notes in polyphonic mode, at
+    // most MAX_GRAINS); 0 while stopped
+    int getGrainDemand() const;
+
+    // CPU budget: the fraction of each process() call's real-time duration
+    // the engine may spend (0 = off, the default). Over budget, the
+    // governor lowers the grain cap (below the grain limit), the quietest
+    // grains over it fade out and spawns wait until the count is back
+    // under; the cap recovers once the load stays low (see CpuGovernor).
+    void setCpuBudget(float fraction);
+    float getCpuBudget() const;
+
+    // Telemetry (see EngineTelemetry), rewritten after every process() call
+    // while enabled; enabling restarts its totals. Off by default, as it
+    // reads the clock a few times per block. The block lives as long as
+    // the engine, so JS can keep its address.
+    void setTelemetryEnabled(bool enabled);
+    uintptr_t getTelemetryBuffer();
+    int getTelemetrySize() const;
+
+    // Polyphonic mode: instead of the one free-running stream, every held
+    // note runs its own stream at params.pitch + its pitch offset, scaled
+    // by velocity and the note ADSR (params.note*). Notes share the grain
+    // pool by priority-weighted fair shares (held notes by velocity,
+    // releasing notes by their fading level); with the pool full, a note
+    // below its share fades out a grain of the note furthest above its own
+    // and takes the slot, so grains are never cut off. Grains of the other
+    // mode fade out over one block on a switch. Notes still need start().
+    void setPolyphonic(bool enabled);
+    bool isPolyphonic() const;
+
+    // Start (or retrigger) note `noteId` at `pitch` semitones over
+    // params.pitch with velocity 0 - 1. With all MAX_NOTES voices busy the
+    // lowest-priority note is replaced. Returns the voice used.
+    int noteOn(int noteId, float pitch, float velocity);
+    void noteOff(int noteId);
+    void allNotesOff();
+    int getActiveNoteCount() const;
+
 private:
-    // Spawn a new grain at the current engine time
-    void spawnGrain();
+    // One scheduling block (at most SCHEDULE_BLOCK_SIZE frames) starting
+    // `offset` frames into the host's block
+    void processBlock(float* outputL, float* outputR, int numFrames, int offset);
+
+    // Grains allowed to sound: the grain limit, lowered by the governor
+    int grainCap() const { return std::min(grainLimit_, governorCap_); }
+
+    // Feed one process() call's cost to the governor and shed grains over
+    // its cap
+    void governBlock(double costMs, int numFrames);
+
+    // Write the telemetry block for the call that just rendered
+    void publishTelemetry(const float* outputL, const float* outputR, int numFrames,
+                          double costMs);
+
+    // Spawn `count` grains due in the current block as one batch, for the
+    // free-running stream or for note voice `note`
+    void spawnGrains(int count, int note = GRAIN_FREE_RUNNING);
+
+    // Polyphonic mode: advance the note envelopes, retire finished notes,
+    // set every grain's gain ramp for the block and spawn each note's grains
+    void scheduleNotes(int numFrames, double blockEndTime);
+
+    // Gain ramps for one block: note grains follow their voice, fading
+    // grains (and, in polyphonic mode, free-running ones) go to zero
+    void updateGrainGains(int numFrames);
+
+    // Give every sounding grain the centre grain-filter coefficients, for
+    // grains spawned while the grain filter was off
+    void primeGrainFilters();
+
+    // Evaluate the block-invariant spawn parameters (modulation, clamps)
+    void computeSpawnParams(SpawnParams& sp) const;
+
+    // Recompute spawnParams_ if any of its inputs changed since last block
+    void updateSpawnCache();
+
+    // Grain position source before modulation (frozen > drift > manual)
+    float getBasePosition() const;
+
+    // Fill `slots` with free pool slots, stealing the grains closest to
+    // finishing if needed; notes fade grains of other notes out instead
+    int acquireGrainSlots(int* slots, int count, int note);
+
+    // Split the grain limit into per-note shares by priority
+    void updateNoteShares();
+
+    // Note furthest above its share (-1 if none), from per-note grain counts
+    int pickVictimNote(const int* noteGrains) const;
+
+    // Samples a grain plays before it ends or its read position leaves the
+    // buffer. Replays the render's position sum only when the grain may
+    // reach an edge, so a grain's end is known when it spawns.
+    int32_t grainLifetime(float start, float rate, int32_t totalSamples) const;
+
+    // Whether grains render as spectral grains (grainMode 1 with frames)
+    bool spectralGrains() const { return params_.grainMode == 1 && spectral_.isReady(); }
+
+    // Adapt the active grains' lifetimes to the other render path after a
+    // switch (see lifetimesSpectral_); O(1) per grain
+    void retimeGrains(bool spectral);
+
+    // Count every grain down by numFrames without rendering it (skip()).
+    // Only the lifetimes stay exact; grains skipped over have ended before
+    // anything rendered after them can hear them.
+    void ageGrains(int numFrames);
 
     // Process a single grain for one sample, return stereo pair
     void processGrain(Grain& grain, float& outL, float& outR);
 
+    // Read, envelope and advance a grain by one sample (mono, before panning)
+    float renderGrainSample(Grain& grain);
+
+    // Render all active grains with the current grain mode (and, while
+    // sendsActive_, their aux sends into auxBusL_/auxBusR_)
+    void renderMix(float* outputL, float* outputR, int numFrames);
+    void renderGrainLayer(float* outputL, float* outputR, int numFrames);
+
+    // Sum all active grains into the output (unfiltered path)
+    void renderGrains(float* outputL, float* outputR, int numFrames);
+
+    // Sum all active grains as spectral (phase-vocoder) grains
+    void renderGrainsSpectral(float* outputL, float* outputR, int numFrames);
+
+    // Add every active grain's next hop to the spectral output and advance it
+    void synthesizeSpectralHop();
+
+    // Sum all active grains through their own filters, four grains per vector
+    void renderGrainsFiltered(float* outputL, float* outputR, int numFrames);
+    void renderFilteredGroup(const int* group, int groupSize, int numFrames,
+                             GrainLaneScratch& scratch);
+
+    // Plain or filtered grains on the render pool (at most RENDER_CHUNK
+    // frames): split the active grains into groups, render each group into
+    // its accumulator (any thread) and reduce the groups in a fixed order
+    void renderGrainsParallel(float* outputL, float* outputR, int numFrames);
+    static void renderGroupTask(void* engine, int group, int worker);
+    void renderGroup(int group, int worker);
+
     // Compute envelope value for a grain
     float computeEnvelope(const Grain& grain) const;
 
-    // Get modulated parameter value
+    // Apply the morph blend if the morph position moved
+    void updateMorph(int numFrames);
+
+    // Get modulated parameter value (block LFO value, or an explicit one)
     float getModulated(float base, uint32_t targetBit, float scale,
                        float minVal, float maxVal) const;
+    float modulate(float base, uint32_t targetBit, float scale,
+                   float minVal, float maxVal, float lfoValue) const;
+
+    // Post-mix chain: filter -> distortion -> delay -> reverb -> gain, run
+    // one FX_CHUNK_SIZE chunk at a time. Each stage below handles at most
+    // one chunk starting at engine time startTime and bypasses itself while
+    // it would be the identity.
+    void processFxChain(float* outputL, float* outputR, int numFrames);
+
+    // Aux-send routing: per FX_CHUNK_SIZE chunk, grains render into the main
+    // bus and the send buses; filter and distortion run on the main bus,
+    // delay and reverb on their buses (fxRouting 1) or are left to the host
+    // (fxRouting 2), then volume. The buses are copied to the aux outputs
+    // at `auxOffset`.
+    void processSendChain(float* outputL, float* outputR, int numFrames, int auxOffset);
+
+    // True once a send bus has carried nothing for longer than tailFrames
+    bool auxBusIdle(int bus, int numFrames, int tailFrames);
+
+    // Stereo filter, coefficients updated per CONTROL_BLOCK_SIZE; skipped
+    // while it is a fully open lowpass
+    void processFilter(float* outputL, float* outputR, int numFrames, double startTime);
+
+    // Distortion; skipped entirely while the drive is 0
+    void processDistortion(float* outputL, float* outputR, int numFrames, double startTime);
+
+    // Feedback delay; skipped while the (smoothed) mix is 0. With a send bus
+    // the delay runs fully wet on the bus, mix is its return level, and the
+    // stage also sleeps once the bus and the echoes have died away.
+    void processDelay(float* outputL, float* outputR, int numFrames, double startTime,
+                      float* busL = nullptr, float* busR = nullptr);
+
+    // Reverb (FDN or convolution); skipped while the (smoothed) mix is 0.
+    // Send buses work as for processDelay.
+    void processReverb(float* outputL, float* outputR, int numFrames,
+                       float* busL = nullptr, float* busR = nullptr);
+
+    // Master volume; skipped while it sits at unity. withAux also scales the
+    // send buses (fxRouting 2, where they leave the engine).
+    void processGain(float* outputL, float* outputR, int numFrames, bool withAux = false);
+
+    // Master limiter or soft clip on the main output (never the aux buses),
+    // then output metering. A mode change crossfades over one chunk since
+    // the modes differ in latency.
+    void processLimiter(float* outputL, float* outputR, int numFrames);
+
+    // Audio thread: adopt a newly committed convolver, retiring the old one
+    void acquirePendingConvolver();
+
+    // Control thread: free a convolver the audio thread has retired
+    void collectRetiredConvolver();
+
+    // Control thread: hand a prepared convolver to the audio thread
+    ConvolverCost publishConvolver(PartitionedConvolver* convolver);
 
     // Update drift position
     void updateDrift(float deltaTimeSec);
 
-    // Simple xorshift PRNG (deterministic, fast, no allocation)
-    float randomFloat();  // Returns 0..1
-    uint32_t randomUint();
-
     // State
     float sampleRate_ = 48000.0f;
     float invSampleRate_ = 1.0f / 48000.0f;
@@ -175,17 +552,73 @@ private:
     double currentTime_ = 0.0;       // Engine time in seconds
     double nextGrainTime_ = 0.0;     // When to spawn next grain
 
-    // Sample buffer (owned, mono for now)
+    // Sample buffer (mono for now): the own copy, and the data grains read
+    // (the own copy or an attached shared one)
     float* sampleBuffer_ = nullptr;
+    const float* sampleData_ = nullptr;
     int sampleBufferLength_ = 0;
     int sampleBufferChannels_ = 1;
 
-    // Output buffers (pre-allocated in WASM heap)
-    float outputL_[128];
-    float outputR_[128];
-
-    // Grain pool
+    // Output buffers (pre-allocated in WASM heap, maxBlockSize_ frames)
+    int maxBlockSize_ = 0;
+    std::vector<float> outputL_;
+    std::vector<float> outputR_;
+    std::vector<float> auxOutL_[NUM_AUX_BUSES];
+    std::vector<float> auxOutR_[NUM_AUX_BUSES];
+
+    // Aux send buses for one chunk, filled by the grain renderers while
+    // sendsActive_; effects on a bus run fully wet (unityMix_)
+    bool sendsActive_ = false;
+    float auxBusL_[NUM_AUX_BUSES][FX_CHUNK_SIZE];
+    float auxBusR_[NUM_AUX_BUSES][FX_CHUNK_SIZE];
+    int auxIdleFrames_[NUM_AUX_BUSES] = { INT32_MAX / 2, INT32_MAX / 2 };
+    float unityMix_[FX_CHUNK_SIZE];
+
+    // Offline pass the current blocks run (skip / renderDry / processDry),
+    // its grain-layer channels and the frames of them used so far
+    enum class OfflinePass { None, Skip, Dry, Wet };
+    OfflinePass offlinePass_ = OfflinePass::None;
+    float* dryOut_[RENDER_CHANNELS] = {};
+    const float* dryIn_[RENDER_CHANNELS] = {};
+    int dryCursor_ = 0;
+
+    // Grain pool and the cap on its active grains
     Grain grains_[MAX_GRAINS];
+    int grainLimit_ = MAX_GRAINS;
+    SpawnBatch spawnBatch_;
+
+    // CPU budget governor and its current cap
+    CpuGovernor governor_;
+    int governorCap_ = MAX_GRAINS;
+
+    // Shedding candidates: each active grain's level, once per shed
+    struct ShedCandidate {
+        float level;
+        int slot;
+    };
+    ShedCandidate shedCandidates_[MAX_GRAINS];
+
+    // Telemetry block, the totals behind it, and the current call's timings
+    EngineTelemetry telemetry_{};
+    bool telemetryEnabled_ = false;
+    uint32_t spawnCount_ = 0;
+    uint32_t stealCount_ = 0;
+    uint32_t endsNatural_ = 0;
+    uint32_t endsBoundary_ = 0;
+    uint32_t endsFaded_ = 0;
+    uint32_t blockCount_ = 0;
+    uint32_t costHistogram_[TELEMETRY_COST_BINS] = {};
+    double spawnMs_ = 0.0;
+    double renderMs_ = 0.0;
+    double fxMs_ = 0.0;
+
+    // Polyphonic note voices and their grain shares for the current block;
+    // fadingGrains_ while orphaned grains remain
+    NoteVoice notes_[MAX_NOTES];
+    int noteShare_[MAX_NOTES] = {};
+    bool polyphonic_ = false;
+    bool fadingGrains_ = false;
+    uint32_t noteCounter_ = 0;
 
     // LFO
     LFO lfo_;
@@ -193,6 +626,13 @@ private:
 
     // Parameters (current, updated from main thread)
     EngineParams params_;
+    bool paramsValid_ = false;       // False until the first updateParams()
+    uint64_t dirtyParams_ = PARAM_ALL; // ParamField bits changed since last use
+
+    // Derived spawn constants, refreshed lazily once per block
+    SpawnParams spawnParams_{};
+    SpawnCacheKey spawnCacheKey_{};
+    bool spawnCacheValid_ = false;
 
     // Parameter smoothers for continuous params (prevents zipper noise)
     ParamSmoother pitchSmoother_;
@@ -200,6 +640,84 @@ private:
     ParamSmoother grainSizeSmoother_;
     ParamSmoother panSmoother_;
     ParamSmoother volumeSmoother_;
+    ParamSmoother filterFreqSmoother_;
+    ParamSmoother filterResSmoother_;
+    ParamSmoother distAmountSmoother_;
+    ParamSmoother delayTimeSmoother_;
+    ParamSmoother delayFeedbackSmoother_;
+    ParamSmoother delayMixSmoother_;
+    ParamSmoother reverbMixSmoother_;
+
+    // Post-mix filter, and the dry copy kept while it fades in or out
+    StereoSvf filter_;
+    bool filterActive_ = false;
+    float filterDryL_[FX_CHUNK_SIZE];
+    float filterDryR_[FX_CHUNK_SIZE];
+
+    // Post-mix distortion and its per-frame drive for one control sub-block
+    Distortion distortion_;
+    bool distortionActive_ = false;
+    float distDrive_[CONTROL_BLOCK_SIZE];
+
+    // Post-mix delay and its per-frame controls for one control sub-block
+    StereoDelay delay_;
+    bool delayActive_ = false;
+    float delayFrames_[CONTROL_BLOCK_SIZE];
+    float delayFeedback_[CONTROL_BLOCK_SIZE];
+    float delayMix_[CONTROL_BLOCK_SIZE];
+
+    // Post-mix reverb and its per-frame wet mix for one chunk
+    FdnReverb reverb_;
+    bool reverbActive_ = false;
+    int activeReverbType_ = 0;       // Stage that rendered the last chunk
+    float reverbMix_[FX_CHUNK_SIZE];
+
+    // Convolution reverb. Ownership moves control -> pending -> convolver_
+    // (audio thread) -> retired -> freed by the next IR load or clear.
+    PartitionedConvolver* convolver_ = nullptr;
+    std::atomic<PartitionedConvolver*> pendingConvolver_{nullptr};
+    std::atomic<PartitionedConvolver*> retiredConvolver_{nullptr};
+    std::atomic<bool> clearConvolverRequested_{false};
+    ConvolverCost impulseCost_{};
+    float* impulseStaging_ = nullptr;
+    PartitionedConvolver* impulseSpectraStaging_ = nullptr;
+    int impulseStagingLength_ = 0;
+    int impulseStagingChannels_ = 0;
+
+    // Master limiter (bypassed under a host that limits the mix), and the
+    // aux buses' delay by its latency
+    MasterLimiter limiter_;
+    bool limiterBypassed_ = false;
+    LatencyAligner auxAligners_[NUM_AUX_BUSES];
+    float outputPeak_ = 0.0f;
+
+    // Per-grain filters and the lane scratch of the single-threaded path
+    GrainFilterBank grainFilters_;
+    GrainLaneScratch laneScratch_;
+
+    // Parallel rendering. Groups are runs of renderSlots_ (the active slots
+    // in pool order) starting at whole quads, so they depend only on the
+    // active set, and only the last group can pad with the dummy filter slot.
+    WorkerPool renderPool_;
+    int renderThreads_ = 0;
+    std::vector<GrainLaneScratch> workerScratch_;  // One per worker
+    std::vector<float> groupAcc_;                  // [group][channel][RENDER_CHUNK]
+    int renderSlots_[MAX_GRAINS];
+    int groupStart_[RENDER_GROUPS + 1];
+    int renderFrames_ = 0;                         // Frames in the current job
+    int renderChannels_ = 2;                       // RENDER_CHANNELS while sending
+
+    // Spectral grain mode: STFT frame store, committed or attached
+    SpectralGranulator spectral_;
+    bool spectralActive_ = false;
+    int lifetimesSpectral_ = 0;   // Render path the grain lifetimes are for (-1 = unknown)
+
+    // Preset morph
+    PresetMorph morph_;
+    ParamSmoother morphSmoother_;
+    bool morphActive_ = false;
+    float appliedMorphPosition_ = -1.0f;
+    EngineParams morphedParams_;
 
     // Freeze / Drift
     bool isFrozen_ = false;
@@ -214,6 +732,9 @@ private:
     GrainEvent grainEvents_[MAX_GRAIN_EVENTS];
     int grainEventCount_ = 0;
 
-    // PRNG state (xorshift32)
-    uint32_t rngState_ = 12345;
+    // Counter-based PRNG (seedable, independent stream per purpose)
+    CounterRng rng_;
+
+    // Heap snapshot for captureState() / restoreStateBuffer()
+    std::unique_ptr<EngineSnapshot> stateBuffer_;
 };
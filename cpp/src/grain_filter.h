@@ -0,0 +1,135 @@
+#pragma once
+
+#include "fast_math.h"
+#include "grain.h"
+#include "simd.h"
+#include "svf_filter.h"
+#include <algorithm>
+
+// Per-grain state-variable filters (same TPT topology as StereoSvf).
+//
+// Coefficients and state live in SoA arrays indexed by pool slot, so four
+// grains are filtered per vector instruction. Index MAX_GRAINS is a silent
+// dummy slot used to pad partially filled groups.
+class GrainFilterBank {
+public:
+    static constexpr int kDummySlot = MAX_GRAINS;
+
+    GrainFilterBank() {
+        for (int i = 0; i < kSlots; ++i) {
+            a1_[i] = 1.0f;
+            a2_[i] = a3_[i] = k_[i] = 0.0f;
+            ic1eq_[i] = ic2eq_[i] = 0.0f;
+        }
+    }
+
+    void setMode(FilterMode mode) { mode_ = mode; }
+    FilterMode getMode() const { return mode_; }
+
+    // Set coefficients for newly spawned grains and clear their state.
+    // cutoffHz/q must be readable up to `count` rounded up to whole vectors.
+    void setGrains(const int* slots, const float* cutoffHz, const float* q,
+                   int count, float sampleRate) {
+        using namespace simd;
+        const f32x4 minHz = splat(10.0f);
+        const f32x4 maxHz = splat(sampleRate * 0.49f);
+        const f32x4 halfInvRate = splat(0.5f / sampleRate);
+        const f32x4 one = splat(1.0f);
+        alignas(16) float a1[kLanes], a2[kLanes], a3[kLanes], k[kLanes];
+
+        for (int i = 0; i < count; i += kLanes) {
+            // g = tan(pi * fc / fs), as a ratio of the fast sine at (fc / 2fs) turns
+            f32x4 turns = max(minHz, min(load(cutoffHz + i), maxHz)) * halfInvRate;
+            f32x4 g = fastmath::sinTurns(turns) / fastmath::sinTurns(turns + splat(0.25f));
+            f32x4 kv = one / max(load(q + i), splat(0.05f));
+            f32x4 a1v = one / (one + g * (g + kv));
+            f32x4 a2v = g * a1v;
+            store(a1, a1v);
+            store(a2, a2v);
+            store(a3, g * a2v);
+            store(k, kv);
+
+            int lanes = std::min(kLanes, count - i);
+            for (int l = 0; l < lanes; ++l) {
+                int s = slots[i + l];
+                a1_[s] = a1[l];
+                a2_[s] = a2[l];
+                a3_[s] = a3[l];
+                k_[s] = k[l];
+                ic1eq_[s] = 0.0f;
+                ic2eq_[s] = 0.0f;
+            }
+        }
+    }
+
+    // Start the given grains' filters as if they had been fed a constant
+    // `input` (one value per grain): every mode's output then begins at its
+    // DC response instead of stepping from zero
+    void settleGrains(const int* slots, const float* input, int count) {
+        for (int i = 0; i < count; ++i) {
+            ic1eq_[slots[i]] = 0.0f;
+            ic2eq_[slots[i]] = input[i];
+        }
+    }
+
+    // Filter four grains in place. `lanes` holds their dry samples interleaved
+    // frame-major (frame i of grain l at lanes[i * 4 + l]).
+    void processGroup(const int* slots, float* lanes, int numFrames) {
+        using namespace simd;
+        const int s0 = slots[0], s1 = slots[1], s2 = slots[2], s3 = slots[3];
+        const f32x4 a1 = set(a1_[s0], a1_[s1], a1_[s2], a1_[s3]);
+        const f32x4 a2 = set(a2_[s0], a2_[s1], a2_[s2], a2_[s3]);
+        const f32x4 a3 = set(a3_[s0], a3_[s1], a3_[s2], a3_[s3]);
+        const f32x4 k = set(k_[s0], k_[s1], k_[s2], k_[s3]);
+        const f32x4 zero = splat(0.0f);
+        const f32x4 one = splat(1.0f);
+        const f32x4 two = splat(2.0f);
+
+        // Mode output = m0 * input + m1 * band + m2 * low
+        f32x4 m0 = zero, m1 = zero, m2 = zero;
+        switch (mode_) {
+            case FilterMode::Lowpass:  m2 = one; break;
+            case FilterMode::Bandpass: m1 = k; break;
+            case FilterMode::Highpass: m0 = one; m1 = zero - k; m2 = zero - one; break;
+            case FilterMode::Notch:    m0 = one; m1 = zero - k; break;
+        }
+
+        f32x4 ic1eq = set(ic1eq_[s0], ic1eq_[s1], ic1eq_[s2], ic1eq_[s3]);
+        f32x4 ic2eq = set(ic2eq_[s0], ic2eq_[s1], ic2eq_[s2], ic2eq_[s3]);
+
+        for (int i = 0; i < numFrames; ++i) {
+            f32x4 v0 = load(lanes + i * kLanes);
+            f32x4 v3 = v0 - ic2eq;
+            f32x4 v1 = a1 * ic1eq + a2 * v3;
+            f32x4 v2 = ic2eq + a2 * ic1eq + a3 * v3;
+            ic1eq = two * v1 - ic1eq;
+            ic2eq = two * v2 - ic2eq;
+            store(lanes + i * kLanes, m0 * v0 + m1 * v1 + m2 * v2);
+        }
+
+        alignas(16) float st1[kLanes], st2[kLanes];
+        store(st1, ic1eq);
+        store(st2, ic2eq);
+        for (int l = 0; l < kLanes; ++l) {
+            ic1eq_[slots[l]] = st1[l];
+            ic2eq_[slots[l]] = st2[l];
+        }
+        // Keep the dummy slot silent (padding fills the trailing lanes, so
+        // only groups that used it touch it)
+        if (s3 == kDummySlot) {
+            ic1eq_[kDummySlot] = 0.0f;
+            ic2eq_[kDummySlot] = 0.0f;
+        }
+    }
+
+private:
+    static constexpr int kSlots = MAX_GRAINS + 1;
+
+    FilterMode mode_ = FilterMode::Lowpass;
+    alignas(16) float a1_[kSlots];
+    alignas(16) float a2_[kSlots];
+    alignas(16) float a3_[kSlots];
+    alignas(16) float k_[kSlots];
+    alignas(16) float ic1eq_[kSlots];
+    alignas(16) float ic2eq_[kSlots];
+};
@@ -0,0 +1,349 @@
+#include "layer_host.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// dst += src * gain[i]
+void addScaled(float* dst, const float* src, const float* gain, int numFrames) {
+    using namespace simd;
+    int i = 0;
+    for (; i + kLanes <= numFrames; i += kLanes) {
+        store(dst + i, load(dst + i) + load(src + i) * load(gain + i));
+    }
+    for (; i < numFrames; ++i) dst[i] += src[i] * gain[i];
+}
+
+}  // namespace
+
+LayerHost::LayerHost() {
+    setMaxBlockSize(LAYER_CHUNK);
+    limiter_.init(sampleRate_);
+    for (LatencyAligner& aligner : auxAligners_) aligner.init(limiter_.getLatency());
+    const EngineParams defaults;
+    setLimiter(defaults.limiterMode, defaults.limiterCeiling, defaults.limiterRelease);
+}
+
+LayerHost::~LayerHost() {
+    renderPool_.stop();
+}
+
+void LayerHost::init(float sampleRate) {
+    sampleRate_ = sampleRate;
+    for (auto& layer : layers_) {
+        layer->engine->init(sampleRate);
+        layer->gain.init(sampleRate, 10.0f);
+        layer->gain.setImmediate(layer->gain.getTarget());
+    }
+    limiter_.init(sampleRate);
+    limiter_.resetMode();
+    for (LatencyAligner& aligner : auxAligners_) aligner.init(limiter_.getLatency());
+    outputPeak_ = 0.0f;
+}
+
+void LayerHost::setNumLayers(int count) {
+    count = std::max(0, std::min(MAX_LAYERS, count));
+    while (static_cast<int>(layers_.size()) > count) layers_.pop_back();
+    while (static_cast<int>(layers_.size()) < count) {
+        auto layer = std::make_unique<Layer>();
+        layer->engine = std::make_unique<GrainEngine>();
+        layer->engine->init(sampleRate_);
+
+        // Distinct random streams per layer; layer 0 matches a lone engine
+        const uint32_t index = static_cast<uint32_t>(layers_.size());
+        GrainEngine& engine = *layer->engine;
+        engine.setSeed(engine.getSeed() + index * 0x9E3779B9u);
+        engine.setLimiterBypass(true);   // The host limits the mix
+
+        layer->gain.init(sampleRate_, 10.0f);
+        layer->gain.setImmediate(1.0f);
+        layers_.push_back(std::move(layer));
+    }
+}
+
+int LayerHost::getNumLayers() const {
+    return static_cast<int>(layers_.size());
+}
+
+GrainEngine* LayerHost::getLayer(int layer) {
+    if (layer < 0 || layer >= getNumLayers()) return nullptr;
+    return layers_[layer]->engine.get();
+}
+
+void LayerHost::setLayerGain(int layer, float gain) {
+    if (layer < 0 || layer >= getNumLayers()) return;
+    layers_[layer]->gain.setTarget(std::max(0.0f, gain));
+}
+
+void LayerHost::setLayerSample(int layer, int slot) {
+    if (layer < 0 || layer >= getNumLayers()) return;
+    layers_[layer]->sampleSlot = (slot >= 0 && slot < MAX_BANK_SLOTS) ? slot : -1;
+    attachLayer(*layers_[layer]);
+}
+
+void LayerHost::attachLayer(Layer& layer) {
+    const int slot = layer.sampleSlot;
+    if (slot >= 0 && bank_[slot].length > 0) {
+        const BankSample& sample = bank_[slot];
+        layer.engine->attachSample(sample.data.data(), sample.channels, sample.length,
+                                   &sample.frames);
+    } else {
+        layer.engine->attachSample(nullptr, 1, 0, nullptr);
+    }
+}
+
+float* LayerHost::allocateSample(int slot, int lengthInSamples) {
+    if (slot < 0 || slot >= MAX_BANK_SLOTS || lengthInSamples <= 0) return nullptr;
+    BankSample& sample = bank_[slot];
+
+    // Layers on this slot go silent until the commit re-attaches them
+    sample.length = 0;
+    for (auto& layer : layers_) {
+        if (layer->sampleSlot == slot) attachLayer(*layer);
+    }
+    std::vector<float>(lengthInSamples, 0.0f).swap(sample.data);
+    return sample.data.data();
+}
+
+void LayerHost::commitSample(int slot, int channels, int lengthInSamples) {
+    if (slot < 0 || slot >= MAX_BANK_SLOTS) return;
+    BankSample& sample = bank_[slot];
+    sample.channels = channels;
+    sample.length = std::max(0, std::min(lengthInSamples, static_cast<int>(sample.data.size())));
+
+    // The previous sample's frames don't fit; new ones come when needed
+    sample.frames.clear();
+    for (auto& layer : layers_) {
+        if (layer->sampleSlot == slot) attachLayer(*layer);
+    }
+}
+
+void LayerHost::clearSample(int slot) {
+    if (slot < 0 || slot >= MAX_BANK_SLOTS) return;
+    BankSample& sample = bank_[slot];
+    sample.length = 0;
+    for (auto& layer : layers_) {
+        if (layer->sampleSlot == slot) attachLayer(*layer);
+    }
+    std::vector<float>().swap(sample.data);
+    sample.frames.clear();
+}
+
+float* LayerHost::allocateSampleFrames(int slot, int numFrames, int analysisHop) {
+    if (slot < 0 || slot >= MAX_BANK_SLOTS) return nullptr;
+    return bank_[slot].frames.allocate(numFrames, analysisHop);
+}
+
+int LayerHost::getSampleFramesSize(int slot) const {
+    if (slot < 0 || slot >= MAX_BANK_SLOTS) return 0;
+    return static_cast<int>(bank_[slot].frames.data.size());
+}
+
+bool LayerHost::commitSampleFrames(int slot) {
+    if (slot < 0 || slot >= MAX_BANK_SLOTS) return false;
+    BankSample& sample = bank_[slot];
+    SpectralFrames& frames = sample.frames;
+    if (sample.length <= 0 || frames.analysisHop != SpectralFrames::hopFor(sample.length) ||
+        frames.data.size() != SpectralFrames::sizeFor(SpectralFrames::framesFor(sample.length))) {
+        frames.clear();
+        return false;
+    }
+    // Layers on the slot already point at this store
+    frames.publish();
+    return true;
+}
+
+void LayerHost::setLimiter(int mode, float ceilingDb, float releaseSeconds) {
+    limiterMode_ = std::max(0, std::min(2, mode));
+    limiter_.setCeiling(ceilingDb);
+    limiter_.setRelease(releaseSeconds);
+}
+
+void LayerHost::setGrainBudget(int grains) {
+    grainBudget_ = std::max(0, grains);
+}
+
+int LayerHost::getGrainBudget() const {
+    return grainBudget_;
+}
+
+int LayerHost::getLayerGrainLimit(int layer) const {
+    if (layer < 0 || layer >= getNumLayers()) return 0;
+    return grainLimits_[layer];
+}
+
+void LayerHost::start() {
+    for (auto& layer : layers_) layer->engine->start();
+    limiter_.reset();
+    limiter_.resetMode();
+    for (LatencyAligner& aligner : auxAligners_) aligner.reset();
+}
+
+void LayerHost::stop() {
+    for (auto& layer : layers_) layer->engine->stop();
+}
+
+void LayerHost::distributeGrainBudget() {
+    const int n = getNumLayers();
+    if (n == 0) return;
+
+    int demand[MAX_LAYERS];
+    int order[MAX_LAYERS];
+    int total = 0;
+    for (int i = 0; i < n; ++i) {
+        demand[i] = layers_[i]->engine->getGrainDemand();
+        order[i] = i;
+        total += demand[i];
+    }
+
+    if (total <= grainBudget_) {
+        // Everyone gets their demand, plus an even cut of the slack
+        const int slack = grainBudget_ - total;
+        for (int i = 0; i < n; ++i) {
+            grainLimits_[i] = demand[i] + slack / n + (i < slack % n ? 1 : 0);
+        }
+    } else {
+        // Max-min fair: smallest demands first, each capped at an equal
+        // share of what the layers before it left over
+        std::sort(order, order + n, [&](int a, int b) {
+            return demand[a] != demand[b] ? demand[a] < demand[b] : a < b;
+        });
+        int remaining = grainBudget_;
+        for (int k = 0; k < n; ++k) {
+            const int i = order[k];
+            grainLimits_[i] = std::min(demand[i], remaining / (n - k));
+            remaining -= grainLimits_[i];
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        layers_[i]->engine->setGrainLimit(grainLimits_[i]);
+    }
+}
+
+void LayerHost::renderLayerTask(void* host, int layer, int /*worker*/) {
+    LayerHost& self = *static_cast<LayerHost*>(host);
+    Layer& l = *self.layers_[layer];
+    l.engine->process(l.outL, l.outR, self.chunkFrames_);
+}
+
+void LayerHost::mixLayer(Layer& layer, float* outputL, float* outputR, int numFrames,
+                         int auxOffset) {
+    ParamSmoother& gain = layer.gain;
+    const float target = gain.getTarget();
+    if (std::fabs(gain.getCurrent() - target) < 1e-5f) gain.setImmediate(target);
+    if (gain.getCurrent() == target) {
+        if (target == 0.0f) return;   // Muted: keeps running, adds nothing
+        std::fill(gainRamp_, gainRamp_ + numFrames, target);
+    } else {
+        for (int i = 0; i < numFrames; ++i) gainRamp_[i] = gain.process();
+    }
+
+    addScaled(outputL, layer.outL, gainRamp_, numFrames);
+    addScaled(outputR, layer.outR, gainRamp_, numFrames);
+    const int auxFrames = std::min(numFrames, maxBlockSize_ - auxOffset);
+    if (auxFrames > 0) {
+        for (int bus = 0; bus < NUM_AUX_BUSES; ++bus) {
+            addScaled(auxOutL_[bus].data() + auxOffset, layer.engine->getAuxBufferL(bus),
+                      gainRamp_, auxFrames);
+            addScaled(auxOutR_[bus].data() + auxOffset, layer.engine->getAuxBufferR(bus),
+                      gainRamp_, auxFrames);
+        }
+    }
+}
+
+void LayerHost::process(float* outputL, float* outputR, int numFrames) {
+    std::memset(outputL, 0, numFrames * sizeof(float));
+    std::memset(outputR, 0, numFrames * sizeof(float));
+    distributeGrainBudget();
+
+    const int auxFrames = std::min(numFrames, maxBlockSize_);
+    for (int bus = 0; bus < NUM_AUX_BUSES; ++bus) {
+        std::fill_n(auxOutL_[bus].data(), auxFrames, 0.0f);
+        std::fill_n(auxOutR_[bus].data(), auxFrames, 0.0f);
+    }
+
+    const int n = getNumLayers();
+    for (int done = 0; done < numFrames; done += LAYER_CHUNK) {
+        chunkFrames_ = std::min(LAYER_CHUNK, numFrames - done);
+        renderPool_.run(renderLayerTask, this, n);
+        for (int i = 0; i < n; ++i) {
+            mixLayer(*layers_[i], outputL + done, outputR + done, chunkFrames_, done);
+        }
+        limiter_.processMode(limiterMode_, outputL + done, outputR + done, chunkFrames_);
+
+        // Keep the aux outputs aligned with the limited mix
+        if (done + chunkFrames_ <= maxBlockSize_) {
+            for (int bus = 0; bus < NUM_AUX_BUSES; ++bus) {
+                auxAligners_[bus].process(auxOutL_[bus].data() + done, auxOutR_[bus].data() + done,
+                                          chunkFrames_, limiter_.getModeLatency());
+            }
+        }
+    }
+
+    float peak = outputPeak_;
+    for (int i = 0; i < numFrames; ++i) {
+        peak = std::max(peak, std::max(std::fabs(outputL[i]), std::fabs(outputR[i])));
+    }
+    outputPeak_ = peak;
+}
+
+void LayerHost::setMaxBlockSize(int frames) {
+    maxBlockSize_ = std::max(LAYER_CHUNK, std::min(MAX_BLOCK_SIZE, frames));
+    outputL_.assign(maxBlockSize_, 0.0f);
+    outputR_.assign(maxBlockSize_, 0.0f);
+    for (int b = 0; b < NUM_AUX_BUSES; ++b) {
+        auxOutL_[b].assign(maxBlockSize_, 0.0f);
+        auxOutR_[b].assign(maxBlockSize_, 0.0f);
+    }
+}
+
+int LayerHost::getMaxBlockSize() const {
+    return maxBlockSize_;
+}
+
+float* LayerHost::getOutputBufferL() {
+    return outputL_.data();
+}
+
+float* LayerHost::getOutputBufferR() {
+    return outputR_.data();
+}
+
+float* LayerHost::getAuxBufferL(int bus) {
+    return auxOutL_[std::max(0, std::min(NUM_AUX_BUSES - 1, bus))].data();
+}
+
+float* LayerHost::getAuxBufferR(int bus) {
+    return auxOutR_[std::max(0, std::min(NUM_AUX_BUSES - 1, bus))].data();
+}
+
+EngineStats LayerHost::collectStats() {
+    EngineStats stats{};
+    for (auto& layer : layers_) {
+        EngineStats s = layer->engine->collectStats();
+        stats.activeGrains += s.activeGrains;
+        stats.cpuLoad += s.cpuLoad;
+        stats.grainCap += s.grainCap;
+    }
+    stats.gainReductionDb = limiter_.takeGainReductionDb();
+    stats.limiterLatency = limiter_.getModeLatency();
+    stats.outputPeak = outputPeak_;
+    outputPeak_ = 0.0f;
+    return stats;
+}
+
+void LayerHost::clearGrainEvents() {
+    for (auto& layer : layers_) layer->engine->clearGrainEvents();
+}
+
+void LayerHost::setRenderThreads(int count) {
+    renderPool_.start(std::max(0, count));
+    renderThreads_ = renderPool_.getNumWorkers() - 1;
+}
+
+int LayerHost::getRenderThreads() const {
+    return renderThreads_;
+}
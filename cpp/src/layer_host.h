@@ -0,0 +1,158 @@
+#pragma once
+
+#include "grain_engine.h"
+#include "master_limiter.h"
+#include "param_smoother.h"
+#include "spectral_granulator.h"
+#include "worker_pool.h"
+#include <memory>
+#include <vector>
+
+// Upper bounds for one host (installation patches use up to 8 layers)
+static constexpr int MAX_LAYERS = 16;
+static constexpr int MAX_BANK_SLOTS = 16;
+
+// Frames each layer renders per pass (one scheduling block)
+static constexpr int LAYER_CHUNK = SCHEDULE_BLOCK_SIZE;
+
+// One sample of the shared bank: mono data plus its spectral frame store,
+// both read by every layer attached to the slot
+struct BankSample {
+    std::vector<float> data;
+    int channels = 1;
+    int length = 0;
+    SpectralFrames frames;
+};
+
+// Host for several GrainEngine layers driven by one audio callback.
+//
+// Layers play samples from a shared bank instead of holding their own
+// copies (and spectral analyses), so N layers on one source cost one
+// buffer. A shared grain budget is split across the layers every block by
+// max-min fairness over each layer's demand (GrainEngine::getGrainDemand):
+// layers asking for less than an equal share get what they ask, the rest
+// split what remains, and any slack is spread evenly on top. process()
+// renders every layer, applies its smoothed gain and sums the main and aux
+// outputs, in layer order whatever the thread count. One master limiter
+// runs on the mix; the layers' own limiters are bypassed, since limiting
+// each layer would neither keep the sum under the ceiling nor leave the
+// layers aligned if their modes differed.
+//
+// Each layer is a full engine with its own params, transport and FX chain,
+// controlled through getLayer(). Structural calls (setNumLayers, the bank,
+// setRenderThreads) allocate and must not overlap process().
+class LayerHost {
+public:
+    LayerHost();
+    ~LayerHost();
+
+    void init(float sampleRate);
+
+    // Create or drop layers (new layers start stopped, at unity gain, with
+    // no sample and a seed derived from their index)
+    void setNumLayers(int count);
+    int getNumLayers() const;
+    GrainEngine* getLayer(int layer);
+
+    // Per-layer output gain (linear), smoothed over 10ms
+    void setLayerGain(int layer, float gain);
+
+    // Play bank slot `slot` on a layer (-1 = none)
+    void setLayerSample(int layer, int slot);
+
+    // Shared sample bank: JS writes mono data into the allocated slot, then
+    // commit re-attaches every layer playing the slot
+    float* allocateSample(int slot, int lengthInSamples);
+    void commitSample(int slot, int channels, int lengthInSamples);
+    void clearSample(int slot);
+
+    // A slot's spectral frames, analysed off the audio thread and copied in
+    // as GrainEngine::allocateSpectralFrames does; every layer on the slot
+    // reads them. Commit drops frames that don't fit the slot's sample.
+    float* allocateSampleFrames(int slot, int numFrames, int analysisHop);
+    int getSampleFramesSize(int slot) const;
+    bool commitSampleFrames(int slot);
+
+    // Master limiter on the mix, as EngineParams::limiterMode / Ceiling /
+    // Release (the layers' own settings are ignored)
+    void setLimiter(int mode, float ceilingDb, float releaseSeconds);
+
+    // Total simultaneous grains across all layers (default MAX_GRAINS)
+    void setGrainBudget(int grains);
+    int getGrainBudget() const;
+    int getLayerGrainLimit(int layer) const;
+
+    // Transport for every layer at once
+    void start();
+    void stop();
+
+    // Render and mix all layers (any block length)
+    void process(float* outputL, float* outputR, int numFrames);
+
+    // Size the mixed output and aux buffers, as GrainEngine::setMaxBlockSize
+    void setMaxBlockSize(int frames);
+    int getMaxBlockSize() const;
+
+    // Mixed outputs, same layout and lifetime as GrainEngine's (the aux
+    // outputs delayed by the host limiter's latency)
+    float* getOutputBufferL();
+    float* getOutputBufferR();
+    float* getAuxBufferL(int bus);
+    float* getAuxBufferR(int bus);
+
+    // Summed layer meters: grains, CPU load and grain caps add up; gain
+    // reduction, limiter latency and outputPeak are the mix's
+    EngineStats collectStats();
+
+    // Drop the grain events of every layer (read them through getLayer())
+    void clearGrainEvents();
+
+    // Render layers on `count` helper threads (each layer is one task).
+    // Not real-time safe; 0 = everything on the calling thread.
+    void setRenderThreads(int count);
+    int getRenderThreads() const;
+
+private:
+    struct Layer {
+        std::unique_ptr<GrainEngine> engine;
+        ParamSmoother gain;
+        int sampleSlot = -1;
+        alignas(16) float outL[LAYER_CHUNK];
+        alignas(16) float outR[LAYER_CHUNK];
+    };
+
+    // Point a layer's engine at its bank slot (or at nothing)
+    void attachLayer(Layer& layer);
+
+    // Set every layer's grain limit from the budget and the layer demands
+    void distributeGrainBudget();
+
+    static void renderLayerTask(void* host, int layer, int worker);
+
+    // Add one rendered chunk of a layer into the mix with its gain ramp;
+    // its aux buses go to the aux outputs at `auxOffset` if they reach
+    void mixLayer(Layer& layer, float* outputL, float* outputR, int numFrames, int auxOffset);
+
+    float sampleRate_ = 48000.0f;
+    std::vector<std::unique_ptr<Layer>> layers_;
+    BankSample bank_[MAX_BANK_SLOTS];
+
+    int grainBudget_ = MAX_GRAINS;
+    int grainLimits_[MAX_LAYERS] = {};
+
+    WorkerPool renderPool_;
+    int renderThreads_ = 0;
+    int chunkFrames_ = 0;             // Frames of the chunk being rendered
+
+    MasterLimiter limiter_;
+    int limiterMode_ = 1;
+    LatencyAligner auxAligners_[NUM_AUX_BUSES];   // Aux outputs, by the limiter's latency
+
+    float gainRamp_[LAYER_CHUNK];
+    int maxBlockSize_ = 0;
+    std::vector<float> outputL_;
+    std::vector<float> outputR_;
+    std::vector<float> auxOutL_[NUM_AUX_BUSES];
+    std::vector<float> auxOutR_[NUM_AUX_BUSES];
+    float outputPeak_ = 0.0f;
+};
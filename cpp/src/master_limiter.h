@@ -0,0 +1,403 @@
+#pragma once
+
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Stereo master limiter: lookahead true-peak limiting or a static soft clip.
+//
+// Limiter: the peak detector interpolates each frame 4x with a 48-tap
+// polyphase windowed sinc (12 taps per phase, as in ITU-R BS.1770), the four
+// phases running in the four vector lanes, and takes the larger channel, so
+// intersample overs are caught as well as sample peaks. Sample peaks never
+// pass the ceiling; intersample peaks are read to within ~0.4 dB for content
+// below 20 kHz at 48 kHz, which the default -1 dB ceiling absorbs. The gain each peak needs is held at its minimum across the
+// lookahead window and smoothed by a boxcar of the same length; since the
+// audio is delayed by that window, the gain is fully down when the peak
+// arrives and never overshoots it. Recovery is a one-pole release.
+//
+// Soft clip: linear below half the ceiling, then a rational curve that
+// approaches the ceiling asymptotically. No latency and no state.
+//
+// processMode() runs either (or neither) by mode, crossfading mode changes.
+//
+// init() allocates; process(), processSoftClip(), processMode() and reset()
+// do not.
+class MasterLimiter {
+public:
+    static constexpr int kMaxBlock = 128;          // Largest process() call
+    static constexpr int kTaps = 12;               // Interpolator taps per phase
+    static constexpr int kDetectDelay = kTaps / 2; // Phase 0 sits at x[n - kDetectDelay]
+    static constexpr float kLookaheadSeconds = 0.002f;
+    static constexpr float kSoftKnee = 0.5f;       // Soft clip knee, fraction of the ceiling
+
+    MasterLimiter() {
+        // Phase p interpolates the point p/4 of a frame after x[n - kDetectDelay]
+        for (int p = 0; p < simd::kLanes; ++p) {
+            double taps[kTaps];
+            double sum = 0.0;
+            for (int j = 0; j < kTaps; ++j) {
+                double t = j - (kDetectDelay - 1) - p / static_cast<double>(simd::kLanes);
+                double sinc = (t == 0.0) ? 1.0 : std::sin(M_PI * t) / (M_PI * t);
+                double window = 0.5 + 0.5 * std::cos(M_PI * t / kDetectDelay);
+                taps[j] = std::fabs(t) < kDetectDelay ? sinc * window : 0.0;
+                sum += taps[j];
+            }
+            for (int j = 0; j < kTaps; ++j) {
+                coeffs_[j][p] = static_cast<float>(taps[j] / sum);   // Unity DC gain
+            }
+        }
+    }
+
+    // Size the lookahead and delay line for this sample rate (not real-time safe)
+    void init(float sampleRate) {
+        sampleRate_ = sampleRate;
+        window_ = std::max(1, static_cast<int>(kLookaheadSeconds * sampleRate + 0.5f));
+        delay_ = window_ - 1 + kDetectDelay;
+
+        int size = 1;
+        while (size < delay_ + kMaxBlock) size <<= 1;
+        mask_ = size - 1;
+        for (int c = 0; c < 2; ++c) line_[c].assign(size, 0.0f);
+        boxcar_.assign(window_, 1.0f);
+        holdValue_.assign(window_ + 1, 1.0f);
+        holdIndex_.assign(window_ + 1, 0);
+
+        setRelease(releaseSeconds_);
+        reset();
+    }
+
+    void reset() {
+        for (int c = 0; c < 2; ++c) {
+            std::fill(line_[c].begin(), line_[c].end(), 0.0f);
+            std::memset(history_[c], 0, sizeof(history_[c]));
+        }
+        std::fill(boxcar_.begin(), boxcar_.end(), 1.0f);
+        boxSum_ = window_;
+        boxPos_ = 0;
+        holdHead_ = 0;
+        holdCount_ = 0;
+        frame_ = 0;
+        writePos_ = 0;
+        envelope_ = 1.0f;
+        unityFrames_ = window_;
+        minGain_ = 1.0f;
+    }
+
+    // Output ceiling in dBFS (-24 - 0)
+    void setCeiling(float db) {
+        ceiling_ = std::pow(10.0f, std::max(-24.0f, std::min(0.0f, db)) / 20.0f);
+    }
+
+    // Time constant of the recovery to unity gain
+    void setRelease(float seconds) {
+        releaseSeconds_ = std::max(0.001f, seconds);
+        releaseCoeff_ = 1.0f - std::exp(-1.0f / (releaseSeconds_ * sampleRate_));
+    }
+
+    // Frames the limiter delays its output by
+    int getLatency() const { return delay_; }
+
+    // Largest gain reduction (dB, >= 0) since the last call, then re-arm
+    float takeGainReductionDb() {
+        float db = 20.0f * std::log10(1.0f / std::max(minGain_, 1e-6f));
+        minGain_ = 1.0f;
+        return db;
+    }
+
+    // Limit one block (at most kMaxBlock frames) in place; the output lags
+    // the input by getLatency() frames
+    void process(float* left, float* right, int numFrames) {
+        using namespace simd;
+        float* io[2] = { left, right };
+
+        // True-peak detection over the history + block, one frame per pass
+        float scan[2][kTaps - 1 + kMaxBlock];
+        for (int c = 0; c < 2; ++c) {
+            std::memcpy(scan[c], history_[c], sizeof(history_[c]));
+            std::memcpy(scan[c] + kTaps - 1, io[c], numFrames * sizeof(float));
+        }
+        f32x4 taps[kTaps];
+        for (int j = 0; j < kTaps; ++j) taps[j] = load(coeffs_[j]);
+        float blockPeak = 0.0f;
+        for (int i = 0; i < numFrames; ++i) {
+            f32x4 accL = splat(0.0f);
+            f32x4 accR = splat(0.0f);
+            for (int j = 0; j < kTaps; ++j) {
+                accL = accL + splat(scan[0][i + j]) * taps[j];
+                accR = accR + splat(scan[1][i + j]) * taps[j];
+            }
+            f32x4 m = max(abs(accL), abs(accR));
+            float peak = std::max(std::max(lane<0>(m), lane<1>(m)),
+                                  std::max(lane<2>(m), lane<3>(m)));
+            peak_[i] = peak;
+            blockPeak = std::max(blockPeak, peak);
+        }
+        for (int c = 0; c < 2; ++c) {
+            std::memcpy(history_[c], scan[c] + numFrames, sizeof(history_[c]));
+        }
+
+        // Push the block through the delay line; io now holds delayed audio
+        const int size = mask_ + 1;
+        for (int c = 0; c < 2; ++c) {
+            float* line = line_[c].data();
+            int first = std::min(numFrames, size - writePos_);
+            std::memcpy(line + writePos_, io[c], first * sizeof(float));
+            std::memcpy(line, io[c] + first, (numFrames - first) * sizeof(float));
+
+            int readPos = (writePos_ - delay_) & mask_;
+            first = std::min(numFrames, size - readPos);
+            std::memcpy(io[c], line + readPos, first * sizeof(float));
+            std::memcpy(io[c] + first, line, (numFrames - first) * sizeof(float));
+        }
+        writePos_ = (writePos_ + numFrames) & mask_;
+
+        // Nothing over the ceiling and the whole window at unity: pure delay
+        if (unityFrames_ >= window_ && blockPeak <= ceiling_) {
+            frame_ += numFrames;
+            boxPos_ = (boxPos_ + numFrames) % window_;
+            holdHead_ = 0;
+            holdCount_ = 1;
+            holdValue_[0] = 1.0f;
+            holdIndex_[0] = frame_ - 1;
+            return;
+        }
+
+        const int holdSize = window_ + 1;
+        for (int i = 0; i < numFrames; ++i) {
+            float need = peak_[i] > ceiling_ ? ceiling_ / peak_[i] : 1.0f;
+
+            // Running minimum over the window (monotonic queue)
+            while (holdCount_ > 0 &&
+                   holdValue_[(holdHead_ + holdCount_ - 1) % holdSize] >= need) {
+                --holdCount_;
+            }
+            int back = (holdHead_ + holdCount_) % holdSize;
+            holdValue_[back] = need;
+            holdIndex_[back] = frame_;
+            ++holdCount_;
+            while (frame_ - holdIndex_[holdHead_] >= static_cast<uint32_t>(window_)) {
+                holdHead_ = (holdHead_ + 1) % holdSize;
+                --holdCount_;
+            }
+            float hold = holdValue_[holdHead_];
+
+            // Release toward unity, never above the held gain
+            float env = envelope_ + (1.0f - envelope_) * releaseCoeff_;
+            if (env > 0.999999f) env = 1.0f;
+            env = std::min(env, hold);
+            envelope_ = env;
+            unityFrames_ = (env == 1.0f) ? std::min(unityFrames_ + 1, window_) : 0;
+
+            // Boxcar attack over the lookahead window
+            boxSum_ += env - boxcar_[boxPos_];
+            boxcar_[boxPos_] = env;
+            if (++boxPos_ == window_) boxPos_ = 0;
+            if (unityFrames_ == window_) boxSum_ = window_;   // Drop rounding drift
+            gain_[i] = static_cast<float>(boxSum_ / window_);
+            minGain_ = std::min(minGain_, gain_[i]);
+            ++frame_;
+        }
+
+        int i = 0;
+        for (; i + kLanes <= numFrames; i += kLanes) {
+            f32x4 g = load(gain_ + i);
+            store(left + i, load(left + i) * g);
+            store(right + i, load(right + i) * g);
+        }
+        for (; i < numFrames; ++i) {
+            left[i] *= gain_[i];
+            right[i] *= gain_[i];
+        }
+    }
+
+    // Soft clip in place, four frames per vector
+    void processSoftClip(float* left, float* right, int numFrames) {
+        using namespace simd;
+        const float knee = kSoftKnee * ceiling_;
+        const float range = ceiling_ - knee;
+        const f32x4 vKnee = splat(knee);
+        const f32x4 vInvRange = splat(1.0f / range);
+        const f32x4 vRange = splat(range);
+        const f32x4 zero = splat(0.0f);
+        const f32x4 one = splat(1.0f);
+        f32x4 minGain = one;
+        float* io[2] = { left, right };
+
+        int i = 0;
+        for (; i + kLanes <= numFrames; i += kLanes) {
+            for (int c = 0; c < 2; ++c) {
+                f32x4 x = load(io[c] + i);
+                f32x4 a = abs(x);
+                f32x4 t = max(a - vKnee, zero) * vInvRange;
+                f32x4 y = min(a, vKnee) + vRange * t / (one + t);
+                minGain = min(minGain, select(cmpGt(a, vKnee), y / a, one));
+                store(io[c] + i, select(cmpLt(x, zero), zero - y, y));
+            }
+        }
+        float gain = std::min(std::min(lane<0>(minGain), lane<1>(minGain)),
+                              std::min(lane<2>(minGain), lane<3>(minGain)));
+        for (; i < numFrames; ++i) {
+            for (int c = 0; c < 2; ++c) {
+                float x = io[c][i];
+                float a = std::fabs(x);
+                if (a <= knee) continue;
+                float t = (a - knee) / range;
+                float y = knee + range * t / (1.0f + t);
+                gain = std::min(gain, y / a);
+                io[c][i] = x < 0.0f ? -y : y;
+            }
+        }
+        minGain_ = std::min(minGain_, gain);
+    }
+
+    // Run one block through `mode` (0 = off, 1 = limiter, 2 = soft clip). A
+    // mode change crossfades over the block, since the modes differ in
+    // latency; the first block after resetMode() adopts its mode outright.
+    void processMode(int mode, float* left, float* right, int numFrames) {
+        mode = std::max(0, std::min(2, mode));
+        if (mode_ < 0) mode_ = mode;
+
+        if (mode == mode_) {
+            runMode(mode, left, right, numFrames);
+            return;
+        }
+
+        // Render the block both ways and crossfade, starting the lookahead
+        // line from silence rather than whatever it held when last used
+        std::memcpy(dry_[0], left, numFrames * sizeof(float));
+        std::memcpy(dry_[1], right, numFrames * sizeof(float));
+        runMode(mode_, left, right, numFrames);
+        if (mode == 1) reset();
+        runMode(mode, dry_[0], dry_[1], numFrames);
+
+        float step = 1.0f / numFrames;
+        for (int i = 0; i < numFrames; ++i) {
+            float fade = (i + 1) * step;
+            left[i] += (dry_[0][i] - left[i]) * fade;
+            right[i] += (dry_[1][i] - right[i]) * fade;
+        }
+        mode_ = mode;
+    }
+
+    void resetMode() { mode_ = -1; }
+
+    // Frames processMode() delays its output by in the current mode
+    int getModeLatency() const { return mode_ == 1 ? delay_ : 0; }
+
+private:
+    void runMode(int mode, float* left, float* right, int numFrames) {
+        if (mode == 1) {
+            process(left, right, numFrames);
+        } else if (mode == 2) {
+            processSoftClip(left, right, numFrames);
+        }
+    }
+
+    alignas(16) float coeffs_[kTaps][simd::kLanes];   // Tap j of all four phases
+
+    float sampleRate_ = 48000.0f;
+    float ceiling_ = 1.0f;
+    float releaseSeconds_ = 0.1f;
+    float releaseCoeff_ = 0.0f;
+
+    int window_ = 1;                  // Lookahead in frames
+    int delay_ = kDetectDelay;        // window_ - 1 + kDetectDelay
+    std::vector<float> line_[2];      // Audio delay line, power-of-two ring
+    int mask_ = 0;
+    int writePos_ = 0;
+    float history_[2][kTaps - 1] = {};
+
+    // Gain computer: monotonic min queue, release envelope, boxcar
+    std::vector<float> holdValue_;
+    std::vector<uint32_t> holdIndex_;
+    int holdHead_ = 0;
+    int holdCount_ = 0;
+    uint32_t frame_ = 0;
+    float envelope_ = 1.0f;
+    int unityFrames_ = 0;             // Consecutive frames at unity (capped at window_)
+    std::vector<float> boxcar_;
+    double boxSum_ = 0.0;
+    int boxPos_ = 0;
+
+    float minGain_ = 1.0f;            // Lowest gain since takeGainReductionDb()
+    float peak_[kMaxBlock];
+    alignas(16) float gain_[kMaxBlock];
+
+    int mode_ = -1;                   // Mode of the last processMode() block
+    float dry_[2][kMaxBlock];         // Mode change scratch
+};
+
+// Delays a stereo side signal (an aux bus leaving next to the limited main
+// output) by the limiter's current latency, so the two stay aligned. A
+// latency change crossfades over the block between the old and the new
+// delay, as MasterLimiter::processMode() crossfades the main output.
+//
+// init() allocates; process() and reset() do not.
+class LatencyAligner {
+public:
+    // Size the line for latencies up to maxLatency (not real-time safe)
+    void init(int maxLatency) {
+        int size = 1;
+        while (size < maxLatency + MasterLimiter::kMaxBlock) size <<= 1;
+        mask_ = size - 1;
+        for (int c = 0; c < 2; ++c) line_[c].assign(size, 0.0f);
+        reset();
+    }
+
+    // Clear the line; the next block adopts its latency outright
+    void reset() {
+        for (int c = 0; c < 2; ++c) std::fill(line_[c].begin(), line_[c].end(), 0.0f);
+        writePos_ = 0;
+        latency_ = -1;
+    }
+
+    // Delay one block (at most MasterLimiter::kMaxBlock frames) in place
+    // by `latency` frames (at most init()'s maxLatency)
+    void process(float* left, float* right, int numFrames, int latency) {
+        if (latency_ < 0) latency_ = latency;
+        float* io[2] = { left, right };
+        for (int c = 0; c < 2; ++c) {
+            float* line = line_[c].data();
+            for (int i = 0; i < numFrames; ++i) line[(writePos_ + i) & mask_] = io[c][i];
+        }
+
+        if (latency == latency_) {
+            if (latency == 0) {
+                writePos_ = (writePos_ + numFrames) & mask_;
+                return;
+            }
+            for (int c = 0; c < 2; ++c) {
+                const float* line = line_[c].data();
+                for (int i = 0; i < numFrames; ++i) {
+                    io[c][i] = line[(writePos_ + i - latency) & mask_];
+                }
+            }
+        } else {
+            float step = 1.0f / numFrames;
+            for (int c = 0; c < 2; ++c) {
+                const float* line = line_[c].data();
+                for (int i = 0; i < numFrames; ++i) {
+                    float from = line[(writePos_ + i - latency_) & mask_];
+                    float to = line[(writePos_ + i - latency) & mask_];
+                    io[c][i] = from + (to - from) * ((i + 1) * step);
+                }
+            }
+            latency_ = latency;
+        }
+        writePos_ = (writePos_ + numFrames) & mask_;
+    }
+
+private:
+    std::vector<float> line_[2];
+    int mask_ = 0;
+    int writePos_ = 0;
+    int latency_ = -1;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+// Held notes in polyphonic mode (GrainEngine::setPolyphonic)
+static constexpr int MAX_NOTES = 16;
+
+// Linear ADSR amplitude envelope, advanced at control rate. Every segment
+// starts from the current level, so retriggers and early releases never jump.
+class AdsrEnvelope {
+public:
+    enum Stage { Idle, Attack, Decay, Sustain, Release };
+
+    // Times in seconds, sustain as a level (0 - 1)
+    void setTimes(float attack, float decay, float sustain, float release, float sampleRate) {
+        attackStep_ = 1.0f / std::max(1.0f, attack * sampleRate);
+        decayFrames_ = std::max(1.0f, decay * sampleRate);
+        sustain_ = std::max(0.0f, std::min(1.0f, sustain));
+        releaseFrames_ = std::max(1.0f, release * sampleRate);
+    }
+
+    void gateOn() { stage_ = Attack; }
+
+    void gateOff() {
+        if (stage_ == Idle || stage_ == Release) return;
+        stage_ = Release;
+        releaseStep_ = level_ / releaseFrames_;
+    }
+
+    // Silence immediately (the voice is being reused)
+    void reset() {
+        stage_ = Idle;
+        level_ = 0.0f;
+    }
+
+    // Advance by `frames` samples; returns the level at the end
+    float advance(int frames) {
+        float left = static_cast<float>(frames);
+        while (left > 0.0f) {
+            switch (stage_) {
+                case Attack: {
+                    float need = (1.0f - level_) / attackStep_;
+                    if (need > left) { level_ += attackStep_ * left; return level_; }
+                    level_ = 1.0f;
+                    left -= need;
+                    stage_ = Decay;
+                    break;
+                }
+                case Decay: {
+                    float step = (1.0f - sustain_) / decayFrames_;
+                    float need = step > 0.0f ? (level_ - sustain_) / step : 0.0f;
+                    if (need > left) { level_ -= step * left; return level_; }
+                    level_ = sustain_;
+                    left -= std::max(0.0f, need);
+                    stage_ = Sustain;
+                    break;
+                }
+                case Sustain:
+                    level_ = sustain_;
+                    return level_;
+                case Release: {
+                    float need = releaseStep_ > 0.0f ? level_ / releaseStep_ : 0.0f;
+                    if (need > left) { level_ -= releaseStep_ * left; return level_; }
+                    level_ = 0.0f;
+                    stage_ = Idle;
+                    return level_;
+                }
+                case Idle:
+                    return level_;
+            }
+        }
+        return level_;
+    }
+
+    float getLevel() const { return level_; }
+    bool isGateOn() const { return stage_ != Idle && stage_ != Release; }
+    bool isIdle() const { return stage_ == Idle; }
+
+private:
+    Stage stage_ = Idle;
+    float level_ = 0.0f;
+    float attackStep_ = 1.0f;
+    float decayFrames_ = 1.0f;
+    float sustain_ = 1.0f;
+    float releaseFrames_ = 1.0f;
+    float releaseStep_ = 0.0f;
+};
+
+// One held (or releasing) note: its own grain stream at a pitch offset,
+// scaled by velocity and the ADSR level
+struct NoteVoice {
+    bool active = false;
+    int noteId = -1;             // Host's note identifier (e.g. MIDI note)
+    float pitchRatio = 1.0f;     // Playback-rate factor of the pitch offset
+    float velocity = 1.0f;       // (0 - 1)
+    AdsrEnvelope env;
+    double nextGrainTime = 0.0;  // When this note's stream spawns next
+    uint32_t age = 0;            // Note-on order, oldest stolen first on ties
+
+    // Grain gain ramp over the current block (velocity * envelope)
+    float gainStart = 0.0f;
+    float gainStep = 0.0f;
+
+    // Weight for sharing the grain pool: held notes by velocity, releasing
+    // notes by their fading level, so quiet tails give up grains first
+    float priority() const {
+        if (env.isGateOn()) return std::max(0.05f, velocity);
+        return 0.25f * std::max(0.001f, velocity * env.getLevel());
+    }
+};
@@ -0,0 +1,265 @@
+#include "offline_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+OfflineRenderer::OfflineRenderer() = default;
+
+OfflineRenderer::~OfflineRenderer() {
+    pool_.stop();
+}
+
+void OfflineRenderer::init(float sampleRate) {
+    sampleRate_ = sampleRate;
+}
+
+void OfflineRenderer::setSample(const float* data, int channels, int lengthInSamples) {
+    sampleData_ = data;
+    sampleChannels_ = channels;
+    sampleLength_ = data ? std::max(0, lengthInSamples) : 0;
+    spectralFrames_.clear();
+    framesValid_ = false;
+}
+
+void OfflineRenderer::setImpulseResponse(const float* data, int lengthInSamples, int channels) {
+    impulseLength_ = data ? std::max(0, lengthInSamples) : 0;
+    impulseChannels_ = std::max(1, channels);
+    impulse_.assign(data, data + static_cast<size_t>(impulseLength_) * impulseChannels_);
+}
+
+void OfflineRenderer::setSeed(uint32_t seed) {
+    seed_ = seed;
+}
+
+void OfflineRenderer::setParams(const EngineParams& params) {
+    params_ = params;
+}
+
+void OfflineRenderer::addEvent(const OfflineEvent& event) {
+    events_.push_back(event);
+}
+
+void OfflineRenderer::clearEvents() {
+    events_.clear();
+}
+
+void OfflineRenderer::setChunkSeconds(float seconds) {
+    chunkSeconds_ = std::max(0.0f, seconds);
+}
+
+void OfflineRenderer::setThreads(int count) {
+    pool_.start(std::max(0, count));
+    threads_ = pool_.getNumWorkers() - 1;
+}
+
+int OfflineRenderer::getThreads() const {
+    return threads_;
+}
+
+bool OfflineRenderer::canRenderChunked() const {
+    return threads_ > 0 && !usesSpectralGrains();
+}
+
+bool OfflineRenderer::usesSpectralGrains() const {
+    if (params_.grainMode == 1) return true;
+    for (const OfflineEvent& event : events_) {
+        if (event.type == OfflineEvent::Params && event.params.grainMode == 1) return true;
+    }
+    return false;
+}
+
+std::unique_ptr<GrainEngine> OfflineRenderer::createEngine(bool withImpulse) const {
+    auto engine = std::make_unique<GrainEngine>();
+    engine->init(sampleRate_);
+    engine->setSeed(seed_);
+    engine->attachSample(sampleData_, sampleChannels_, sampleLength_,
+                         framesValid_ ? &spectralFrames_ : nullptr);
+    if (withImpulse && impulseLength_ > 0) {
+        float* dst = engine->allocateImpulseBuffer(impulseLength_, impulseChannels_);
+        std::copy(impulse_.begin(), impulse_.end(), dst);
+        engine->commitImpulseBuffer();
+    }
+    engine->updateParams(params_);
+    engine->start();
+    return engine;
+}
+
+void OfflineRenderer::applyEvents(GrainEngine& engine, size_t& next, int64_t frame) const {
+    while (next < events_.size() && events_[next].frame < frame + SCHEDULE_BLOCK_SIZE) {
+        const OfflineEvent& event = events_[next++];
+        switch (event.type) {
+            case OfflineEvent::Params:
+                engine.updateParams(event.params);
+                break;
+            case OfflineEvent::NoteOn:
+                engine.noteOn(event.noteId, event.pitch, event.velocity);
+                break;
+            case OfflineEvent::NoteOff:
+                engine.noteOff(event.noteId);
+                break;
+            case OfflineEvent::AllNotesOff:
+                engine.allNotesOff();
+                break;
+            case OfflineEvent::Polyphonic:
+                engine.setPolyphonic(event.enabled);
+                break;
+            case OfflineEvent::Freeze:
+                engine.setFrozen(event.enabled, event.position);
+                break;
+        }
+    }
+}
+
+void OfflineRenderer::render(float* outputL, float* outputR, int64_t numFrames) {
+    if (numFrames <= 0) return;
+    std::stable_sort(events_.begin(), events_.end(),
+                     [](const OfflineEvent& a, const OfflineEvent& b) { return a.frame < b.frame; });
+
+    chunkFrames_ = std::max(SCHEDULE_BLOCK_SIZE,
+                            static_cast<int>(chunkSeconds_ * sampleRate_) /
+                                SCHEDULE_BLOCK_SIZE * SCHEDULE_BLOCK_SIZE);
+    if (canRenderChunked() && numFrames > chunkFrames_) {
+        renderChunked(outputL, outputR, numFrames);
+        return;
+    }
+
+    // Spectral grains read the sample's frame store
+    if (!framesValid_ && sampleData_ && usesSpectralGrains()) {
+        spectralFrames_.analyze(sampleData_, sampleLength_);
+        framesValid_ = true;
+    }
+    renderSerial(outputL, outputR, numFrames);
+}
+
+void OfflineRenderer::renderSerial(float* outputL, float* outputR, int64_t numFrames) {
+    std::unique_ptr<GrainEngine> engine = createEngine(true);
+    size_t next = 0;
+    for (int64_t frame = 0; frame < numFrames; frame += SCHEDULE_BLOCK_SIZE) {
+        int n = static_cast<int>(std::min<int64_t>(SCHEDULE_BLOCK_SIZE, numFrames - frame));
+        applyEvents(*engine, next, frame);
+        engine->process(outputL + frame, outputR + frame, n);
+    }
+}
+
+void OfflineRenderer::renderChunked(float* outputL, float* outputR, int64_t numFrames) {
+    // Every grain sounding in a chunk spawned at most one grain length
+    // (plus the block it spawned in) before it
+    const int maxGrain = static_cast<int>(std::ceil(MAX_GRAIN_SECONDS * sampleRate_));
+    warmupFrames_ = (maxGrain / SCHEDULE_BLOCK_SIZE + 2) * SCHEDULE_BLOCK_SIZE;
+
+    withSends_ = params_.fxRouting != 0;
+    for (const OfflineEvent& event : events_) {
+        if (event.type == OfflineEvent::Params && event.params.fxRouting != 0) withSends_ = true;
+    }
+
+    // One worker runs the FX pass, the others a chunk each
+    waveChunks_ = std::max(1, pool_.getNumWorkers() - 1);
+    const int channels = withSends_ ? RENDER_CHANNELS : 2;
+    for (std::vector<DryChunk>& wave : waves_) {
+        wave.resize(waveChunks_);
+        for (DryChunk& chunk : wave) {
+            for (int c = 0; c < RENDER_CHANNELS; ++c) {
+                if (c < channels) chunk.channels[c].assign(chunkFrames_, 0.0f);
+                else std::vector<float>().swap(chunk.channels[c]);
+            }
+        }
+    }
+
+    renderFrames_ = numFrames;
+    outputL_ = outputL;
+    outputR_ = outputR;
+    cueEngine_ = createEngine(false);
+    cueNextEvent_ = 0;
+    cueFrame_ = 0;
+    wetEngine_ = createEngine(true);
+    wetNextEvent_ = 0;
+
+    const int64_t numChunks = (numFrames + chunkFrames_ - 1) / chunkFrames_;
+    int64_t next = 0;
+    int wave = 0;
+    wetWaveCount_ = 0;
+    while (next < numChunks || wetWaveCount_ > 0) {
+        dryWaveStart_ = next;
+        dryWaveCount_ = static_cast<int>(std::min<int64_t>(waveChunks_, numChunks - next));
+        dryWave_ = wave;
+        cueWave(waves_[wave]);
+        pool_.run(&OfflineRenderer::waveTask, this, 1 + dryWaveCount_);
+
+        wetWaveStart_ = dryWaveStart_;
+        wetWaveCount_ = dryWaveCount_;
+        wetWave_ = wave;
+        next += dryWaveCount_;
+        wave ^= 1;
+    }
+
+    cueEngine_.reset();
+    wetEngine_.reset();
+    for (std::vector<DryChunk>& w : waves_) std::vector<DryChunk>().swap(w);
+}
+
+void OfflineRenderer::waveTask(void* renderer, int task, int /*worker*/) {
+    OfflineRenderer& self = *static_cast<OfflineRenderer*>(renderer);
+    if (task == 0) {
+        self.renderWetWave();
+    } else {
+        self.renderDryChunk(self.dryWaveStart_ + task - 1, self.waves_[self.dryWave_][task - 1]);
+    }
+}
+
+int64_t OfflineRenderer::warmStart(int64_t chunk) const {
+    return std::max<int64_t>(0, chunk * chunkFrames_ - warmupFrames_);
+}
+
+void OfflineRenderer::cueWave(std::vector<DryChunk>& wave) {
+    // Serial, but skipping costs a small fraction of rendering
+    for (int k = 0; k < dryWaveCount_; ++k) {
+        const int64_t target = warmStart(dryWaveStart_ + k);
+        for (; cueFrame_ < target; cueFrame_ += SCHEDULE_BLOCK_SIZE) {
+            applyEvents(*cueEngine_, cueNextEvent_, cueFrame_);
+            cueEngine_->skip(SCHEDULE_BLOCK_SIZE);
+        }
+        cueEngine_->saveState(wave[k].warmState);
+        wave[k].warmEvent = cueNextEvent_;
+    }
+}
+
+void OfflineRenderer::renderDryChunk(int64_t chunk, DryChunk& dry) {
+    const int64_t chunkStart = chunk * chunkFrames_;
+    const int64_t chunkEnd = std::min(renderFrames_, chunkStart + chunkFrames_);
+
+    // Warm-up output (and unused send buses) go to scratch
+    alignas(16) float scratch[RENDER_CHANNELS][SCHEDULE_BLOCK_SIZE];
+    float* channels[RENDER_CHANNELS];
+
+    std::unique_ptr<GrainEngine> engine = createEngine(false);
+    engine->restoreState(dry.warmState);
+    size_t next = dry.warmEvent;
+    for (int64_t frame = warmStart(chunk); frame < chunkEnd; frame += SCHEDULE_BLOCK_SIZE) {
+        int n = static_cast<int>(std::min<int64_t>(SCHEDULE_BLOCK_SIZE, chunkEnd - frame));
+        applyEvents(*engine, next, frame);
+        for (int c = 0; c < RENDER_CHANNELS; ++c) {
+            std::vector<float>& out = dry.channels[c];
+            channels[c] = (frame < chunkStart || out.empty()) ? scratch[c]
+                                                              : out.data() + (frame - chunkStart);
+        }
+        engine->renderDry(channels, n);
+    }
+}
+
+void OfflineRenderer::renderWetWave() {
+    const float* channels[RENDER_CHANNELS];
+    for (int k = 0; k < wetWaveCount_; ++k) {
+        const DryChunk& dry = waves_[wetWave_][k];
+        const int64_t chunkStart = (wetWaveStart_ + k) * chunkFrames_;
+        const int64_t chunkEnd = std::min(renderFrames_, chunkStart + chunkFrames_);
+        for (int64_t frame = chunkStart; frame < chunkEnd; frame += SCHEDULE_BLOCK_SIZE) {
+            int n = static_cast<int>(std::min<int64_t>(SCHEDULE_BLOCK_SIZE, chunkEnd - frame));
+            for (int c = 0; c < RENDER_CHANNELS; ++c) {
+                const std::vector<float>& in = dry.channels[c];
+                channels[c] = in.empty() ? nullptr : in.data() + (frame - chunkStart);
+            }
+            applyEvents(*wetEngine_, wetNextEvent_, frame);
+            wetEngine_->processDry(channels, outputL_ + frame, outputR_ + frame, n);
+        }
+    }
+}
@@ -0,0 +1,145 @@
+#pragma once
+
+#include "grain_engine.h"
+#include "spectral_granulator.h"
+#include "worker_pool.h"
+#include <memory>
+#include <vector>
+
+// One timeline entry. Events take effect at the start of the scheduling
+// block (SCHEDULE_BLOCK_SIZE) holding their frame, in the order added.
+struct OfflineEvent {
+    enum Type { Params, NoteOn, NoteOff, AllNotesOff, Polyphonic, Freeze };
+
+    int64_t frame = 0;
+    Type type = Params;
+    EngineParams params;     // Params
+    int noteId = 0;          // NoteOn, NoteOff
+    float pitch = 0.0f;      // NoteOn (semitones)
+    float velocity = 1.0f;   // NoteOn
+    bool enabled = false;    // Polyphonic, Freeze
+    float position = 0.0f;   // Freeze
+};
+
+// Offline render of a seed and a timeline, split into time chunks that
+// render in parallel and stitch to the exact samples of a serial render
+// (one GrainEngine, process() in SCHEDULE_BLOCK_SIZE blocks, no render
+// threads).
+//
+// The grain layer is the costly part and it only remembers its grains,
+// whose ends are fixed when they spawn. A cue engine replays the timeline
+// once with GrainEngine::skip() (scheduling, random draws and grain
+// lifetimes, no audio) and snapshots its state one maximum grain length
+// before every chunk. A chunk engine restores that snapshot, renders the
+// warm-up with renderDry() so every grain reaching the chunk has played
+// from its start, then renders the chunk's grain layer. The FX chain
+// keeps endless tails (feedback, reverb, the limiter), so one engine runs
+// it serially over the stitched grain layer with processDry(), for one
+// wave of chunks while the pool renders the next. Memory is two waves of
+// chunks.
+//
+// Timelines that use spectral grains (grainMode 1) render serially.
+class OfflineRenderer {
+public:
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    void init(float sampleRate);
+
+    // Source sample (mono data, read in place: it must outlive render())
+    void setSample(const float* data, int channels, int lengthInSamples);
+
+    // Convolution reverb IR (planar channels, copied)
+    void setImpulseResponse(const float* data, int lengthInSamples, int channels);
+
+    void setSeed(uint32_t seed);
+
+    // Params at frame 0, and the timeline after it
+    void setParams(const EngineParams& params);
+    void addEvent(const OfflineEvent& event);
+    void clearEvents();
+
+    // Chunk length (seconds, rounded to whole blocks; default 5)
+    void setChunkSeconds(float seconds);
+
+    // Render chunks on `count` helper threads besides the caller (0 = a
+    // plain serial render). Starts threads; not real-time safe.
+    void setThreads(int count);
+    int getThreads() const;
+
+    // True if render() can split the current timeline into chunks
+    bool canRenderChunked() const;
+
+    // Render numFrames from the transport start into outputL/outputR
+    void render(float* outputL, float* outputR, int64_t numFrames);
+
+private:
+    // The grain layer of one chunk, RENDER_CHANNELS planar channels (the
+    // send buses only when the timeline sends), and the engine state and
+    // next event where its warm-up starts
+    struct DryChunk {
+        std::vector<float> channels[RENDER_CHANNELS];
+        EngineSnapshot warmState;
+        size_t warmEvent = 0;
+    };
+
+    // Any grainMode 1 in the params or the timeline
+    bool usesSpectralGrains() const;
+
+    // Fresh engine at frame 0: seed, sample, params, transport started
+    std::unique_ptr<GrainEngine> createEngine(bool withImpulse) const;
+
+    // Apply the events due before the block at `frame`, advancing `next`
+    void applyEvents(GrainEngine& engine, size_t& next, int64_t frame) const;
+
+    void renderSerial(float* outputL, float* outputR, int64_t numFrames);
+    void renderChunked(float* outputL, float* outputR, int64_t numFrames);
+
+    // Pool job: task 0 runs the FX pass over the previous wave, the rest
+    // render the current wave's chunks
+    static void waveTask(void* renderer, int task, int worker);
+    int64_t warmStart(int64_t chunk) const;
+    void cueWave(std::vector<DryChunk>& wave);
+    void renderDryChunk(int64_t chunk, DryChunk& dry);
+    void renderWetWave();
+
+    float sampleRate_ = 48000.0f;
+    const float* sampleData_ = nullptr;
+    int sampleChannels_ = 1;
+    int sampleLength_ = 0;
+    SpectralFrames spectralFrames_;   // Analysed for spectral timelines only
+    bool framesValid_ = false;
+    std::vector<float> impulse_;
+    int impulseLength_ = 0;
+    int impulseChannels_ = 0;
+    uint32_t seed_ = 12345;
+
+    EngineParams params_;
+    std::vector<OfflineEvent> events_;   // Sorted by frame before a render
+
+    float chunkSeconds_ = 5.0f;
+    WorkerPool pool_;
+    int threads_ = 0;
+
+    // Current render: two waves of chunks (the one rendering, the one in
+    // the FX pass), the serial FX engine and its position in the timeline
+    std::vector<DryChunk> waves_[2];
+    int chunkFrames_ = 0;
+    int warmupFrames_ = 0;
+    int waveChunks_ = 0;
+    bool withSends_ = false;
+    int64_t renderFrames_ = 0;
+    int64_t dryWaveStart_ = 0;        // First chunk of the wave being rendered
+    int dryWaveCount_ = 0;
+    int dryWave_ = 0;
+    int64_t wetWaveStart_ = 0;        // First chunk of the wave in the FX pass
+    int wetWaveCount_ = 0;
+    int wetWave_ = 0;
+    std::unique_ptr<GrainEngine> cueEngine_;
+    size_t cueNextEvent_ = 0;
+    int64_t cueFrame_ = 0;
+    std::unique_ptr<GrainEngine> wetEngine_;
+    size_t wetNextEvent_ = 0;
+    float* outputL_ = nullptr;
+    float* outputR_ = nullptr;
+};
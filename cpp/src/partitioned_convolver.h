@@ -0,0 +1,251 @@
+#pragma once
+
+#include "fft.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+// Estimated per-IR cost, reported back to the UI after loading
+struct ConvolverCost {
+    int partitions;          // IR partitions of kBlockSize frames (per channel)
+    int latencyFrames;       // 0 when driven in whole 128-frame blocks
+    float flopsPerBlock;     // Both channels: FFTs + spectral multiply-adds
+    float mflops;            // flopsPerBlock at the given sample rate, in millions/s
+    float memoryBytes;       // Spectra + frequency-domain delay line
+};
+
+// Uniformly partitioned overlap-save convolution (stereo).
+//
+// The IR is cut into kBlockSize-frame partitions whose 2*kBlockSize-point
+// spectra are computed once in prepare(). Each block, the input spectrum is
+// pushed into a frequency-domain delay line (FDL) and the output spectrum is
+// the sum over partitions of FDL[p] * H[p], four bins per vector. With the
+// block size equal to the 128-frame render quantum the wet path adds no
+// latency.
+//
+// prepare() allocates and transforms, so it must run off the audio thread;
+// process() and reset() are allocation-free. A mono IR is applied to both
+// channels; a stereo IR maps channel to channel.
+//
+// The IR spectra can also be computed without a convolver (transform(),
+// e.g. in a helper thread's own WASM instance) and copied into one:
+// allocate() sizes a convolver for them and returns where they go. Layout:
+// per channel, the real parts of every partition, then the imaginary parts,
+// partition-major with kPaddedBins floats per partition.
+class PartitionedConvolver {
+public:
+    static constexpr int kBlockSize = 128;
+    static constexpr int kFftSize = 2 * kBlockSize;
+    static constexpr int kBins = kFftSize / 2 + 1;
+    static constexpr int kPaddedBins = (kBins + simd::kLanes - 1) / simd::kLanes * simd::kLanes;
+
+    PartitionedConvolver() : fft_(kFftSize) {}
+
+    // Floats of IR spectra for an IR of `partitions` partitions
+    static size_t spectraSize(int numChannels, int partitions) {
+        return 2 * static_cast<size_t>(numChannels) * partitions * kPaddedBins;
+    }
+
+    // Size the convolver for an IR of `partitions` partitions and return its
+    // (zeroed) spectra to fill in. Not real-time safe.
+    float* allocate(int numChannels, int partitions) {
+        numChannels_ = std::max(1, std::min(numChannels, 2));
+        partitions_ = std::max(1, partitions);
+        const size_t fdlSize = static_cast<size_t>(partitions_) * kPaddedBins;
+        spectra_.assign(spectraSize(numChannels_, partitions_), 0.0f);
+        for (int c = 0; c < 2; ++c) {
+            fdlRe_[c].assign(fdlSize, 0.0f);
+            fdlIm_[c].assign(fdlSize, 0.0f);
+        }
+        reset();
+        return spectra_.data();
+    }
+
+    // Partition and transform an IR (planar channels). Not real-time safe.
+    bool prepare(const float* const* channels, int numChannels, int length) {
+        if (numChannels < 1 || length < 1) return false;
+        float* spectra = allocate(numChannels, partitionsFor(length));
+        transform(fft_, channels, numChannels_, length, spectra);
+        return true;
+    }
+
+    // Partitions of an IR of `length` frames
+    static int partitionsFor(int length) {
+        return (length + kBlockSize - 1) / kBlockSize;
+    }
+
+    // Write the spectra of an IR (spectraSize() floats, layout above) without
+    // a convolver, e.g. to copy into one elsewhere. `fft` is kFftSize points.
+    static void transform(RealFft& fft, const float* const* channels, int numChannels,
+                          int length, float* spectra) {
+        const int partitions = partitionsFor(length);
+        const size_t half = static_cast<size_t>(partitions) * kPaddedBins;
+        float block[kFftSize];
+        for (int c = 0; c < numChannels; ++c) {
+            float* re = spectra + 2 * c * half;
+            float* im = re + half;
+            for (int p = 0; p < partitions; ++p) {
+                int start = p * kBlockSize;
+                int n = std::min(kBlockSize, length - start);
+                std::memset(block, 0, sizeof(block));
+                std::memcpy(block, channels[c] + start, n * sizeof(float));
+                fft.forward(block, re + p * kPaddedBins, im + p * kPaddedBins);
+            }
+        }
+    }
+
+    // prepare() for channels stored back to back, `length` frames each
+    bool preparePlanar(const float* planar, int numChannels, int length) {
+        const float* channels[2] = { planar, planar + (numChannels > 1 ? length : 0) };
+        return prepare(channels, numChannels, length);
+    }
+
+    size_t getSpectraSize() const { return spectra_.size(); }
+
+    bool isReady() const { return partitions_ > 0; }
+    int getLength() const { return partitions_ * kBlockSize; }   // Padded IR length
+    int getLatency() const { return buffered_ ? kBlockSize : 0; }
+
+    void reset() {
+        for (int c = 0; c < 2; ++c) {
+            std::fill(fdlRe_[c].begin(), fdlRe_[c].end(), 0.0f);
+            std::fill(fdlIm_[c].begin(), fdlIm_[c].end(), 0.0f);
+            std::memset(window_[c], 0, sizeof(window_[c]));
+            std::memset(wet_[c], 0, sizeof(wet_[c]));
+        }
+        fdlHead_ = 0;
+        fill_ = 0;
+        buffered_ = false;
+    }
+
+    // Convolve in place, blending dry and wet by mix[i] (0..1).
+    // Whole, aligned 128-frame blocks run with zero latency; after any other
+    // block size the convolver switches to a FIFO with kBlockSize latency.
+    void process(float* left, float* right, const float* mix, int numFrames) {
+        if (partitions_ == 0) return;
+        float* io[2] = { left, right };
+
+        int i = 0;
+        while (i < numFrames) {
+            if (!buffered_ && fill_ == 0 && numFrames - i >= kBlockSize) {
+                // Direct path: convolve this block and emit it immediately
+                for (int c = 0; c < 2; ++c) {
+                    std::memcpy(window_[c] + kBlockSize, io[c] + i, kBlockSize * sizeof(float));
+                }
+                processBlock();
+                for (int j = 0; j < kBlockSize; ++j) {
+                    float m = mix[i + j];
+                    for (int c = 0; c < 2; ++c) {
+                        float dry = io[c][i + j];
+                        io[c][i + j] = dry + (wet_[c][j] - dry) * m;
+                    }
+                }
+                i += kBlockSize;
+                continue;
+            }
+
+            // FIFO path: emit the previous block's output while filling this one
+            buffered_ = true;
+            for (int c = 0; c < 2; ++c) {
+                float dry = io[c][i];
+                window_[c][kBlockSize + fill_] = dry;
+                io[c][i] = dry + (wet_[c][fill_] - dry) * mix[i];
+            }
+            ++i;
+            if (++fill_ == kBlockSize) {
+                processBlock();
+                fill_ = 0;
+            }
+        }
+    }
+
+    // Rough cost model: two real FFTs plus 8 flops per bin per partition
+    ConvolverCost estimateCost(float sampleRate) const {
+        constexpr int log2Half = 7;   // log2(kFftSize / 2)
+        const float fftFlops = 5.0f * (kFftSize / 2) * log2Half + 10.0f * (kFftSize / 2);
+        const float perChannel = 2.0f * fftFlops + 8.0f * kBins * partitions_;
+        ConvolverCost cost;
+        cost.partitions = partitions_;
+        cost.latencyFrames = getLatency();
+        cost.flopsPerBlock = 2.0f * perChannel;
+        cost.mflops = cost.flopsPerBlock * (sampleRate / kBlockSize) * 1e-6f;
+        cost.memoryBytes = (2.0f * numChannels_ + 4.0f) * partitions_ * kPaddedBins * sizeof(float);
+        return cost;
+    }
+
+private:
+    // Convolve window_[c][kBlockSize..] (the newest block) into wet_[c]
+    void processBlock() {
+        using namespace simd;
+        float spectrumRe[kPaddedBins];
+        float spectrumIm[kPaddedBins];
+        float result[kFftSize];
+
+        // Newest spectrum goes to the FDL head; partition p pairs with head - p
+        fdlHead_ = (fdlHead_ == 0) ? partitions_ - 1 : fdlHead_ - 1;
+
+        for (int c = 0; c < 2; ++c) {
+            float* fdlRe = fdlRe_[c].data();
+            float* fdlIm = fdlIm_[c].data();
+            fft_.forward(window_[c], fdlRe + fdlHead_ * kPaddedBins, fdlIm + fdlHead_ * kPaddedBins);
+
+            const int irChannel = std::min(c, numChannels_ - 1);
+            const float* irRe = this->irRe(irChannel);
+            const float* irIm = this->irIm(irChannel);
+
+            f32x4 accRe[kPaddedBins / kLanes];
+            f32x4 accIm[kPaddedBins / kLanes];
+            for (int v = 0; v < kPaddedBins / kLanes; ++v) {
+                accRe[v] = splat(0.0f);
+                accIm[v] = splat(0.0f);
+            }
+
+            // Complex multiply-accumulate, four bins per vector
+            int slot = fdlHead_;
+            for (int p = 0; p < partitions_; ++p) {
+                const float* xr = fdlRe + slot * kPaddedBins;
+                const float* xi = fdlIm + slot * kPaddedBins;
+                const float* hr = irRe + p * kPaddedBins;
+                const float* hi = irIm + p * kPaddedBins;
+                for (int v = 0; v < kPaddedBins / kLanes; ++v) {
+                    int b = v * kLanes;
+                    f32x4 ar = load(xr + b), ai = load(xi + b);
+                    f32x4 br = load(hr + b), bi = load(hi + b);
+                    accRe[v] = accRe[v] + ar * br - ai * bi;
+                    accIm[v] = accIm[v] + ar * bi + ai * br;
+                }
+                if (++slot == partitions_) slot = 0;
+            }
+
+            for (int v = 0; v < kPaddedBins / kLanes; ++v) {
+                store(spectrumRe + v * kLanes, accRe[v]);
+                store(spectrumIm + v * kLanes, accIm[v]);
+            }
+            fft_.inverse(spectrumRe, spectrumIm, result);
+
+            // Overlap-save: the second half is the valid linear convolution
+            std::memcpy(wet_[c], result + kBlockSize, kBlockSize * sizeof(float));
+            // Slide the input window for the next block
+            std::memcpy(window_[c], window_[c] + kBlockSize, kBlockSize * sizeof(float));
+        }
+    }
+
+    float* irRe(int c) { return spectra_.data() + 2 * c * partitions_ * kPaddedBins; }
+    float* irIm(int c) { return irRe(c) + partitions_ * kPaddedBins; }
+
+    RealFft fft_;
+    int numChannels_ = 0;
+    int partitions_ = 0;
+
+    // IR spectra (layout in the class comment) and, per channel, the FDL,
+    // partition-major with kPaddedBins floats per partition
+    std::vector<float> spectra_;
+    std::vector<float> fdlRe_[2], fdlIm_[2];
+    int fdlHead_ = 0;
+
+    float window_[2][kFftSize];    // Previous block + current block
+    float wet_[2][kBlockSize];     // Output of the last processed block
+    int fill_ = 0;                 // Frames of the current block (FIFO path)
+    bool buffered_ = false;        // Sticky once a partial block is seen
+};
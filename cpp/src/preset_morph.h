@@ -0,0 +1,95 @@
+#pragma once
+
+#include "engine_params.h"
+#include "fast_math.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr int MAX_MORPH_SNAPSHOTS = 8;
+
+// Morph between up to MAX_MORPH_SNAPSHOTS EngineParams snapshots from a
+// single 0..1 position. Snapshots are laid out evenly along the position axis and
+// neighbouring pairs are interpolated.
+//
+// - Continuous fields interpolate linearly
+// - Frequency-like fields (lfoRate, filterFreq, grainFilterFreq) interpolate
+//   in log2 space; the log2 values are precomputed when a snapshot is stored
+// - Discrete fields (envelopeCurve, lfoShape, lfoTargetMask) switch at the
+//   midpoint of a segment
+class PresetMorph {
+public:
+    void setSnapshot(int index, const EngineParams& params) {
+        if (index < 0 || index >= MAX_MORPH_SNAPSHOTS) return;
+        Snapshot& snap = snapshots_[index];
+        snap.params = params;
+        snap.logLfoRate = std::log2(std::max(params.lfoRate, 1e-3f));
+        snap.logFilterFreq = std::log2(std::max(params.filterFreq, 1.0f));
+        snap.logGrainFilterFreq = std::log2(std::max(params.grainFilterFreq, 1.0f));
+        count_ = std::max(count_, index + 1);
+    }
+
+    void clear() { count_ = 0; }
+    int getCount() const { return count_; }
+    bool isReady() const { return count_ >= 2; }
+
+    // Blend the snapshots at `position` (0..1) into `out`
+    void blend(float position, EngineParams& out) const {
+        if (count_ <= 0) return;
+        if (count_ == 1) {
+            out = snapshots_[0].params;
+            return;
+        }
+
+        float x = std::max(0.0f, std::min(1.0f, position)) * static_cast<float>(count_ - 1);
+        int seg = std::min(static_cast<int>(x), count_ - 2);
+        float t = x - static_cast<float>(seg);
+        const Snapshot& a = snapshots_[seg];
+        const Snapshot& b = snapshots_[seg + 1];
+
+        // Discrete fields come from the nearer snapshot
+        out = (t < 0.5f) ? a.params : b.params;
+
+        for (float EngineParams::* field : kLinearFields) {
+            out.*field = a.params.*field + (b.params.*field - a.params.*field) * t;
+        }
+
+        out.lfoRate = fastmath::exp2(a.logLfoRate + (b.logLfoRate - a.logLfoRate) * t);
+        out.filterFreq = fastmath::exp2(a.logFilterFreq +
+                                        (b.logFilterFreq - a.logFilterFreq) * t);
+        out.grainFilterFreq = fastmath::exp2(a.logGrainFilterFreq +
+                                             (b.logGrainFilterFreq - a.logGrainFilterFreq) * t);
+    }
+
+private:
+    struct Snapshot {
+        EngineParams params;
+        float logLfoRate = 0.0f;
+        float logFilterFreq = 0.0f;
+        float logGrainFilterFreq = 0.0f;
+    };
+
+    static constexpr float EngineParams::* kLinearFields[] = {
+        &EngineParams::grainSize, &EngineParams::density,
+        &EngineParams::spread, &EngineParams::position,
+        &EngineParams::grainReversalChance, &EngineParams::pan,
+        &EngineParams::panSpread, &EngineParams::pitch,
+        &EngineParams::detune, &EngineParams::fmFreq,
+        &EngineParams::fmAmount, &EngineParams::attack,
+        &EngineParams::release, &EngineParams::lfoAmount,
+        &EngineParams::volume, &EngineParams::filterRes,
+        &EngineParams::distAmount, &EngineParams::delayTime,
+        &EngineParams::delayFeedback, &EngineParams::delayMix,
+        &EngineParams::delayDamping, &EngineParams::reverbMix,
+        &EngineParams::reverbDecay, &EngineParams::reverbDamping,
+        &EngineParams::spectralFormant, &EngineParams::spectralSmear,
+        &EngineParams::sendDelay, &EngineParams::sendReverb,
+        &EngineParams::sendSpread, &EngineParams::limiterCeiling,
+        &EngineParams::limiterRelease, &EngineParams::noteAttack,
+        &EngineParams::noteDecay, &EngineParams::noteSustain,
+        &EngineParams::noteRelease, &EngineParams::grainFilterRes,
+        &EngineParams::grainFilterSpread,
+    };
+
+    Snapshot snapshots_[MAX_MORPH_SNAPSHOTS];
+    int count_ = 0;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "simd.h"
+#include <cstdint>
+
+// Independent random streams, one per purpose, so adding a draw for one
+// feature never shifts the sequence seen by another
+enum class RngStream : int {
+    Pitch = 0,      // Detune
+    Reversal = 1,
+    Position = 2,   // Spread offset
+    Pan = 3,
+    Drift = 4,
+    GrainFilter = 5, // Per-grain cutoff and resonance
+    Spectral = 6,   // Spectral grain phases and smear
+    Send = 7,       // Per-grain aux send levels
+    Count
+};
+
+// Counter-based generator: value = hash(key(seed, stream), counter).
+//
+// There is no serial state dependency between draws, so a batch of draws is
+// computed 4 lanes at a time, and the n-th draw of a stream is the same no
+// matter which thread or render chunk computes it. The hash is an integer
+// finaliser (xorshift-multiply, 32-bit) that only needs mul-lo, which every
+// SIMD backend in simd.h provides.
+class CounterRng {
+public:
+    static constexpr int kNumStreams = static_cast<int>(RngStream::Count);
+
+    CounterRng() { setSeed(12345); }
+
+    // Reseed all streams and rewind their counters
+    void setSeed(uint32_t seed) {
+        seed_ = seed;
+        for (int s = 0; s < kNumStreams; ++s) {
+            key_[s] = mix(seed ^ mix(0x9E3779B9u * static_cast<uint32_t>(s + 1)));
+            counter_[s] = 0;
+        }
+    }
+
+    uint32_t getSeed() const { return seed_; }
+
+    // Draw position of a stream (number of values consumed so far)
+    uint32_t getCounter(RngStream stream) const {
+        return counter_[static_cast<int>(stream)];
+    }
+    void setCounter(RngStream stream, uint32_t counter) {
+        counter_[static_cast<int>(stream)] = counter;
+    }
+
+    // Random value at an explicit counter, without advancing the stream
+    uint32_t uintAt(RngStream stream, uint32_t counter) const {
+        return mix(counter * 0x9E3779B9u ^ key_[static_cast<int>(stream)]);
+    }
+
+    // Next value in 0..1
+    float nextFloat(RngStream stream) {
+        int s = static_cast<int>(stream);
+        return toUnit(uintAt(stream, counter_[s]++));
+    }
+
+    // Fill `count` values in 0..1 from one stream (4 draws per vector)
+    void fill(RngStream stream, float* out, int count) {
+        using namespace simd;
+        int s = static_cast<int>(stream);
+        uint32_t base = counter_[s];
+        const i32x4 key = splatInt(static_cast<int32_t>(key_[s]));
+        const i32x4 golden = splatInt(static_cast<int32_t>(0x9E3779B9u));
+        const f32x4 unit = splat(1.0f / 16777216.0f);
+        alignas(16) uint32_t lane[kLanes];
+
+        int i = 0;
+        for (; i + kLanes <= count; i += kLanes) {
+            for (int l = 0; l < kLanes; ++l) lane[l] = base + static_cast<uint32_t>(i + l);
+            i32x4 h = mix(load(lane) * golden ^ key);
+            store(out + i, toFloat(shr(h, 8)) * unit);
+        }
+        for (; i < count; ++i) {
+            out[i] = toUnit(uintAt(stream, base + static_cast<uint32_t>(i)));
+        }
+        counter_[s] = base + static_cast<uint32_t>(count);
+    }
+
+private:
+    static uint32_t mix(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x21f0aaadu;
+        x ^= x >> 15;
+        x *= 0x735a2d97u;
+        x ^= x >> 15;
+        return x;
+    }
+
+    static simd::i32x4 mix(simd::i32x4 x) {
+        using namespace simd;
+        x = x ^ shr(x, 16);
+        x = x * splatInt(static_cast<int32_t>(0x21f0aaadu));
+        x = x ^ shr(x, 15);
+        x = x * splatInt(static_cast<int32_t>(0x735a2d97u));
+        x = x ^ shr(x, 15);
+        return x;
+    }
+
+    // Top 24 bits -> exactly representable float in [0, 1)
+    static float toUnit(uint32_t x) {
+        return static_cast<float>(x >> 8) * (1.0f / 16777216.0f);
+    }
+
+    uint32_t seed_ = 0;
+    uint32_t key_[kNumStreams];
+    uint32_t counter_[kNumStreams];
+};
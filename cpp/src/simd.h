@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+// Minimal 4-lane vector types used by the batch DSP kernels.
+//
+// Backends (picked at compile time):
+//   - WebAssembly SIMD128 when built with -msimd128 (USE_SIMD=ON)
+//   - SSE2 for native hosts
+//   - Plain scalar arrays otherwise (the compiler may still auto-vectorize)
+//
+// Only the handful of operations the engine needs are wrapped; everything
+// is inline and allocation-free so it is safe on the audio thread.
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define NODEGRAIN_SIMD_WASM 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define NODEGRAIN_SIMD_SSE2 1
+#endif
+
+namespace simd {
+
+static constexpr int kLanes = 4;
+
+#if defined(NODEGRAIN_SIMD_WASM)
+
+struct f32x4 { v128_t v; };
+struct i32x4 { v128_t v; };
+
+inline f32x4 load(const float* p)          { return { wasm_v128_load(p) }; }
+inline void  store(float* p, f32x4 a)      { wasm_v128_store(p, a.v); }
+inline f32x4 splat(float x)                { return { wasm_f32x4_splat(x) }; }
+inline i32x4 load(const int32_t* p)        { return { wasm_v128_load(p) }; }
+inline i32x4 load(const uint32_t* p)       { return { wasm_v128_load(p) }; }
+inline void  store(int32_t* p, i32x4 a)    { wasm_v128_store(p, a.v); }
+inline void  store(uint32_t* p, i32x4 a)   { wasm_v128_store(p, a.v); }
+inline i32x4 splatInt(int32_t x)           { return { wasm_i32x4_splat(x) }; }
+inline f32x4 set(float a, float b, float c, float d) { return { wasm_f32x4_make(a, b, c, d) }; }
+template <int N> inline float lane(f32x4 a) { return wasm_f32x4_extract_lane(a.v, N); }
+
+inline f32x4 operator+(f32x4 a, f32x4 b)   { return { wasm_f32x4_add(a.v, b.v) }; }
+inline f32x4 operator-(f32x4 a, f32x4 b)   { return { wasm_f32x4_sub(a.v, b.v) }; }
+inline f32x4 operator*(f32x4 a, f32x4 b)   { return { wasm_f32x4_mul(a.v, b.v) }; }
+inline f32x4 operator/(f32x4 a, f32x4 b)   { return { wasm_f32x4_div(a.v, b.v) }; }
+inline f32x4 min(f32x4 a, f32x4 b)         { return { wasm_f32x4_pmin(a.v, b.v) }; }
+inline f32x4 max(f32x4 a, f32x4 b)         { return { wasm_f32x4_pmax(a.v, b.v) }; }
+inline f32x4 abs(f32x4 a)                  { return { wasm_f32x4_abs(a.v) }; }
+// Sum of all four lanes, broadcast to every lane
+inline f32x4 sumLanes(f32x4 a) {
+    v128_t s = wasm_f32x4_add(a.v, wasm_i32x4_shuffle(a.v, a.v, 1, 0, 3, 2));
+    return { wasm_f32x4_add(s, wasm_i32x4_shuffle(s, s, 2, 3, 0, 1)) };
+}
+
+// Comparisons return an all-ones / all-zeros lane mask
+inline f32x4 cmpLt(f32x4 a, f32x4 b)       { return { wasm_f32x4_lt(a.v, b.v) }; }
+inline f32x4 cmpGt(f32x4 a, f32x4 b)       { return { wasm_f32x4_gt(a.v, b.v) }; }
+// mask ? a : b
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    return { wasm_v128_bitselect(a.v, b.v, mask.v) };
+}
+
+inline i32x4 roundToInt(f32x4 a) {
+    return { wasm_i32x4_trunc_sat_f32x4(wasm_f32x4_nearest(a.v)) };
+}
+inline f32x4 toFloat(i32x4 a)              { return { wasm_f32x4_convert_i32x4(a.v) }; }
+inline f32x4 asFloat(i32x4 a)              { return { a.v }; }
+inline i32x4 asInt(f32x4 a)                { return { a.v }; }
+
+inline i32x4 operator+(i32x4 a, i32x4 b)   { return { wasm_i32x4_add(a.v, b.v) }; }
+inline i32x4 operator-(i32x4 a, i32x4 b)   { return { wasm_i32x4_sub(a.v, b.v) }; }
+inline i32x4 operator*(i32x4 a, i32x4 b)   { return { wasm_i32x4_mul(a.v, b.v) }; }
+inline i32x4 operator^(i32x4 a, i32x4 b)   { return { wasm_v128_xor(a.v, b.v) }; }
+inline i32x4 operator&(i32x4 a, i32x4 b)   { return { wasm_v128_and(a.v, b.v) }; }
+inline i32x4 operator|(i32x4 a, i32x4 b)   { return { wasm_v128_or(a.v, b.v) }; }
+inline i32x4 shl(i32x4 a, int n)           { return { wasm_i32x4_shl(a.v, n) }; }
+inline i32x4 shr(i32x4 a, int n)           { return { wasm_u32x4_shr(a.v, n) }; }
+
+#elif defined(NODEGRAIN_SIMD_SSE2)
+
+struct f32x4 { __m128 v; };
+struct i32x4 { __m128i v; };
+
+inline f32x4 load(const float* p)          { return { _mm_loadu_ps(p) }; }
+inline void  store(float* p, f32x4 a)      { _mm_storeu_ps(p, a.v); }
+inline f32x4 splat(float x)                { return { _mm_set1_ps(x) }; }
+inline i32x4 load(const int32_t* p)        { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+inline i32x4 load(const uint32_t* p)       { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+inline void  store(int32_t* p, i32x4 a)    { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+inline void  store(uint32_t* p, i32x4 a)   { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), a.v); }
+inline i32x4 splatInt(int32_t x)           { return { _mm_set1_epi32(x) }; }
+inline f32x4 set(float a, float b, float c, float d) { return { _mm_setr_ps(a, b, c, d) }; }
+template <int N> inline float lane(f32x4 a) {
+    return _mm_cvtss_f32(_mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(N, N, N, N)));
+}
+
+inline f32x4 operator+(f32x4 a, f32x4 b)   { return { _mm_add_ps(a.v, b.v) }; }
+inline f32x4 operator-(f32x4 a, f32x4 b)   { return { _mm_sub_ps(a.v, b.v) }; }
+inline f32x4 operator*(f32x4 a, f32x4 b)   { return { _mm_mul_ps(a.v, b.v) }; }
+inline f32x4 operator/(f32x4 a, f32x4 b)   { return { _mm_div_ps(a.v, b.v) }; }
+inline f32x4 min(f32x4 a, f32x4 b)         { return { _mm_min_ps(a.v, b.v) }; }
+inline f32x4 max(f32x4 a, f32x4 b)         { return { _mm_max_ps(a.v, b.v) }; }
+inline f32x4 abs(f32x4 a) {
+    return { _mm_and_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff))) };
+}
+inline f32x4 sumLanes(f32x4 a) {
+    __m128 s = _mm_add_ps(a.v, _mm_shuffle_ps(a.v, a.v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return { _mm_add_ps(s, _mm_shuffle_ps(s, s, _MM_SHUFFLE(1, 0, 3, 2))) };
+}
+
+inline f32x4 cmpLt(f32x4 a, f32x4 b)       { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline f32x4 cmpGt(f32x4 a, f32x4 b)       { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) };
+}
+
+// Uses the current MXCSR rounding mode (round-to-nearest-even by default)
+inline i32x4 roundToInt(f32x4 a)           { return { _mm_cvtps_epi32(a.v) }; }
+inline f32x4 toFloat(i32x4 a)              { return { _mm_cvtepi32_ps(a.v) }; }
+inline f32x4 asFloat(i32x4 a)              { return { _mm_castsi128_ps(a.v) }; }
+inline i32x4 asInt(f32x4 a)                { return { _mm_castps_si128(a.v) }; }
+
+inline i32x4 operator+(i32x4 a, i32x4 b)   { return { _mm_add_epi32(a.v, b.v) }; }
+inline i32x4 operator-(i32x4 a, i32x4 b)   { return { _mm_sub_epi32(a.v, b.v) }; }
+inline i32x4 operator*(i32x4 a, i32x4 b) {
+    // SSE2 has no 32-bit mullo; multiply even/odd lanes separately
+    __m128i even = _mm_mul_epu32(a.v, b.v);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.v, 32), _mm_srli_epi64(b.v, 32));
+    return { _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))) };
+}
+inline i32x4 operator^(i32x4 a, i32x4 b)   { return { _mm_xor_si128(a.v, b.v) }; }
+inline i32x4 operator&(i32x4 a, i32x4 b)   { return { _mm_and_si128(a.v, b.v) }; }
+inline i32x4 operator|(i32x4 a, i32x4 b)   { return { _mm_or_si128(a.v, b.v) }; }
+inline i32x4 shl(i32x4 a, int n)           { return { _mm_slli_epi32(a.v, n) }; }
+inline i32x4 shr(i32x4 a, int n)           { return { _mm_srli_epi32(a.v, n) }; }
+
+#else
+
+struct f32x4 { float v[4]; };
+struct i32x4 { uint32_t v[4]; };
+
+#define NODEGRAIN_SIMD_LANEWISE(expr) \
+    for (int l = 0; l < 4; ++l) { expr; }
+
+inline f32x4 load(const float* p)          { f32x4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void  store(float* p, f32x4 a)      { std::memcpy(p, a.v, sizeof(a.v)); }
+inline f32x4 splat(float x)                { return { { x, x, x, x } }; }
+inline i32x4 load(const int32_t* p)        { i32x4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline i32x4 load(const uint32_t* p)       { i32x4 r; std::memcpy(r.v, p, sizeof(r.v)); return r; }
+inline void  store(int32_t* p, i32x4 a)    { std::memcpy(p, a.v, sizeof(a.v)); }
+inline void  store(uint32_t* p, i32x4 a)   { std::memcpy(p, a.v, sizeof(a.v)); }
+inline i32x4 splatInt(int32_t x) {
+    uint32_t u = static_cast<uint32_t>(x);
+    return { { u, u, u, u } };
+}
+inline f32x4 set(float a, float b, float c, float d) { return { { a, b, c, d } }; }
+template <int N> inline float lane(f32x4 a) { return a.v[N]; }
+
+inline f32x4 operator+(f32x4 a, f32x4 b)   { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] + b.v[l]) return r; }
+inline f32x4 operator-(f32x4 a, f32x4 b)   { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] - b.v[l]) return r; }
+inline f32x4 operator*(f32x4 a, f32x4 b)   { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] * b.v[l]) return r; }
+inline f32x4 operator/(f32x4 a, f32x4 b)   { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] / b.v[l]) return r; }
+inline f32x4 min(f32x4 a, f32x4 b)         { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = b.v[l] < a.v[l] ? b.v[l] : a.v[l]) return r; }
+inline f32x4 max(f32x4 a, f32x4 b)         { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] < b.v[l] ? b.v[l] : a.v[l]) return r; }
+inline f32x4 abs(f32x4 a)                  { f32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = std::fabs(a.v[l])) return r; }
+inline f32x4 sumLanes(f32x4 a) {
+    float s = (a.v[0] + a.v[1]) + (a.v[2] + a.v[3]);
+    return { { s, s, s, s } };
+}
+
+inline f32x4 maskFromBool(bool b0, bool b1, bool b2, bool b3) {
+    uint32_t bits[4] = { b0 ? 0xffffffffu : 0u, b1 ? 0xffffffffu : 0u,
+                         b2 ? 0xffffffffu : 0u, b3 ? 0xffffffffu : 0u };
+    f32x4 r;
+    std::memcpy(r.v, bits, sizeof(bits));
+    return r;
+}
+inline f32x4 cmpLt(f32x4 a, f32x4 b) {
+    return maskFromBool(a.v[0] < b.v[0], a.v[1] < b.v[1], a.v[2] < b.v[2], a.v[3] < b.v[3]);
+}
+inline f32x4 cmpGt(f32x4 a, f32x4 b)       { return cmpLt(b, a); }
+inline f32x4 select(f32x4 mask, f32x4 a, f32x4 b) {
+    uint32_t m[4], x[4], y[4];
+    std::memcpy(m, mask.v, sizeof(m));
+    std::memcpy(x, a.v, sizeof(x));
+    std::memcpy(y, b.v, sizeof(y));
+    NODEGRAIN_SIMD_LANEWISE(x[l] = (x[l] & m[l]) | (y[l] & ~m[l]))
+    f32x4 r;
+    std::memcpy(r.v, x, sizeof(x));
+    return r;
+}
+
+inline i32x4 roundToInt(f32x4 a) {
+    i32x4 r;
+    NODEGRAIN_SIMD_LANEWISE(r.v[l] = static_cast<uint32_t>(static_cast<int32_t>(std::nearbyint(a.v[l]))))
+    return r;
+}
+inline f32x4 toFloat(i32x4 a) {
+    f32x4 r;
+    NODEGRAIN_SIMD_LANEWISE(r.v[l] = static_cast<float>(static_cast<int32_t>(a.v[l])))
+    return r;
+}
+inline f32x4 asFloat(i32x4 a)              { f32x4 r; std::memcpy(r.v, a.v, sizeof(r.v)); return r; }
+inline i32x4 asInt(f32x4 a)                { i32x4 r; std::memcpy(r.v, a.v, sizeof(r.v)); return r; }
+
+inline i32x4 operator+(i32x4 a, i32x4 b)   { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] + b.v[l]) return r; }
+inline i32x4 operator-(i32x4 a, i32x4 b)   { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] - b.v[l]) return r; }
+inline i32x4 operator*(i32x4 a, i32x4 b)   { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] * b.v[l]) return r; }
+inline i32x4 operator^(i32x4 a, i32x4 b)   { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] ^ b.v[l]) return r; }
+inline i32x4 operator&(i32x4 a, i32x4 b)   { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] & b.v[l]) return r; }
+inline i32x4 operator|(i32x4 a, i32x4 b)   { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] | b.v[l]) return r; }
+inline i32x4 shl(i32x4 a, int n)           { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] << n) return r; }
+inline i32x4 shr(i32x4 a, int n)           { i32x4 r; NODEGRAIN_SIMD_LANEWISE(r.v[l] = a.v[l] >> n) return r; }
+
+#undef NODEGRAIN_SIMD_LANEWISE
+
+#endif
+
+} // namespace simd
@@ -0,0 +1,362 @@
+#pragma once
+
+#include "fast_math.h"
+#include "fft.h"
+#include "grain.h"
+#include "rng.h"
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// STFT frame store of one mono source: per analysis frame, the magnitudes
+// and per-bin instantaneous frequencies (measured between two FFTs one
+// synthesis hop apart, so the estimate stays valid however sparse the frames
+// are). Read-only once built, so engines playing the same source can share
+// one store.
+//
+// analyze() builds it in place; a store built elsewhere (the web build's
+// prep worker) is copied into allocate()'s block and published by publish().
+struct SpectralFrames {
+    static constexpr int kFftSize = 1024;
+    static constexpr int kHop = kFftSize / 4;   // Synthesis hop (75% overlap)
+    static constexpr int kBins = kFftSize / 2 + 1;
+    static constexpr int kPaddedBins = (kBins + simd::kLanes - 1) / simd::kLanes * simd::kLanes;
+    static constexpr int kMaxFrames = 4096;     // Longer sources get a sparser analysis hop
+
+    // Magnitudes of every frame, then the instantaneous frequencies (turns
+    // per sample) of every frame; frame-major, kPaddedBins floats per frame
+    std::vector<float> data;
+    int numFrames = 0;
+    int analysisHop = kHop;
+
+    // Analysis hop and frame count for a source of `length` samples
+    static int hopFor(int length) {
+        return std::max(kHop, (length + kMaxFrames - 2) / (kMaxFrames - 1));
+    }
+    static int framesFor(int length) { return length > 0 ? length / hopFor(length) + 1 : 0; }
+
+    // Floats in the store of `frames` frames
+    static size_t sizeFor(int frames) { return 2 * static_cast<size_t>(frames) * kPaddedBins; }
+
+    const float* magFrame(int f) const { return data.data() + static_cast<size_t>(f) * kPaddedBins; }
+    const float* freqFrame(int f) const {
+        return data.data() + static_cast<size_t>(numFrames + f) * kPaddedBins;
+    }
+
+    // Size the store for `frames` frames `hop` samples apart and return it
+    // for filling; it reads as empty until publish(). Not real-time safe.
+    float* allocate(int frames, int hop) {
+        numFrames = 0;
+        analysisHop = std::max(1, hop);
+        data.assign(sizeFor(std::max(0, frames)), 0.0f);
+        return data.data();
+    }
+
+    // Make the allocated frames readable
+    void publish() { numFrames = static_cast<int>(data.size() / sizeFor(1)); }
+
+    // Build the store for a mono buffer. Not real-time safe.
+    void analyze(const float* samples, int length) {
+        numFrames = 0;
+        if (!samples || length <= 0) return;
+
+        RealFft fft(kFftSize);
+        float window[kFftSize];
+        for (int i = 0; i < kFftSize; ++i) {
+            window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / kFftSize));
+        }
+
+        const int frames = framesFor(length);
+        float* mag = allocate(frames, hopFor(length));
+        float* freq = mag + static_cast<size_t>(frames) * kPaddedBins;
+
+        float block[kFftSize];
+        float re[kPaddedBins], im[kPaddedBins];
+        float prevRe[kPaddedBins], prevIm[kPaddedBins];
+        for (int f = 0; f < frames; ++f) {
+            // Frame f is centred on sample f * analysisHop
+            int centre = f * analysisHop;
+            windowedBlock(samples, length, centre - kFftSize / 2, window, block);
+            fft.forward(block, re, im);
+            windowedBlock(samples, length, centre - kFftSize / 2 - kHop, window, block);
+            fft.forward(block, prevRe, prevIm);
+
+            float* m = mag + static_cast<size_t>(f) * kPaddedBins;
+            float* fr = freq + static_cast<size_t>(f) * kPaddedBins;
+            for (int k = 0; k < kBins; ++k) {
+                m[k] = std::sqrt(re[k] * re[k] + im[k] * im[k]);
+
+                // Phase advance over kHop beyond the bin centre, in turns
+                double expected = static_cast<double>(k) * kHop / kFftSize;
+                double advance = (std::atan2(im[k], re[k]) - std::atan2(prevIm[k], prevRe[k]))
+                                 / (2.0 * M_PI) - expected;
+                advance -= std::floor(advance + 0.5);
+                fr[k] = static_cast<float>((expected + advance) / kHop);   // Turns per sample
+            }
+        }
+        publish();
+    }
+
+    // Release the store's memory
+    void clear() {
+        std::vector<float>().swap(data);
+        numFrames = 0;
+        analysisHop = kHop;
+    }
+
+    size_t memoryBytes() const { return data.capacity() * sizeof(float); }
+
+private:
+    static void windowedBlock(const float* samples, int length, int start,
+                              const float* window, float* out) {
+        for (int i = 0; i < kFftSize; ++i) {
+            int n = start + i;
+            out[i] = (n >= 0 && n < length) ? samples[n] * window[i] : 0.0f;
+        }
+    }
+};
+
+// Phase-vocoder grain synthesis from a precomputed STFT frame store
+// (SpectralFrames: the granulator's own, filled through getOwnFrames(), or
+// one shared via setFrames()).
+//
+// Grains only read the store: each hop, every active grain adds its frame
+// (magnitudes, pitch-mapped bins, running phases) into one stereo spectrum,
+// and the hop costs one inverse FFT per channel plus overlap-add,
+// independent of the grain count.
+//
+// Pitch shifting moves each spectral peak (with its surrounding bins) to the
+// scaled frequency and re-applies the source's spectral envelope at the
+// output bins, so formants stay put. Time and pitch
+// are independent: grains walk the frames at unity speed (or hold a frame
+// while frozen) whatever their pitch.
+//
+// Filling the own store allocates; everything else is allocation-free.
+class SpectralGranulator {
+public:
+    static constexpr int kFftSize = SpectralFrames::kFftSize;
+    static constexpr int kHop = SpectralFrames::kHop;
+    static constexpr int kBins = SpectralFrames::kBins;
+    static constexpr int kPaddedBins = SpectralFrames::kPaddedBins;
+
+    SpectralGranulator() : fft_(kFftSize) {
+        for (int i = 0; i < kFftSize; ++i) {
+            window_[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * M_PI * i / kFftSize));
+        }
+        phase_.assign(static_cast<size_t>(MAX_GRAINS) * kPaddedBins, 0.0f);
+        reset();
+    }
+    SpectralGranulator(const SpectralGranulator&) = delete;
+    SpectralGranulator& operator=(const SpectralGranulator&) = delete;
+
+    // The granulator's own frame store, read unless setFrames() shares another
+    SpectralFrames& getOwnFrames() { return ownFrames_; }
+    const SpectralFrames& getOwnFrames() const { return ownFrames_; }
+
+    // Read a frame store owned elsewhere (shared between engines), or the
+    // own store again with nullptr. The store must outlive its use here.
+    void setFrames(const SpectralFrames* frames) {
+        if (frames) ownFrames_.clear();
+        frames_ = frames ? frames : &ownFrames_;
+    }
+
+    bool isReady() const { return frames_->numFrames > 0; }
+    int getNumFrames() const { return frames_->numFrames; }
+    int getAnalysisHop() const { return frames_->analysisHop; }
+
+    // Drop pending output (the grain phases are reseeded per grain)
+    void reset() {
+        std::memset(sumRe_, 0, sizeof(sumRe_));
+        std::memset(sumIm_, 0, sizeof(sumIm_));
+        std::memset(overlap_, 0, sizeof(overlap_));
+        std::memset(ready_, 0, sizeof(ready_));
+        readPos_ = kHop;
+    }
+
+    // Seed a new grain's bin phases. A frame-centred stationary partial
+    // alternates by half a turn from bin to bin, so that pattern keeps the
+    // bins of each partial coherent; the random offset decorrelates grains.
+    void startGrain(int slot, CounterRng& rng) {
+        float offset = rng.nextFloat(RngStream::Spectral);
+        float* phase = phase_.data() + slot * kPaddedBins;
+        for (int k = 0; k < kPaddedBins; ++k) {
+            phase[k] = offset + ((k & 1) ? 0.5f : 0.0f);
+        }
+    }
+
+    // Add one hop of a grain to the output spectrum. sourcePos is in source
+    // samples, pitchRatio > 0, gainL/gainR include envelope and pan. formant
+    // (0..1) blends from shifting the spectral envelope with the pitch to
+    // keeping it in place; smear (0..1) jitters the bin phases every hop,
+    // washing transients out.
+    void addGrain(int slot, float sourcePos, float pitchRatio, float gainL, float gainR,
+                  float formant, float smear, CounterRng& rng) {
+        using namespace simd;
+
+        // Interpolate magnitudes between the two nearest frames
+        const SpectralFrames& frames = *frames_;
+        const int numFrames = frames.numFrames;
+        float fp = std::max(0.0f, std::min(sourcePos / frames.analysisHop,
+                                           static_cast<float>(numFrames - 1)));
+        int f0 = static_cast<int>(fp);
+        int f1 = std::min(f0 + 1, numFrames - 1);
+        const float frameFrac = fp - static_cast<float>(f0);
+        const f32x4 t = splat(frameFrac);
+        const float* mag0 = frames.magFrame(f0);
+        const float* mag1 = frames.magFrame(f1);
+        const float* freq = frames.freqFrame(frameFrac < 0.5f ? f0 : f1);
+        for (int k = 0; k < kPaddedBins; k += kLanes) {
+            f32x4 a = load(mag0 + k);
+            store(srcMag_ + k, a + (load(mag1 + k) - a) * t);
+        }
+
+        // Output magnitude and frequency (turns per sample) per bin
+        pitchRatio = std::max(0.25f, std::min(4.0f, pitchRatio));
+        if (std::fabs(pitchRatio - 1.0f) < 1e-4f) {
+            std::memcpy(outMag_, srcMag_, sizeof(outMag_));
+            std::memcpy(outFreq_, freq, sizeof(outFreq_));
+        } else {
+            if (formant > 0.0f) spectralEnvelope(srcMag_, envelope_);
+            std::memset(outMag_, 0, sizeof(outMag_));
+            std::memset(outFreq_, 0, sizeof(outFreq_));
+
+            // Peak-locked shift: each region between magnitude minima moves as
+            // a block by the integer bin offset of its peak, so a partial keeps
+            // its main-lobe shape (and its bins stay phase-coherent)
+            int start = 0;
+            while (start < kBins) {
+                int end = start + 1;
+                while (end < kBins - 1 && !(srcMag_[end] <= srcMag_[end - 1] &&
+                                            srcMag_[end] < srcMag_[end + 1])) {
+                    ++end;
+                }
+                end = std::min(end, kBins - 1);
+                int peak = start;
+                for (int j = start + 1; j <= end; ++j) {
+                    if (srcMag_[j] > srcMag_[peak]) peak = j;
+                }
+                int shift = static_cast<int>(peak * pitchRatio + 0.5f) - peak;
+
+                for (int j = start; j <= end; ++j) {
+                    int k = j + shift;
+                    if (k < 0 || k >= kBins) continue;
+                    float m = srcMag_[j];
+                    if (formant > 0.0f) {
+                        // Flatten by the source envelope at the source bin,
+                        // re-apply it at the output bin (bounded so near-silent
+                        // bins can't explode or vanish)
+                        float ratio = envelope_[k] / envelope_[j];
+                        float correction = std::max(1.0f / kMaxFormantGain,
+                                                    std::min(kMaxFormantGain, ratio));
+                        m *= 1.0f + (correction - 1.0f) * formant;
+                    }
+                    outMag_[k] += m;
+                    outFreq_[k] = freq[j] * pitchRatio;
+                }
+                start = end + 1;
+            }
+        }
+
+        if (smear > 0.0f) {
+            rng.fill(RngStream::Spectral, jitter_, kPaddedBins);
+        }
+
+        // Advance phases, convert to cartesian and accumulate both channels
+        float* phase = phase_.data() + slot * kPaddedBins;
+        const f32x4 hop = splat(static_cast<float>(kHop));
+        const f32x4 smearAmount = splat(smear);
+        const f32x4 half = splat(0.5f);
+        const f32x4 quarter = splat(0.25f);
+        const f32x4 gL = splat(gainL), gR = splat(gainR);
+        for (int k = 0; k < kPaddedBins; k += kLanes) {
+            f32x4 p = load(phase + k) + load(outFreq_ + k) * hop;
+            if (smear > 0.0f) p = p + (load(jitter_ + k) - half) * smearAmount;
+            p = p - toFloat(roundToInt(p));   // Wrap to [-0.5, 0.5] turns
+            store(phase + k, p);
+
+            f32x4 m = load(outMag_ + k);
+            f32x4 re = m * fastmath::sinTurns(p + quarter);
+            f32x4 im = m * fastmath::sinTurns(p);
+            store(sumRe_[0] + k, load(sumRe_[0] + k) + re * gL);
+            store(sumIm_[0] + k, load(sumIm_[0] + k) + im * gL);
+            store(sumRe_[1] + k, load(sumRe_[1] + k) + re * gR);
+            store(sumIm_[1] + k, load(sumIm_[1] + k) + im * gR);
+        }
+    }
+
+    // Inverse FFT the summed spectrum and overlap-add it; makes kHop frames readable
+    void finishHop() {
+        // Hann analysis x Hann synthesis at 75% overlap sums to 1.5
+        constexpr float kOverlapGain = 1.0f / 1.5f;
+        float block[kFftSize];
+        for (int c = 0; c < 2; ++c) {
+            sumIm_[c][0] = 0.0f;
+            sumIm_[c][kBins - 1] = 0.0f;
+            fft_.inverse(sumRe_[c], sumIm_[c], block);
+
+            float* ola = overlap_[c];
+            for (int i = 0; i < kFftSize; ++i) ola[i] += block[i] * window_[i] * kOverlapGain;
+            std::memcpy(ready_[c], ola, kHop * sizeof(float));
+            std::memmove(ola, ola + kHop, (kFftSize - kHop) * sizeof(float));
+            std::memset(ola + kFftSize - kHop, 0, kHop * sizeof(float));
+
+            std::memset(sumRe_[c], 0, sizeof(sumRe_[c]));
+            std::memset(sumIm_[c], 0, sizeof(sumIm_[c]));
+        }
+        readPos_ = 0;
+    }
+
+    // Frames synthesized but not yet read
+    int available() const { return kHop - readPos_; }
+
+    // Copy up to available() frames out
+    void read(float* left, float* right, int numFrames) {
+        std::memcpy(left, ready_[0] + readPos_, numFrames * sizeof(float));
+        std::memcpy(right, ready_[1] + readPos_, numFrames * sizeof(float));
+        readPos_ += numFrames;
+    }
+
+private:
+    static constexpr int kEnvelopeRadius = 6;     // Bins each side (~280 Hz at 48 kHz)
+    static constexpr float kMaxFormantGain = 16.0f;
+
+    // Moving average of the magnitudes, floored so ratios stay finite
+    static void spectralEnvelope(const float* mag, float* env) {
+        float sum = 0.0f;
+        for (int k = 0; k <= kEnvelopeRadius; ++k) sum += mag[k];
+        for (int k = 0; k < kBins; ++k) {
+            int lo = k - kEnvelopeRadius;
+            int hi = k + kEnvelopeRadius;
+            int count = std::min(hi, kBins - 1) - std::max(lo, 0) + 1;
+            env[k] = sum / count + 1e-9f;
+            if (hi + 1 < kBins) sum += mag[hi + 1];
+            if (lo >= 0) sum -= mag[lo];
+        }
+    }
+
+    RealFft fft_;
+    float window_[kFftSize];
+
+    // Frame store in use: the own one, or one shared by the host
+    SpectralFrames ownFrames_;
+    const SpectralFrames* frames_ = &ownFrames_;
+
+    // Running bin phases (turns) per grain slot
+    std::vector<float> phase_;
+
+    // Per-grain hop scratch
+    alignas(16) float srcMag_[kPaddedBins];
+    alignas(16) float envelope_[kPaddedBins];
+    alignas(16) float outMag_[kPaddedBins];
+    alignas(16) float outFreq_[kPaddedBins];
+    alignas(16) float jitter_[kPaddedBins];
+
+    // Summed output spectrum and overlap-add state per channel
+    alignas(16) float sumRe_[2][kPaddedBins];
+    alignas(16) float sumIm_[2][kPaddedBins];
+    float overlap_[2][kFftSize];
+    float ready_[2][kHop];
+    int readPos_ = kHop;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "simd.h"
+#include <algorithm>
+#include <cmath>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+enum class FilterMode : int {
+    Lowpass = 0,
+    Bandpass = 1,
+    Highpass = 2,
+    Notch = 3
+};
+
+// Stereo zero-delay-feedback state-variable filter (TPT / trapezoidal SVF).
+//
+// Both channels run in lanes 0 and 1 of one 4-lane vector, so the per-sample
+// recursion costs the same as a mono filter. Coefficients are meant to be
+// updated once per control sub-block; the TPT structure stays stable and
+// click-free under fast cutoff changes.
+class StereoSvf {
+public:
+    void reset() {
+        ic1eq_ = simd::splat(0.0f);
+        ic2eq_ = simd::splat(0.0f);
+    }
+
+    void setMode(FilterMode mode) {
+        mode_ = mode;
+        updateMix();
+    }
+
+    FilterMode getMode() const { return mode_; }
+
+    // cutoffHz is clamped below Nyquist; q is linear (0.707 = Butterworth)
+    void setCoefficients(float cutoffHz, float q, float sampleRate) {
+        float fc = std::max(10.0f, std::min(cutoffHz, sampleRate * 0.49f));
+        float g = std::tan(static_cast<float>(M_PI) * fc / sampleRate);
+        k_ = 1.0f / std::max(q, 0.05f);
+        float a1 = 1.0f / (1.0f + g * (g + k_));
+        float a2 = g * a1;
+        float a3 = g * a2;
+        a1_ = simd::splat(a1);
+        a2_ = simd::splat(a2);
+        a3_ = simd::splat(a3);
+        updateMix();
+    }
+
+    // Filter a block in place
+    void process(float* left, float* right, int numFrames) {
+        using namespace simd;
+        const f32x4 two = splat(2.0f);
+        f32x4 ic1eq = ic1eq_;
+        f32x4 ic2eq = ic2eq_;
+
+        for (int i = 0; i < numFrames; ++i) {
+            f32x4 v0 = set(left[i], right[i], 0.0f, 0.0f);
+            f32x4 v3 = v0 - ic2eq;
+            f32x4 v1 = a1_ * ic1eq + a2_ * v3;
+            f32x4 v2 = ic2eq + a2_ * ic1eq + a3_ * v3;
+            ic1eq = two * v1 - ic1eq;
+            ic2eq = two * v2 - ic2eq;
+
+            // Mode output = m0 * input + m1 * band + m2 * low
+            f32x4 out = m0_ * v0 + m1_ * v1 + m2_ * v2;
+            left[i] = lane<0>(out);
+            right[i] = lane<1>(out);
+        }
+
+        ic1eq_ = ic1eq;
+        ic2eq_ = ic2eq;
+    }
+
+private:
+    void updateMix() {
+        float m0 = 0.0f, m1 = 0.0f, m2 = 0.0f;
+        switch (mode_) {
+            case FilterMode::Lowpass:  m2 = 1.0f; break;
+            case FilterMode::Bandpass: m1 = k_; break;   // 0 dB peak, like BiquadFilterNode
+            case FilterMode::Highpass: m0 = 1.0f; m1 = -k_; m2 = -1.0f; break;
+            case FilterMode::Notch:    m0 = 1.0f; m1 = -k_; break;
+        }
+        m0_ = simd::splat(m0);
+        m1_ = simd::splat(m1);
+        m2_ = simd::splat(m2);
+    }
+
+    FilterMode mode_ = FilterMode::Lowpass;
+    float k_ = 1.0f;
+    simd::f32x4 a1_ = simd::splat(1.0f);
+    simd::f32x4 a2_ = simd::splat(0.0f);
+    simd::f32x4 a3_ = simd::splat(0.0f);
+    simd::f32x4 m0_ = simd::splat(0.0f);
+    simd::f32x4 m1_ = simd::splat(0.0f);
+    simd::f32x4 m2_ = simd::splat(1.0f);
+    simd::f32x4 ic1eq_ = simd::splat(0.0f);
+    simd::f32x4 ic2eq_ = simd::splat(0.0f);
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+// Threads are available natively and in WASM builds with pthreads
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define NODEGRAIN_THREADS 1
+#include <chrono>
+#include <thread>
+#include <vector>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Fixed pool of helper threads that split one block's work into tasks.
+//
+// run() publishes a job as one atomic word packing an epoch, the task count
+// and the next task index. Helpers and the calling thread claim tasks with a
+// CAS on that word, so a helper that wakes late can never claim a task of a
+// newer job. The caller always works too and then spins until the last
+// claimed task has finished: run() makes progress even if every helper is
+// descheduled, and never locks or allocates, so it is safe on the audio
+// thread. Idle helpers spin, then yield, then nap in 100us sleeps, so the
+// first job after a pause may run mostly on the caller.
+//
+// start()/stop() create and join threads and are not real-time safe. Without
+// thread support (WASM built without pthreads) start() is a no-op and run()
+// executes every task on the caller.
+class WorkerPool {
+public:
+    using Task = void (*)(void* context, int task, int worker);
+    static constexpr int kMaxTasks = 0xffff;
+
+    WorkerPool() = default;
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool() { stop(); }
+
+    // Spawn `helpers` threads as workers 1..helpers (the caller of run() is worker 0)
+    void start(int helpers) {
+        stop();
+#if defined(NODEGRAIN_THREADS)
+        running_.store(true, std::memory_order_relaxed);
+        for (int i = 0; i < helpers; ++i) {
+            threads_.emplace_back(&WorkerPool::helperLoop, this, i + 1);
+        }
+#else
+        (void)helpers;
+#endif
+    }
+
+    void stop() {
+#if defined(NODEGRAIN_THREADS)
+        running_.store(false, std::memory_order_relaxed);
+        for (std::thread& t : threads_) t.join();
+        threads_.clear();
+#endif
+    }
+
+    // Helpers plus the calling thread
+    int getNumWorkers() const {
+#if defined(NODEGRAIN_THREADS)
+        return static_cast<int>(threads_.size()) + 1;
+#else
+        return 1;
+#endif
+    }
+
+    // Run task(context, t, worker) for every t in [0, numTasks) and return
+    // once all of them have finished. Tasks must be independent.
+    void run(Task task, void* context, int numTasks) {
+        numTasks = std::min(numTasks, kMaxTasks);
+        if (numTasks <= 0) return;
+        if (getNumWorkers() == 1) {
+            for (int t = 0; t < numTasks; ++t) task(context, t, 0);
+            return;
+        }
+
+        // The previous job is fully drained, so nobody reads these now
+        task_ = task;
+        context_ = context;
+        done_.store(0, std::memory_order_relaxed);
+        const uint32_t epoch = ++epoch_;
+        work_.store(pack(epoch, numTasks, 0), std::memory_order_release);
+
+        drain(epoch, 0);
+        int spins = 0;
+        while (done_.load(std::memory_order_acquire) < numTasks) {
+            backoff(spins, false);
+        }
+    }
+
+private:
+    static uint64_t pack(uint32_t epoch, int count, int index) {
+        return (static_cast<uint64_t>(epoch) << 32) |
+               (static_cast<uint64_t>(count) << 16) | static_cast<uint64_t>(index);
+    }
+    static uint32_t epochOf(uint64_t w) { return static_cast<uint32_t>(w >> 32); }
+    static int countOf(uint64_t w) { return static_cast<int>((w >> 16) & 0xffff); }
+    static int indexOf(uint64_t w) { return static_cast<int>(w & 0xffff); }
+
+    // Claim and run tasks of `epoch` until none are left
+    void drain(uint32_t epoch, int worker) {
+        uint64_t w = work_.load(std::memory_order_acquire);
+        while (epochOf(w) == epoch && indexOf(w) < countOf(w)) {
+            if (!work_.compare_exchange_weak(w, w + 1, std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+                continue;
+            }
+            task_(context_, indexOf(w), worker);
+            done_.fetch_add(1, std::memory_order_release);
+            w = work_.load(std::memory_order_acquire);
+        }
+    }
+
+    static void backoff(int& spins, bool mayNap) {
+        ++spins;
+        if (spins < 1024) {
+#if defined(__SSE2__)
+            _mm_pause();
+#endif
+        }
+#if defined(NODEGRAIN_THREADS)
+        else if (!mayNap || spins < 4096) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+#endif
+    }
+
+#if defined(NODEGRAIN_THREADS)
+    void helperLoop(int worker) {
+        uint32_t seen = 0;
+        int spins = 0;
+        while (running_.load(std::memory_order_relaxed)) {
+            uint64_t w = work_.load(std::memory_order_acquire);
+            if (epochOf(w) != seen && indexOf(w) < countOf(w)) {
+                seen = epochOf(w);
+                drain(seen, worker);
+                spins = 0;
+            } else {
+                backoff(spins, true);
+            }
+        }
+    }
+
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+#endif
+
+    Task task_ = nullptr;
+    void* context_ = nullptr;
+    uint32_t epoch_ = 0;              // Caller-side job counter
+    std::atomic<uint64_t> work_{0};   // epoch | count | next index
+    std::atomic<int> done_{0};        // Tasks of the current job finished
+};
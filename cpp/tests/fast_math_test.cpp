@@ -0,0 +1,128 @@
+// Sweeps every fastmath kernel, scalar and vector, against double-precision
+// libm and fails if any exceeds the error bound documented in fast_math.h.
+
+#include "fast_math.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr double kTwoPi = 2.0 * M_PI;
+
+int failures = 0;
+
+void check(const char* name, double maxError, double bound) {
+    bool ok = maxError < bound;
+    std::printf("%-24s max error %.3g (bound %.3g) %s\n", name, maxError, bound,
+                ok ? "ok" : "FAIL");
+    if (!ok) ++failures;
+}
+
+// Evenly spaced inputs over [lo, hi]
+std::vector<float> sweep(double lo, double hi, int count) {
+    std::vector<float> x(count);
+    for (int i = 0; i < count; ++i) {
+        x[i] = static_cast<float>(lo + (hi - lo) * i / (count - 1));
+    }
+    return x;
+}
+
+// Scalar kernel and 4-lane batch helper over the same inputs, each checked
+template <typename Scalar, typename Batch, typename Reference, typename Error>
+void checkKernel(const char* name, const std::vector<float>& x, Scalar scalar,
+                 Batch batch, Reference reference, Error error, double bound) {
+    std::vector<float> out(x.size());
+    batch(x.data(), out.data(), static_cast<int>(x.size()));
+    double scalarMax = 0.0, vectorMax = 0.0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        double ref = reference(x[i]);
+        scalarMax = std::max(scalarMax, error(scalar(x[i]), ref));
+        vectorMax = std::max(vectorMax, error(out[i], ref));
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s scalar", name);
+    check(label, scalarMax, bound);
+    std::snprintf(label, sizeof(label), "%s vector", name);
+    check(label, vectorMax, bound);
+}
+
+double relative(float value, double ref) { return std::fabs(value - ref) / std::fabs(ref); }
+double absolute(float value, double ref) { return std::fabs(value - ref); }
+
+// The vector kernels of sinTurns/cos have no batch helper; run them 4 at a time
+template <typename Kernel>
+void batchOf(Kernel kernel, const float* x, float* out, int count) {
+    int i = 0;
+    for (; i + simd::kLanes <= count; i += simd::kLanes) {
+        simd::store(out + i, kernel(simd::load(x + i)));
+    }
+    for (; i < count; ++i) {
+        float lanes[simd::kLanes];
+        simd::store(lanes, kernel(simd::splat(x[i])));
+        out[i] = lanes[0];
+    }
+}
+
+} // namespace
+
+int main() {
+    // exp2: relative error < 4e-7 on [-126, 126]
+    checkKernel("exp2", sweep(-126.0, 126.0, 4000001),
+        [](float v) { return fastmath::exp2(v); },
+        [](const float* x, float* out, int n) { fastmath::exp2(x, out, n); },
+        [](float v) { return std::exp2(static_cast<double>(v)); },
+        relative, 4e-7);
+
+    // sinTurns: absolute error < 2e-7 for |t| < 2^22. The fraction of t is
+    // all that matters, so sweep a few turns densely, then large phases
+    // where fewer fraction bits remain.
+    std::vector<float> turns = sweep(-4.0, 4.0, 4000001);
+    for (float t : sweep(-4194303.0, 4194303.0, 400001)) turns.push_back(t);
+    auto sinTurnsRef = [](float t) {
+        double r = static_cast<double>(t) - std::round(static_cast<double>(t));
+        return std::sin(kTwoPi * r);
+    };
+    checkKernel("sinTurns", turns,
+        [](float t) { return fastmath::sinTurns(t); },
+        [](const float* x, float* out, int n) {
+            batchOf([](simd::f32x4 t) { return fastmath::sinTurns(t); }, x, out, n);
+        },
+        sinTurnsRef, absolute, 2e-7);
+
+    // sin/cos: as sinTurns once x / 2pi is rounded to float, which is the
+    // input the kernel actually sees
+    std::vector<float> radians = sweep(-8.0 * M_PI, 8.0 * M_PI, 4000001);
+    checkKernel("sin", radians,
+        [](float x) { return fastmath::sin(x); },
+        [](const float* x, float* out, int n) { fastmath::sin(x, out, n); },
+        [&](float x) { return sinTurnsRef(x * fastmath::detail::kInvTwoPi); },
+        absolute, 2e-7);
+    checkKernel("cos", radians,
+        [](float x) { return fastmath::cos(x); },
+        [](const float* x, float* out, int n) {
+            batchOf([](simd::f32x4 v) { return fastmath::cos(v); }, x, out, n);
+        },
+        [&](float x) { return sinTurnsRef(x * fastmath::detail::kInvTwoPi + 0.25f); },
+        absolute, 2e-7);
+
+    // equalPowerPan: absolute error < 5e-6 per channel on [-1, 1]
+    std::vector<float> pans = sweep(-1.0, 1.0, 2000001);
+    std::vector<float> gainL(pans.size()), gainR(pans.size());
+    fastmath::equalPowerPan(pans.data(), gainL.data(), gainR.data(),
+                            static_cast<int>(pans.size()));
+    double scalarMax = 0.0, vectorMax = 0.0;
+    for (size_t i = 0; i < pans.size(); ++i) {
+        double theta = (static_cast<double>(pans[i]) + 1.0) * 0.25 * M_PI;
+        float l, r;
+        fastmath::equalPowerPan(pans[i], l, r);
+        scalarMax = std::max({scalarMax, absolute(l, std::cos(theta)),
+                              absolute(r, std::sin(theta))});
+        vectorMax = std::max({vectorMax, absolute(gainL[i], std::cos(theta)),
+                              absolute(gainR[i], std::sin(theta))});
+    }
+    check("equalPowerPan scalar", scalarMax, 5e-6);
+    check("equalPowerPan vector", vectorMax, 5e-6);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,534 @@
+/**
+ * GrainEngine control shared by the AudioWorklet processor and the
+ * render-ahead worker, so both engines interpret main-thread messages
+ * identically.
+ *
+ * Either side may run a LayerHost instead of a single engine (the `layers`
+ * option); createEngine() picks one, and applyMessage() / postMeters()
+ * accept both.
+ */
+
+import { TelemetryMirror } from './telemetry-mirror.js';
+
+// Partitions of the longest IR the prep worker accepts (20 s at 96kHz)
+const MAX_IR_PARTITIONS = Math.ceil(96000 * 20 / 128);
+
+// SpectralFrames::kMaxFrames: longer samples get a sparser analysis
+const MAX_SPECTRAL_FRAMES = 4096;
+
+/**
+ * Create the engine for a processor or worker: a GrainEngine, or a
+ * LayerHost with `layers` layers when that is at least 1.
+ */
+export function createEngine(wasmModule, sampleRate, layers) {
+    if (layers >= 1) {
+        const host = new wasmModule.LayerHost();
+        host.init(sampleRate);
+        host.setNumLayers(layers);
+        // Layer handles are fetched once; nothing changes the count later
+        host.layerEngines = Array.from({ length: host.getNumLayers() }, (_, i) => host.getLayer(i));
+        return host;
+    }
+    const engine = new wasmModule.GrainEngine();
+    engine.init(sampleRate);
+    return engine;
+}
+
+/**
+ * Apply one main-thread message to a GrainEngine or LayerHost. Returns
+ * false for message types neither understands.
+ */
+export function applyMessage(wasmModule, engine, msg, post) {
+    if (msg.type === 'telemetry') {
+        setTelemetry(engine, !!msg.enabled, post);
+        return true;
+    }
+    return engine.layerEngines
+        ? applyLayeredMessage(wasmModule, engine, msg, post)
+        : applyControlMessage(wasmModule, engine, msg, post);
+}
+
+/**
+ * Convert a GranularParams object from the main thread into an
+ * EngineParams value for the WASM engine.
+ */
+export function toEngineParams(wasmModule, p) {
+    const ep = new wasmModule.EngineParams();
+
+    ep.grainSize = p.grainSize;
+    ep.density = p.density;
+    ep.spread = p.spread;
+    ep.position = p.position;
+    ep.grainReversalChance = p.grainReversalChance || 0;
+    ep.pan = p.pan;
+    ep.panSpread = p.panSpread;
+    ep.pitch = p.pitch;
+    ep.detune = p.detune;
+    ep.fmFreq = p.fmFreq;
+    ep.fmAmount = p.fmAmount;
+    ep.attack = p.attack;
+    ep.release = p.release;
+    ep.envelopeCurve = p.envelopeCurve === 'exponential' ? 1 : 0;
+    ep.lfoRate = p.lfoRate;
+    ep.lfoAmount = p.lfoAmount;
+
+    // Convert lfoShape string to int
+    const shapeMap = { sine: 0, triangle: 1, square: 2, sawtooth: 3 };
+    ep.lfoShape = shapeMap[p.lfoShape] || 0;
+
+    // Convert lfoTargets array to bitmask
+    const targetMap = {
+        grainSize: 1 << 0,
+        density: 1 << 1,
+        spread: 1 << 2,
+        position: 1 << 3,
+        pitch: 1 << 4,
+        fmFreq: 1 << 5,
+        fmAmount: 1 << 6,
+        filterFreq: 1 << 7,
+        filterRes: 1 << 8,
+        attack: 1 << 9,
+        release: 1 << 10,
+        distAmount: 1 << 11,
+        delayMix: 1 << 12,
+        delayTime: 1 << 13,
+        delayFeedback: 1 << 14,
+        pan: 1 << 15,
+        panSpread: 1 << 16,
+    };
+    let mask = 0;
+    if (p.lfoTargets) {
+        for (const t of p.lfoTargets) {
+            if (targetMap[t] !== undefined) mask |= targetMap[t];
+        }
+    }
+    ep.lfoTargetMask = mask;
+
+    ep.volume = p.volume;
+    ep.filterFreq = p.filterFreq;
+    ep.filterRes = p.filterRes;
+
+    const filterTypeMap = { lowpass: 0, bandpass: 1, highpass: 2, notch: 3 };
+    ep.filterType = filterTypeMap[p.filterType] || 0;
+
+    // Per-grain filter (0 = off, otherwise filter type + 1)
+    ep.grainFilterMode = p.grainFilterMode && p.grainFilterMode !== 'off'
+        ? (filterTypeMap[p.grainFilterMode] || 0) + 1
+        : 0;
+    ep.grainFilterFreq = p.grainFilterFreq ?? 2000;
+    ep.grainFilterRes = p.grainFilterRes ?? 0;
+    ep.grainFilterSpread = p.grainFilterSpread ?? 0;
+    ep.grainMode = p.grainMode === 'spectral' ? 1 : 0;
+    ep.spectralFormant = p.spectralFormant ?? 1;
+    ep.spectralSmear = p.spectralSmear ?? 0;
+    const routingMap = { insert: 0, sends: 1, external: 2 };
+    ep.fxRouting = routingMap[p.fxRouting] || 0;
+    ep.sendDelay = p.sendDelay ?? 0;
+    ep.sendReverb = p.sendReverb ?? 0;
+    ep.sendSpread = p.sendSpread ?? 0;
+    ep.distAmount = p.distAmount;
+    ep.distOversample = p.distOversample ?? 4;
+    ep.delayTime = p.delayTime;
+    ep.delayFeedback = p.delayFeedback;
+    ep.delayMix = p.delayMix;
+    ep.delayDamping = p.delayDamping ?? 0;
+    ep.reverbMix = p.reverbMix;
+    ep.reverbDecay = p.reverbDecay;
+    ep.reverbDamping = p.reverbDamping ?? 0.3;
+    ep.reverbType = p.reverbType === 'convolution' ? 1 : 0;
+    const limiterMap = { off: 0, limit: 1, softclip: 2 };
+    ep.limiterMode = limiterMap[p.limiterMode] ?? 1;
+    ep.limiterCeiling = p.limiterCeiling ?? -1;
+    ep.limiterRelease = p.limiterRelease ?? 0.1;
+    ep.noteAttack = p.noteAttack ?? 0.01;
+    ep.noteDecay = p.noteDecay ?? 0.1;
+    ep.noteSustain = p.noteSustain ?? 1;
+    ep.noteRelease = p.noteRelease ?? 0.3;
+
+    return ep;
+}
+
+/**
+ * Apply one control message from the main thread to `engine`. Replies
+ * (load acknowledgements, errors) go through `post`. Returns false for
+ * message types that are not engine control.
+ */
+export function applyControlMessage(wasmModule, engine, msg, post) {
+    switch (msg.type) {
+        case 'params': {
+            engine.updateParams(toEngineParams(wasmModule, msg.params));
+            break;
+        }
+
+        case 'sampleBuffer': {
+            const data = msg.data; // Float32Array (transferred)
+
+            // Validate input: data must be a Float32Array with matching length
+            if (!(data instanceof Float32Array) || data.length === 0) {
+                post({
+                    type: 'error',
+                    message: 'Invalid sample buffer: expected non-empty Float32Array'
+                });
+                break;
+            }
+
+            // Use data.length as the authoritative length (ignore msg.length)
+            // to prevent length mismatch attacks
+            const length = data.length;
+            const channels = Math.max(1, Math.min(2, msg.channels || 1));
+
+            // Cap buffer size to prevent excessive memory allocation
+            // 10 minutes of mono audio at 96kHz = ~57.6M samples
+            const MAX_SAMPLES = 96000 * 600;
+            if (length > MAX_SAMPLES) {
+                post({
+                    type: 'error',
+                    message: 'Sample buffer too large (max ' + MAX_SAMPLES + ' samples)'
+                });
+                break;
+            }
+
+            // Allocate buffer in WASM heap and copy data
+            const ptr = engine.allocateSampleBuffer(length);
+
+            // Copy Float32Array into WASM heap
+            const heapF32 = wasmModule.HEAPF32;
+            const offset = ptr / 4; // Float32 offset
+            heapF32.set(data, offset);
+
+            engine.commitSampleBuffer(channels, length);
+            post({ type: 'sampleBufferLoaded' });
+            break;
+        }
+
+        case 'spectralFrames': {
+            // STFT frames of the loaded sample from the prep worker, sent
+            // once spectral grains are first wanted; only a copy here
+            if ((msg.slot | 0) !== 0) break;   // Bank slots are for layer hosts
+            const data = msg.data; // Float32Array (transferred)
+            const frames = msg.frames | 0;
+            const ptr = data instanceof Float32Array &&
+                frames > 0 && frames <= MAX_SPECTRAL_FRAMES
+                ? engine.allocateSpectralFrames(frames, msg.hop | 0)
+                : 0;
+            if (!ptr || data.length !== engine.getSpectralFramesSize()) {
+                post({ type: 'error', message: 'Invalid spectral frames' });
+                break;
+            }
+            wasmModule.HEAPF32.set(data, ptr / 4);
+            if (!engine.commitSpectralFrames()) {
+                post({ type: 'error', message: 'Spectral frames do not match the loaded sample' });
+            }
+            break;
+        }
+
+        case 'impulse': {
+            // IR spectra from the prep worker (prep-worker.js): partitioning
+            // and FFTs already ran there, so this is only a copy
+            const spectra = msg.spectra; // Float32Array (transferred)
+            const partitions = msg.partitions | 0;
+            const ptr = spectra instanceof Float32Array &&
+                partitions > 0 && partitions <= MAX_IR_PARTITIONS
+                ? engine.allocateImpulseSpectra(partitions, msg.channels | 0)
+                : 0;
+            if (!ptr || spectra.length !== engine.getImpulseSpectraSize()) {
+                post({ type: 'error', id: msg.id, message: 'Invalid impulse response spectra' });
+                break;
+            }
+            wasmModule.HEAPF32.set(spectra, ptr / 4);
+            post({ type: 'impulseLoaded', id: msg.id, cost: engine.commitImpulseSpectra() });
+            break;
+        }
+
+        case 'impulseClear':
+            engine.clearImpulseResponse();
+            break;
+
+        case 'start':
+            engine.start();
+            break;
+
+        case 'stop':
+            engine.stop();
+            break;
+
+        case 'morphSnapshot':
+            engine.setMorphSnapshot(msg.index, toEngineParams(wasmModule, msg.params));
+            break;
+
+        case 'morphPosition':
+            engine.setMorphPosition(msg.position);
+            break;
+
+        case 'morphClear':
+            engine.clearMorphSnapshots();
+            break;
+
+        case 'seed':
+            // Reseeding rewinds the RNG streams for reproducible renders
+            engine.setSeed(msg.seed >>> 0);
+            break;
+
+        case 'freeze':
+            engine.setFrozen(msg.frozen, msg.position || 0);
+            break;
+
+        case 'drift':
+            engine.setDrift(
+                msg.enabled,
+                msg.basePosition || 0.5,
+                msg.speed || 0.5,
+                msg.returnTendency || 0.3
+            );
+            break;
+
+        case 'polyphonic':
+            engine.setPolyphonic(!!msg.enabled);
+            break;
+
+        case 'noteOn':
+            engine.noteOn(msg.note | 0, msg.pitch ?? 0, msg.velocity ?? 1);
+            break;
+
+        case 'noteOff':
+            engine.noteOff(msg.note | 0);
+            break;
+
+        case 'allNotesOff':
+            engine.allNotesOff();
+            break;
+
+        case 'cpuBudget':
+            engine.setCpuBudget(Math.max(0, Math.min(1, msg.budget || 0)));
+            break;
+
+        case 'captureState': {
+            // Copy out of the heap: the snapshot buffer is reused
+            const ptr = engine.captureState();
+            const data = wasmModule.HEAPU8.slice(ptr, ptr + engine.getStateSize());
+            post({ type: 'state', id: msg.id, layer: msg.layer, data: data.buffer });
+            break;
+        }
+
+        case 'restoreState': {
+            const data = new Uint8Array(msg.data); // ArrayBuffer from captureState
+            if (data.length !== engine.getStateSize()) {
+                post({ type: 'error', id: msg.id, message: 'Engine state does not match this build' });
+                break;
+            }
+            wasmModule.HEAPU8.set(data, engine.getStateBuffer());
+            if (!engine.restoreStateBuffer()) {
+                post({ type: 'error', id: msg.id, message: 'Engine state does not match this build or sample rate' });
+                break;
+            }
+            post({ type: 'stateRestored', id: msg.id, layer: msg.layer });
+            break;
+        }
+
+        default:
+            return false;
+    }
+    return true;
+}
+
+/**
+ * Apply one message to a LayerHost. Bank, layer routing, gain and budget
+ * messages go to the host; everything else is engine control for layer
+ * `msg.layer`, or for every layer when the message names none.
+ */
+export function applyLayeredMessage(wasmModule, host, msg, post) {
+    switch (msg.type) {
+        case 'bankSample':
+            if (loadBankSample(wasmModule, host, msg.slot | 0, msg, post)) {
+                post({ type: 'bankSampleLoaded', slot: msg.slot | 0 });
+            }
+            break;
+
+        case 'bankClear':
+            host.clearSample(msg.slot | 0);
+            break;
+
+        case 'sampleBuffer':
+            // Single-engine loads become bank slot 0, played by every layer
+            if (loadBankSample(wasmModule, host, 0, msg, post)) {
+                for (let i = 0; i < host.layerEngines.length; i++) host.setLayerSample(i, 0);
+                post({ type: 'sampleBufferLoaded' });
+            }
+            break;
+
+        case 'spectralFrames': {
+            // STFT frames of a bank slot (single-engine loads are slot 0)
+            // from the prep worker, shared by every layer on the slot
+            const slot = msg.slot | 0;
+            const data = msg.data; // Float32Array (transferred)
+            const frames = msg.frames | 0;
+            const ptr = data instanceof Float32Array &&
+                frames > 0 && frames <= MAX_SPECTRAL_FRAMES
+                ? host.allocateSampleFrames(slot, frames, msg.hop | 0)
+                : 0;
+            if (!ptr || data.length !== host.getSampleFramesSize(slot)) {
+                post({ type: 'error', message: 'Invalid spectral frames' });
+                break;
+            }
+            wasmModule.HEAPF32.set(data, ptr / 4);
+            if (!host.commitSampleFrames(slot)) {
+                post({ type: 'error', message: 'Spectral frames do not match the bank sample' });
+            }
+            break;
+        }
+
+        case 'layerSample':
+            host.setLayerSample(msg.layer | 0, msg.slot ?? -1);
+            break;
+
+        case 'layerGain':
+            host.setLayerGain(msg.layer | 0, msg.gain);
+            break;
+
+        case 'grainBudget':
+            host.setGrainBudget(msg.grains | 0);
+            break;
+
+        case 'start':
+            host.start();
+            break;
+
+        case 'stop':
+            host.stop();
+            break;
+
+        case 'params':
+            // Params for every layer also set the host's limiter on the mix
+            if (msg.layer === undefined) {
+                const ep = toEngineParams(wasmModule, msg.params);
+                host.setLimiter(ep.limiterMode, ep.limiterCeiling, ep.limiterRelease);
+            }
+            return applyToLayers(wasmModule, host, msg, post);
+
+        case 'cpuBudget': {
+            // Each layer times only itself, so it gets an even share
+            const engines = host.layerEngines;
+            const share = Math.max(0, Math.min(1, msg.budget || 0)) / Math.max(1, engines.length);
+            for (const engine of engines) engine.setCpuBudget(share);
+            break;
+        }
+
+        case 'captureState':
+        case 'restoreState': {
+            // One layer per snapshot (layer 0 unless named)
+            const engine = host.layerEngines[msg.layer | 0];
+            if (!engine) {
+                post({ type: 'error', id: msg.id, message: 'No layer ' + (msg.layer | 0) });
+                break;
+            }
+            return applyControlMessage(wasmModule, engine, msg, post);
+        }
+
+        default:
+            return applyToLayers(wasmModule, host, msg, post);
+    }
+    return true;
+}
+
+// Engine control for layer `msg.layer`, or for every layer when it names none
+function applyToLayers(wasmModule, host, msg, post) {
+    const engines = msg.layer === undefined
+        ? host.layerEngines
+        : host.layerEngines.slice(msg.layer | 0, (msg.layer | 0) + 1);
+    let handled = false;
+    for (const engine of engines) {
+        handled = applyControlMessage(wasmModule, engine, msg, post) || handled;
+    }
+    return handled;
+}
+
+// Copy `msg.data` into bank slot `slot` and analyse it; false (after
+// posting an error) when the data or slot is invalid
+function loadBankSample(wasmModule, host, slot, msg, post) {
+    const data = msg.data; // Float32Array (transferred)
+    if (!(data instanceof Float32Array) || data.length === 0) {
+        post({
+            type: 'error',
+            message: 'Invalid bank sample: expected non-empty Float32Array'
+        });
+        return false;
+    }
+    const MAX_SAMPLES = 96000 * 600;
+    if (data.length > MAX_SAMPLES) {
+        post({
+            type: 'error',
+            message: 'Sample buffer too large (max ' + MAX_SAMPLES + ' samples)'
+        });
+        return false;
+    }
+
+    const ptr = host.allocateSample(slot, data.length);
+    if (!ptr) {
+        post({ type: 'error', message: 'Invalid bank slot ' + slot });
+        return false;
+    }
+    wasmModule.HEAPF32.set(data, ptr / 4);
+    host.commitSample(slot, Math.max(1, Math.min(2, msg.channels || 1)), data.length);
+    return true;
+}
+
+// Grain events spawned since the last call, tagged with `layer` if given
+function collectGrainEvents(engine, layer, events) {
+    const count = engine.getGrainEventCount();
+    for (let i = 0; i < count; i++) {
+        const event = {
+            normPos: engine.getGrainEventNormPos(i),
+            duration: engine.getGrainEventDuration(i),
+            pan: engine.getGrainEventPan(i),
+        };
+        if (layer !== undefined) event.layer = layer;
+        events.push(event);
+    }
+    engine.clearGrainEvents();
+}
+
+/**
+ * Turn engine telemetry on or off. On, every engine (or layer) fills its
+ * telemetry block and the host mirrors them into a SharedArrayBuffer,
+ * posted once to the main thread as { type: 'telemetry', buffer, ... }.
+ */
+function setTelemetry(engine, enabled, post) {
+    const engines = engine.layerEngines || [engine];
+    if (enabled && typeof SharedArrayBuffer === 'undefined') {
+        post({ type: 'error', message: 'Telemetry needs SharedArrayBuffer (a cross-origin isolated page)' });
+        return;
+    }
+    for (const e of engines) e.setTelemetryEnabled(enabled);
+    engine.telemetry = null;
+    if (!enabled) return;
+
+    const recordBytes = engines[0].getTelemetrySize();
+    engine.telemetry = new TelemetryMirror(engines.map(e => e.getTelemetryBuffer()), recordBytes);
+    post({
+        type: 'telemetry',
+        buffer: engine.telemetry.buffer,
+        records: engines.length,
+        recordBytes,
+    });
+}
+
+/** Mirror the telemetry of the block just rendered (no-op while off). */
+export function publishTelemetry(wasmModule, engine) {
+    if (engine.telemetry) engine.telemetry.write(wasmModule.HEAPU8);
+}
+
+/**
+ * Post the grain events spawned since the last call (for visualization)
+ * and the engine meters, then re-arm both. For a LayerHost the events of
+ * every layer are posted together and the meters are the host's.
+ */
+export function postMeters(engine, post) {
+    const events = [];
+    if (engine.layerEngines) {
+        engine.layerEngines.forEach((layer, i) => collectGrainEvents(layer, i, events));
+    } else {
+        collectGrainEvents(engine, undefined, events);
+    }
+    if (events.length > 0) post({ type: 'grainEvents', events });
+    post({ type: 'stats', stats: engine.collectStats() });
+}
@@ -4,8 +4,18 @@
  * Loads the Emscripten-compiled WASM module and runs the grain engine
  * in the audio rendering thread. Communicates with the main thread
  * via MessagePort for parameters, sample data, and grain events.
+ *
+ * With render-ahead enabled, a worker (grain-render-worker.js) renders
+ * into a shared ring and this processor only copies blocks out, falling
+ * back to its own engine when the ring underruns.
+ *
+ * With processorOptions.layers set, the engine is a LayerHost running that
+ * many layers over a shared sample bank.
  */
 
+import { applyMessage, createEngine, postMeters, publishTelemetry } from './engine-control.js';
+import { RenderAheadRing, RING_BLOCK, RING_CHANNELS } from './render-ahead-ring.js';
+
 class GrainProcessor extends AudioWorkletProcessor {
     constructor(options) {
         super();
@@ -18,18 +28,28 @@ class GrainProcessor extends AudioWorkletProcessor {
         // Pre-allocated pointers for output buffers (set after WASM init)
         this.outputPtrL = 0;
         this.outputPtrR = 0;
+        this.auxPtrs = [];   // [{ l, r }] per aux bus (outputs 1 and 2)
         this.heapF32 = null;
 
+        // Render-ahead playback (see _playRing)
+        this.ring = null;
+        this.ringPrimed = false;       // A ring block has been played
+        this.inlineFallback = true;    // Rendering inline while the ring refills
+        this.crossfadePending = true;  // Next ring block crossfades from inline
+        this.underruns = 0;
+        this.lastSample = new Float32Array(RING_CHANNELS);
+
         // Handle messages from main thread
         this.port.onmessage = (e) => this._handleMessage(e.data);
 
         // Initialize WASM from the compiled module passed via processorOptions
-        if (options.processorOptions && options.processorOptions.wasmModule) {
-            this._initWasm(options.processorOptions.wasmModule);
+        const opts = options.processorOptions;
+        if (opts && opts.wasmModule) {
+            this._initWasm(opts.wasmModule, opts.layers || 0);
         }
     }
 
-    async _initWasm(compiledModule) {
+    async _initWasm(compiledModule, layers) {
         try {
             // Instantiate the WASM module using Emscripten's factory function
             // The compiled module is transferred from the main thread
@@ -46,13 +66,17 @@ class GrainProcessor extends AudioWorkletProcessor {
 
             this.wasmModule = instance;
 
-            // Create the grain engine
-            this.engine = new instance.GrainEngine();
-            this.engine.init(sampleRate); // sampleRate is a global in AudioWorkletGlobalScope
+            // Create the grain engine (or layer host); sampleRate is a
+            // global in AudioWorkletGlobalScope
+            this.engine = createEngine(instance, sampleRate, layers);
 
             // Get output buffer pointers (static 128-sample buffers in WASM heap)
             this.outputPtrL = this.engine.getOutputBufferL();
             this.outputPtrR = this.engine.getOutputBufferR();
+            this.auxPtrs = [0, 1].map(bus => ({
+                l: this.engine.getAuxBufferL(bus),
+                r: this.engine.getAuxBufferR(bus),
+            }));
 
             this.isReady = true;
             this.port.postMessage({ type: 'ready' });
@@ -65,166 +89,59 @@ class GrainProcessor extends AudioWorkletProcessor {
     }
 
     _handleMessage(msg) {
-        if (!this.engine && msg.type !== 'initWasm') return;
-
-        switch (msg.type) {
-            case 'params': {
-                if (!this.engine) break;
-                // Convert JS params to EngineParams struct
-                const p = msg.params;
-                const ep = new this.wasmModule.EngineParams();
-
-                ep.grainSize = p.grainSize;
-                ep.density = p.density;
-                ep.spread = p.spread;
-                ep.position = p.position;
-                ep.grainReversalChance = p.grainReversalChance || 0;
-                ep.pan = p.pan;
-                ep.panSpread = p.panSpread;
-                ep.pitch = p.pitch;
-                ep.detune = p.detune;
-                ep.fmFreq = p.fmFreq;
-                ep.fmAmount = p.fmAmount;
-                ep.attack = p.attack;
-                ep.release = p.release;
-                ep.envelopeCurve = p.envelopeCurve === 'exponential' ? 1 : 0;
-                ep.lfoRate = p.lfoRate;
-                ep.lfoAmount = p.lfoAmount;
-
-                // Convert lfoShape string to int
-                const shapeMap = { sine: 0, triangle: 1, square: 2, sawtooth: 3 };
-                ep.lfoShape = shapeMap[p.lfoShape] || 0;
+        if (msg.type === 'renderAhead') {
+            // Switch to (or, with ring null, away from) playing a render-ahead ring
+            this.ring = msg.ring ? new RenderAheadRing(msg.ring) : null;
+            this.ringPrimed = false;
+            this.inlineFallback = true;
+            this.crossfadePending = true;
+            this.underruns = 0;
+            return;
+        }
+        if (!this.engine) return;
+        applyMessage(this.wasmModule, this.engine, msg, (m) => this.port.postMessage(m));
+    }
 
-                // Convert lfoTargets array to bitmask
-                const targetMap = {
-                    grainSize: 1 << 0,
-                    density: 1 << 1,
-                    spread: 1 << 2,
-                    position: 1 << 3,
-                    pitch: 1 << 4,
-                    fmFreq: 1 << 5,
-                    fmAmount: 1 << 6,
-                    filterFreq: 1 << 7,
-                    filterRes: 1 << 8,
-                    attack: 1 << 9,
-                    release: 1 << 10,
-                    distAmount: 1 << 11,
-                    delayMix: 1 << 12,
-                    delayTime: 1 << 13,
-                    delayFeedback: 1 << 14,
-                    pan: 1 << 15,
-                    panSpread: 1 << 16,
-                };
-                let mask = 0;
-                if (p.lfoTargets) {
-                    for (const t of p.lfoTargets) {
-                        if (targetMap[t] !== undefined) mask |= targetMap[t];
-                    }
-                }
-                ep.lfoTargetMask = mask;
+    process(inputs, outputs, parameters) {
+        if (!this.isReady || !this.engine) return true;
 
-                ep.volume = p.volume;
-                ep.filterFreq = p.filterFreq;
-                ep.filterRes = p.filterRes;
-                ep.distAmount = p.distAmount;
-                ep.delayTime = p.delayTime;
-                ep.delayFeedback = p.delayFeedback;
-                ep.delayMix = p.delayMix;
-                ep.reverbMix = p.reverbMix;
-                ep.reverbDecay = p.reverbDecay;
+        const output = outputs[0];
+        if (!output || output.length === 0) return true;
+        const numFrames = output[0].length; // Should be 128
 
-                this.engine.updateParams(ep);
+        if (this.ring && numFrames === RING_BLOCK) {
+            this._playRing(outputs);
+        } else {
+            this._renderInline(outputs, numFrames);
+        }
 
-                // Also send FX params back so the TS bridge can update Web Audio nodes
+        // Periodically send grain events back for visualization (~30ms
+        // intervals); while a ring plays, the render worker sends its own
+        this.frameCount++;
+        if (this.frameCount % 10 === 0) {
+            if (this.ring) {
+                this.engine.clearGrainEvents();
                 this.port.postMessage({
-                    type: 'fxParams',
-                    filterFreq: p.filterFreq,
-                    filterRes: p.filterRes,
-                    distAmount: p.distAmount,
-                    delayTime: p.delayTime,
-                    delayFeedback: p.delayFeedback,
-                    delayMix: p.delayMix,
-                    reverbMix: p.reverbMix,
-                    reverbDecay: p.reverbDecay,
-                    volume: p.volume,
+                    type: 'renderAheadStats',
+                    stats: {
+                        bufferedFrames: this.ring.buffered() * RING_BLOCK,
+                        underruns: this.underruns,
+                        inline: this.inlineFallback,
+                    }
                 });
-                break;
-            }
-
-            case 'sampleBuffer': {
-                if (!this.engine) break;
-                const data = msg.data; // Float32Array (transferred)
-
-                // Validate input: data must be a Float32Array with matching length
-                if (!(data instanceof Float32Array) || data.length === 0) {
-                    this.port.postMessage({
-                        type: 'error',
-                        message: 'Invalid sample buffer: expected non-empty Float32Array'
-                    });
-                    break;
-                }
-
-                // Use data.length as the authoritative length (ignore msg.length)
-                // to prevent length mismatch attacks
-                const length = data.length;
-                const channels = Math.max(1, Math.min(2, msg.channels || 1));
-
-                // Cap buffer size to prevent excessive memory allocation
-                // 10 minutes of mono audio at 96kHz = ~57.6M samples
-                const MAX_SAMPLES = 96000 * 600;
-                if (length > MAX_SAMPLES) {
-                    this.port.postMessage({
-                        type: 'error',
-                        message: 'Sample buffer too large (max ' + MAX_SAMPLES + ' samples)'
-                    });
-                    break;
-                }
-
-                // Allocate buffer in WASM heap and copy data
-                const ptr = this.engine.allocateSampleBuffer(length);
-
-                // Copy Float32Array into WASM heap
-                const heapF32 = this.wasmModule.HEAPF32;
-                const offset = ptr / 4; // Float32 offset
-                heapF32.set(data, offset);
-
-                this.engine.commitSampleBuffer(channels, length);
-                this.port.postMessage({ type: 'sampleBufferLoaded' });
-                break;
+            } else {
+                postMeters(this.engine, (m) => this.port.postMessage(m));
             }
-
-            case 'start':
-                this.engine.start();
-                break;
-
-            case 'stop':
-                this.engine.stop();
-                break;
-
-            case 'freeze':
-                this.engine.setFrozen(msg.frozen, msg.position || 0);
-                break;
-
-            case 'drift':
-                this.engine.setDrift(
-                    msg.enabled,
-                    msg.basePosition || 0.5,
-                    msg.speed || 0.5,
-                    msg.returnTendency || 0.3
-                );
-                break;
         }
-    }
 
-    process(inputs, outputs, parameters) {
-        if (!this.isReady || !this.engine) return true;
+        return true; // Keep processor alive
+    }
 
+    // Run this processor's engine for one block and copy all three outputs
+    _renderInline(outputs, numFrames) {
         const output = outputs[0];
-        if (!output || output.length === 0) return true;
-
         const left = output[0];
         const right = output[1] || output[0];
-        const numFrames = left.length; // Should be 128
 
         // Get WASM heap for direct memory access
         const heapF32 = this.wasmModule.HEAPF32;
@@ -233,30 +150,77 @@ class GrainProcessor extends AudioWorkletProcessor {
 
         // Call into WASM engine
         this.engine.process(this.outputPtrL, this.outputPtrR, numFrames);
+        publishTelemetry(this.wasmModule, this.engine);
 
         // Copy from WASM heap to output buffers
         left.set(heapF32.subarray(ptrL, ptrL + numFrames));
         right.set(heapF32.subarray(ptrR, ptrR + numFrames));
 
-        // Periodically send grain events back for visualization (~30ms intervals)
-        this.frameCount++;
-        if (this.frameCount % 10 === 0) {
-            const count = this.engine.getGrainEventCount();
-            if (count > 0) {
-                const events = [];
-                for (let i = 0; i < count; i++) {
-                    events.push({
-                        normPos: this.engine.getGrainEventNormPos(i),
-                        duration: this.engine.getGrainEventDuration(i),
-                        pan: this.engine.getGrainEventPan(i),
-                    });
+        // Aux buses on outputs 1 and 2 (silent unless fxRouting is set)
+        for (let bus = 0; bus < this.auxPtrs.length; bus++) {
+            const out = outputs[bus + 1];
+            if (!out || out.length === 0) continue;
+            const l = this.auxPtrs[bus].l / 4;
+            const r = this.auxPtrs[bus].r / 4;
+            out[0].set(heapF32.subarray(l, l + numFrames));
+            (out[1] || out[0]).set(heapF32.subarray(r, r + numFrames));
+        }
+    }
+
+    // Copy the next render-ahead block out. When the ring runs dry, render
+    // inline with this processor's engine until the worker has refilled half
+    // its lookahead; the switch away from the ring fades from the last ring
+    // sample and the switch back crossfades over one block.
+    _playRing(outputs) {
+        const ring = this.ring;
+        const resume = this.inlineFallback ? Math.max(1, ring.lookahead >> 1) : 1;
+
+        if (ring.buffered() < resume) {
+            const entering = !this.inlineFallback;
+            if (entering && this.ringPrimed) this.underruns++;
+            this.inlineFallback = true;
+            this._renderInline(outputs, RING_BLOCK);
+            this._blendChannels(outputs, null, entering);
+            return;
+        }
+
+        const slot = ring.slot(ring.readIndex());
+        if (this.inlineFallback) {
+            this._renderInline(outputs, RING_BLOCK);
+            this.inlineFallback = false;
+            this.ringPrimed = true;
+        }
+        this._blendChannels(outputs, slot, false);
+        ring.release();
+    }
+
+    // Finish the six output channels (main, delay bus, reverb bus) of a ring
+    // block: copy `slot` in, or crossfade into it from the inline render
+    // already in the outputs; with no slot, optionally fade the inline render
+    // in from the last sample played. Remembers the last sample of each.
+    _blendChannels(outputs, slot, fadeFromLast) {
+        const crossfade = slot !== null && this.crossfadePending;
+        for (let ch = 0; ch < RING_CHANNELS; ch++) {
+            const out = outputs[ch >> 1];
+            if (!out || out.length === 0) continue;
+            const dst = out[Math.min(ch & 1, out.length - 1)];
+
+            if (slot !== null && !crossfade) {
+                dst.set(slot[ch]);
+            } else if (slot !== null) {
+                const src = slot[ch];
+                for (let i = 0; i < RING_BLOCK; i++) {
+                    dst[i] += (src[i] - dst[i]) * ((i + 1) / RING_BLOCK);
+                }
+            } else if (fadeFromLast) {
+                const last = this.lastSample[ch];
+                for (let i = 0; i < RING_BLOCK; i++) {
+                    dst[i] = last + (dst[i] - last) * ((i + 1) / RING_BLOCK);
                 }
-                this.port.postMessage({ type: 'grainEvents', events });
-                this.engine.clearGrainEvents();
             }
+            this.lastSample[ch] = dst[RING_BLOCK - 1];
         }
-
-        return true; // Keep processor alive
+        this.crossfadePending = slot === null;
     }
 }
 
@@ -0,0 +1,107 @@
+/**
+ * Render-ahead worker for the NodeGrain WASM engine.
+ *
+ * Runs its own GrainEngine ahead of the audio clock and publishes finished
+ * 128-frame blocks into a RenderAheadRing; the AudioWorklet processor only
+ * copies them out. With the pthreads build (grain_engine_mt) the engine
+ * additionally splits grain rendering across `renderThreads` helper Web
+ * Workers, so heavy patches use several cores. With `layers` set it runs a
+ * LayerHost instead, whose helper threads render one layer each.
+ *
+ * Control messages take effect on the next block rendered here, which is
+ * up to `lookahead` blocks before it is heard.
+ */
+
+import { applyMessage, createEngine, postMeters, publishTelemetry } from './engine-control.js';
+import { RenderAheadRing, RING_BLOCK, RING_CHANNELS } from './render-ahead-ring.js';
+
+let wasm = null;
+let engine = null;
+let ring = null;
+let outputPtrs = [];   // Heap byte offsets of the six engine outputs, ring channel order
+let pending = [];      // Control messages that arrived before the engine was ready
+let running = false;
+let pollMs = 3;
+let blockCount = 0;
+
+const post = (msg) => self.postMessage(msg);
+
+async function init(msg) {
+    try {
+        const script = new URL(msg.script, self.location.href).href;
+        const moduleFactory = await import(script);
+        wasm = await moduleFactory.default({
+            locateFile: (path) => new URL(path, script).href,
+            // Threads build: pthread workers load the same script, and the
+            // pool is sized from this value when the module starts
+            mainScriptUrlOrBlob: script,
+            renderThreads: msg.renderThreads,
+        });
+
+        engine = createEngine(wasm, msg.sampleRate, msg.layers || 0);
+        engine.setRenderThreads(msg.renderThreads);
+        outputPtrs = [
+            engine.getOutputBufferL(), engine.getOutputBufferR(),
+            engine.getAuxBufferL(0), engine.getAuxBufferR(0),
+            engine.getAuxBufferL(1), engine.getAuxBufferR(1),
+        ];
+
+        ring = RenderAheadRing.create(msg.lookahead);
+        pollMs = RING_BLOCK / msg.sampleRate * 1000;
+        for (const m of pending) applyMessage(wasm, engine, m, post);
+        pending = [];
+
+        running = true;
+        post({ type: 'ready', ring: ring.descriptor, renderThreads: engine.getRenderThreads() });
+        fill();
+    } catch (err) {
+        post({
+            type: 'error',
+            fatal: true,
+            message: 'Render worker init failed: ' + (err.message || String(err))
+        });
+    }
+}
+
+// Render until the ring holds `lookahead` blocks, then wait for the audio
+// thread to consume one
+function fill() {
+    if (!running) return;
+
+    let n;
+    while ((n = ring.writeIndex()) !== null) {
+        engine.process(outputPtrs[0], outputPtrs[1], RING_BLOCK);
+        publishTelemetry(wasm, engine);
+
+        // Re-read the heap view every block: memory growth replaces it
+        const heapF32 = wasm.HEAPF32;
+        const slot = ring.slot(n);
+        for (let c = 0; c < RING_CHANNELS; c++) {
+            const offset = outputPtrs[c] / 4;
+            slot[c].set(heapF32.subarray(offset, offset + RING_BLOCK));
+        }
+        ring.publish();
+
+        if (++blockCount % 10 === 0) postMeters(engine, post);
+    }
+    ring.waitForSpace(pollMs).then(fill);
+}
+
+self.onmessage = (e) => {
+    const msg = e.data;
+    switch (msg.type) {
+        case 'init':
+            init(msg);
+            break;
+
+        case 'shutdown':
+            running = false;
+            if (engine) engine.setRenderThreads(0);
+            self.close();
+            break;
+
+        default:
+            if (!engine) pending.push(msg);
+            else applyMessage(wasm, engine, msg, post);
+    }
+};
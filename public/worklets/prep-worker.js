@@ -0,0 +1,110 @@
+/**
+ * Preparation worker for the NodeGrain WASM engine.
+ *
+ * Work the engines must not do on the audio thread runs here, on a second
+ * instance of the same module (EnginePrep): partitioning and transforming
+ * convolution IRs, and the STFT analysis spectral grains read. Results are transferred back to the main thread, which
+ * forwards them to the worklet and the render worker; those only copy them
+ * into their heaps.
+ *
+ * Every request carries an `id`, and so does its reply: the result, or
+ * { type: 'error', id, message }.
+ */
+
+// 20 seconds at 96kHz is far beyond any useful reverb tail
+const MAX_IR_SAMPLES = 96000 * 20;
+
+// Same cap as the engines' sample buffers (10 minutes at 96kHz)
+const MAX_SAMPLES = 96000 * 600;
+
+let wasm = null;
+let prep = null;
+let ready = null;   // Resolves once the module is instantiated
+
+const post = (msg, transfer = []) => self.postMessage(msg, transfer);
+
+async function init(compiledModule) {
+    const moduleFactory = await import('/wasm/grain_engine.js');
+    wasm = await moduleFactory.default({
+        instantiateWasm: (imports, successCallback) => {
+            WebAssembly.instantiate(compiledModule, imports).then((inst) => {
+                successCallback(inst);
+            });
+            return {};
+        }
+    });
+    prep = new wasm.EnginePrep();
+}
+
+// Copy `count` floats out of the heap at byte offset `ptr` (the heap view
+// is re-read: the prepare call may have grown memory)
+function copyOut(ptr, count) {
+    return wasm.HEAPF32.slice(ptr / 4, ptr / 4 + count);
+}
+
+function prepareImpulse(msg) {
+    const channels = msg.channels; // Float32Array[] (transferred), one per channel
+    if (!Array.isArray(channels) || channels.length === 0 ||
+        !channels.every(c => c instanceof Float32Array && c.length === channels[0].length) ||
+        channels[0].length === 0) {
+        throw new Error('Invalid impulse response: expected equal-length Float32Arrays');
+    }
+    const length = channels[0].length;
+    if (length > MAX_IR_SAMPLES) {
+        throw new Error('Impulse response too long (max ' + MAX_IR_SAMPLES + ' samples)');
+    }
+
+    // Planar copy into the heap, then partition + FFT
+    const numChannels = Math.min(2, channels.length);
+    const ptr = prep.allocateInput(numChannels * length);
+    for (let c = 0; c < numChannels; c++) {
+        wasm.HEAPF32.set(channels[c], ptr / 4 + c * length);
+    }
+    const partitions = prep.prepareImpulse(numChannels, length);
+    const spectra = copyOut(prep.getImpulseSpectra(), prep.getImpulseSpectraSize());
+    prep.release();
+    post({ type: 'impulseSpectra', id: msg.id, partitions, channels: numChannels, spectra },
+        [spectra.buffer]);
+}
+
+function prepareSpectralFrames(msg) {
+    const data = msg.data; // Float32Array (transferred), mono
+    if (!(data instanceof Float32Array) || data.length === 0) {
+        throw new Error('Invalid sample: expected a non-empty Float32Array');
+    }
+    if (data.length > MAX_SAMPLES) {
+        throw new Error('Sample too long (max ' + MAX_SAMPLES + ' samples)');
+    }
+
+    const ptr = prep.allocateInput(data.length);
+    wasm.HEAPF32.set(data, ptr / 4);
+    const frames = prep.prepareSpectralFrames(data.length);
+    const hop = prep.getAnalysisHop();
+    const out = copyOut(prep.getSpectralFrames(), prep.getSpectralFramesSize());
+    prep.release();
+    post({ type: 'spectralFrames', id: msg.id, frames, hop, data: out }, [out.buffer]);
+}
+
+self.onmessage = async (e) => {
+    const msg = e.data;
+    if (msg.type === 'init') {
+        ready = init(msg.wasmModule);
+        return;
+    }
+
+    try {
+        await ready;
+        switch (msg.type) {
+            case 'impulse':
+                prepareImpulse(msg);
+                break;
+            case 'spectralFrames':
+                prepareSpectralFrames(msg);
+                break;
+            default:
+                throw new Error('Unknown prep request: ' + msg.type);
+        }
+    } catch (err) {
+        post({ type: 'error', id: msg.id, message: err.message || String(err) });
+    }
+};
@@ -0,0 +1,104 @@
+/**
+ * Lock-free single-producer / single-consumer ring of rendered blocks in
+ * SharedArrayBuffers, shared by the render-ahead worker (producer) and the
+ * AudioWorklet processor (consumer).
+ *
+ * Each slot holds one 128-frame block of all six engine outputs (main L/R,
+ * delay bus L/R, reverb bus L/R), planar. The write and read counters only
+ * ever increase; the producer publishes a slot by bumping the write counter
+ * after filling it, the consumer frees it by bumping the read counter after
+ * copying it out, so neither side ever waits on the other.
+ */
+
+export const RING_BLOCK = 128;
+export const RING_CHANNELS = 6;
+
+const WRITE = 0;      // Blocks published by the producer
+const READ = 1;       // Blocks consumed by the audio thread
+const CONTROL_INTS = 2;
+
+export class RenderAheadRing {
+    /** Allocate a ring the producer keeps up to `lookahead` blocks ahead in. */
+    static create(lookahead) {
+        // Power-of-two slots so block numbers map to slots across counter wrap
+        let capacity = 1;
+        while (capacity < lookahead) capacity <<= 1;
+        return new RenderAheadRing({
+            control: new SharedArrayBuffer(CONTROL_INTS * 4),
+            audio: new SharedArrayBuffer(capacity * RING_CHANNELS * RING_BLOCK * 4),
+            capacity,
+            lookahead,
+        });
+    }
+
+    /** Attach to a ring created elsewhere (the descriptor is postMessage-able). */
+    constructor(descriptor) {
+        this.descriptor = descriptor;
+        this.capacity = descriptor.capacity;
+        this.lookahead = descriptor.lookahead;
+        this.control = new Int32Array(descriptor.control);
+        this.audio = new Float32Array(descriptor.audio);
+
+        // Views are made once so the audio thread never allocates
+        this.slots = [];
+        for (let slot = 0; slot < this.capacity; slot++) {
+            const channels = [];
+            for (let c = 0; c < RING_CHANNELS; c++) {
+                const offset = (slot * RING_CHANNELS + c) * RING_BLOCK;
+                channels.push(this.audio.subarray(offset, offset + RING_BLOCK));
+            }
+            this.slots.push(channels);
+        }
+    }
+
+    /** Blocks rendered but not yet played. */
+    buffered() {
+        return (Atomics.load(this.control, WRITE) - Atomics.load(this.control, READ)) | 0;
+    }
+
+    /** The RING_CHANNELS planar buffers of block number `n`. */
+    slot(n) {
+        return this.slots[n & (this.capacity - 1)];
+    }
+
+    // --- Producer ---
+
+    /** Number of the next block to write, or null once `lookahead` blocks are queued. */
+    writeIndex() {
+        const w = Atomics.load(this.control, WRITE);
+        return ((w - Atomics.load(this.control, READ)) | 0) < this.lookahead ? w : null;
+    }
+
+    publish() {
+        Atomics.add(this.control, WRITE, 1);
+    }
+
+    /**
+     * Resolve once the consumer has freed a slot. Uses Atomics.waitAsync
+     * where available and falls back to polling every `pollMs`. Always
+     * resolves from a new task, so the producer's message handler keeps
+     * running between fills.
+     */
+    waitForSpace(pollMs) {
+        const r = Atomics.load(this.control, READ);
+        if (this.writeIndex() === null && typeof Atomics.waitAsync === 'function') {
+            const result = Atomics.waitAsync(this.control, READ, r);
+            if (result.async) return result.value;
+        }
+        const delay = this.writeIndex() === null ? pollMs : 0;
+        return new Promise(resolve => setTimeout(resolve, delay));
+    }
+
+    // --- Consumer ---
+
+    /** Number of the oldest unplayed block, or null when the ring is empty. */
+    readIndex() {
+        const r = Atomics.load(this.control, READ);
+        return ((Atomics.load(this.control, WRITE) - r) | 0) > 0 ? r : null;
+    }
+
+    release() {
+        Atomics.add(this.control, READ, 1);
+        Atomics.notify(this.control, READ);
+    }
+}
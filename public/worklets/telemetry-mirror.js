@@ -0,0 +1,40 @@
+/**
+ * Copies engine telemetry blocks (EngineTelemetry, one per engine or
+ * layer) from the WASM heap into a SharedArrayBuffer after every block, so
+ * the main thread can read them without messages.
+ *
+ * The heap itself is not shared with the main thread (and may move when
+ * memory grows), hence the copy: a few hundred bytes per block. The mirror
+ * is a seqlock like the engine's own block: control[0] is odd while a copy
+ * is in progress; readers keep a copy taken between two equal even values.
+ *
+ * Layout: Int32 control[2] = [sequence, record count], then the records,
+ * `recordBytes` each, in layer order.
+ */
+
+const SEQUENCE = 0;
+const RECORDS = 1;
+const HEADER_BYTES = 8;
+
+export class TelemetryMirror {
+    /** Mirror the telemetry blocks at heap addresses `ptrs`. */
+    constructor(ptrs, recordBytes) {
+        this.ptrs = ptrs;
+        this.recordBytes = recordBytes;
+        this.buffer = new SharedArrayBuffer(HEADER_BYTES + ptrs.length * recordBytes);
+        this.control = new Int32Array(this.buffer, 0, 2);
+        this.bytes = new Uint8Array(this.buffer);
+        this.control[RECORDS] = ptrs.length;
+    }
+
+    /** Copy every record out of `heapU8` (re-read by the caller each block). */
+    write(heapU8) {
+        Atomics.add(this.control, SEQUENCE, 1);
+        for (let k = 0; k < this.ptrs.length; k++) {
+            const ptr = this.ptrs[k];
+            this.bytes.set(heapU8.subarray(ptr, ptr + this.recordBytes),
+                HEADER_BYTES + k * this.recordBytes);
+        }
+        Atomics.add(this.control, SEQUENCE, 1);
+    }
+}
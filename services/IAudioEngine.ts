@@ -4,6 +4,7 @@ export interface GrainEvent {
     normPos: number;
     duration: number;
     pan: number;
+    layer?: number;     // Spawning layer, when the engine runs layers
 }
 
 /**
@@ -241,6 +241,9 @@ export class AudioEngine implements IAudioEngine {
     }
 
     // Filter (Base value)
+    if (this.filterNode) {
+      this.filterNode.type = this.params.filterType ?? 'lowpass';
+    }
     if (this.filterNode && !this.params.lfoTargets.includes('filterFreq')) {
       this.filterNode.frequency.setTargetAtTime(this.params.filterFreq, t, ramp);
       this.filterNode.Q.setTargetAtTime(this.params.filterRes, t, ramp);
@@ -331,9 +334,13 @@ export class AudioEngine implements IAudioEngine {
             curve[i] = x;
         }
     } else {
+        // 3x makeup gain: unity slope as the amount goes to 0, so enabling
+        // the stage does not drop the level (same curve as the WASM engine).
+        // This engine has no limiter, so the peak (up to pi / 3) is clamped.
         for (let i = 0; i < n_samples; ++i) {
             const x = (i * 2) / n_samples - 1;
-            curve[i] = (3 + k) * x * 20 * deg / (Math.PI + k * Math.abs(x));
+            const y = 3 * (3 + k) * x * 20 * deg / (Math.PI + k * Math.abs(x));
+            curve[i] = Math.max(-1, Math.min(1, y));
         }
     }
 
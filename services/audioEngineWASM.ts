@@ -1,43 +1,162 @@
 import { GranularParams } from '../types';
 import { IAudioEngine, GrainEvent } from './IAudioEngine';
 
+/** Cost estimate the engine reports for a loaded impulse response. */
+export interface ImpulseCost {
+    partitions: number;     // 128-frame IR partitions per channel
+    latencyFrames: number;  // Added wet-path latency (0 at the 128-frame quantum)
+    flopsPerBlock: number;  // Both channels, per 128-frame block
+    mflops: number;         // Millions of flops per second of audio
+    memoryBytes: number;    // IR spectra + frequency-domain delay line
+}
+
+/** Engine meters, refreshed by the worklet every ~30ms. */
+export interface EngineStats {
+    activeGrains: number;     // Grains sounding at the last poll
+    gainReductionDb: number;  // Largest limiter / soft-clip reduction since the previous poll
+    outputPeak: number;       // Largest |sample| on the main output since the previous poll
+    limiterLatency: number;   // Frames the lookahead limiter delays the output (0 when off)
+    cpuLoad: number;          // Smoothed render time over real time (0 without a CPU budget)
+    grainCap: number;         // Grains the CPU governor currently allows
+}
+
+/**
+ * Engine telemetry (EngineTelemetry in the C++ engine), rewritten after
+ * every rendered block. Totals count from enableTelemetry() and wrap at 2^32.
+ */
+export interface EngineTelemetry {
+    blocks: number;           // Blocks rendered
+    activeGrains: number;     // Grains sounding after the last block
+    grainCap: number;         // Grain limit, lowered by the CPU governor
+    spawns: number;           // Grains spawned
+    steals: number;           // Grains cut off for new ones
+    endsNatural: number;      // Grains whose envelope ran out
+    endsBoundary: number;     // Grains that ran off the sample edge
+    endsFaded: number;        // Grains faded or cut (note ends, stop, CPU shedding)
+    spawnMs: number;          // Last block: scheduling and spawning
+    renderMs: number;         // Last block: grain layer
+    fxMs: number;             // Last block: post-mix chain and sends
+    blockLoad: number;        // Last block's cost over its real-time duration
+    peak: [number, number];   // Last block's main output, left and right
+    rms: [number, number];
+    costHistogram: number[];  // Blocks by load, 16 bins of 1/8 (the last one open-ended)
+}
+
+// Telemetry mirror shared by the worklet or render worker (telemetry-mirror.js)
+interface TelemetryView {
+    control: Int32Array;      // [sequence (odd mid-copy), record count]
+    bytes: Uint8Array;
+    records: number;
+    recordBytes: number;
+}
+
+const TELEMETRY_HEADER_BYTES = 8;
+const TELEMETRY_COST_BINS = 16;
+
+// Settles the promise of a request sent with an id
+interface PendingReply {
+    resolve: (value: any) => void;
+    reject: (error: Error) => void;
+}
+
+// Prep worker reply to an 'impulse' request
+interface PreparedImpulse {
+    partitions: number;
+    channels: number;
+    spectra: Float32Array;    // PartitionedConvolver spectra layout
+}
+
+interface PreparedFrames {
+    frames: number;
+    hop: number;
+    data: Float32Array;       // SpectralFrames layout
+}
+
+// A loaded sample the engines may need spectral frames for
+interface SpectralSource {
+    data: Float32Array;
+    requested: boolean;       // Frames asked of the prep worker
+}
+
+/** Render-ahead configuration (needs a cross-origin isolated page). */
+export interface RenderAheadOptions {
+    lookaheadMs: number;      // Latency budget the worker renders ahead by (min. 2 blocks)
+    renderThreads?: number;   // Helper threads for grain rendering; > 0 loads the pthreads build
+}
+
+export interface AudioEngineWASMOptions {
+    renderAhead?: RenderAheadOptions;
+    // Run this many engine layers (max. 16) over a shared sample bank; each
+    // layer has its own params, and all share one grain budget
+    layers?: number;
+}
+
+/** Render-ahead playback state, refreshed by the worklet every ~30ms. */
+export interface RenderAheadStats {
+    bufferedFrames: number;   // Frames rendered ahead of the audio clock
+    underruns: number;        // Times the worklet fell back to inline rendering
+    inline: boolean;          // Currently rendering inline while the ring refills
+}
+
 /**
  * WASM-based audio engine that runs grain synthesis in an AudioWorklet.
  *
- * Phase 1: Grain scheduling, envelope, LFO, mixing, panning run in C++/WASM.
- * Filter, distortion, delay, reverb remain as Web Audio nodes connected
- * after the AudioWorkletNode output.
+ * Grain scheduling, envelope, LFO, mixing, panning and the whole FX chain
+ * (post-mix filter, oversampled distortion, feedback delay, reverb, volume,
+ * master limiter) run in C++/WASM as one fused pass per block. The only Web Audio nodes left
+ * are a unity gain for the start/stop fades and the analyser.
  *
  * Signal chain:
- *   [AudioWorkletNode] → BiquadFilter → WaveShaper → Delay(+feedback)
- *     → Convolver(reverb) → MasterGain → Analyser → destination
+ *   [AudioWorkletNode (grains → filter → distortion → delay → reverb → volume → limiter)]
+ *     → fade gain → Analyser → destination
+ *
+ * With options.renderAhead, a Web Worker runs a second engine ahead of the
+ * audio clock (optionally spreading grains over pthreads) and the worklet
+ * only copies its blocks out of a SharedArrayBuffer ring, rendering inline
+ * with its own engine when the ring runs dry. Every control message goes
+ * to both engines, and reaches the audible output lookaheadMs later.
+ *
+ * With options.layers, both engines are layer hosts: params and other engine
+ * messages go to every layer unless sent through the setLayer* methods, and
+ * loaded samples become bank slot 0, played by every layer.
+ *
+ * Heavy preparation (convolution IR spectra, the STFT analysis spectral
+ * grains read) runs on a prep worker with its own instance of the module;
+ * the engines only copy the results in. A sample is analysed the first time
+ * grainMode is 'spectral' while it is loaded, not when it loads.
  */
 export class AudioEngineWASM implements IAudioEngine {
     private ctx: AudioContext | null = null;
     private workletNode: AudioWorkletNode | null = null;
     private isReady: boolean = false;
 
-    // Web Audio FX nodes (Phase 1: these stay outside the worklet)
-    private filterNode: BiquadFilterNode | null = null;
-    private distNode: WaveShaperNode | null = null;
-    private delayNode: DelayNode | null = null;
-    private delayFeedbackNode: GainNode | null = null;
-    private delayDryGain: GainNode | null = null;
-    private delayWetGain: GainNode | null = null;
-    private reverbDryGain: GainNode | null = null;
-    private reverbWetGain: GainNode | null = null;
-    private convolver: ConvolverNode | null = null;
+    // Render-ahead worker (null unless options.renderAhead is set and usable)
+    private renderWorker: Worker | null = null;
+    private renderAheadStats: RenderAheadStats | null = null;
+
+    // Web Audio output nodes (everything else runs inside the worklet)
     private masterGain: GainNode | null = null;
     private analyser: AnalyserNode | null = null;
 
-    private lastReverbDecay: number = 0;
+    // Requests awaiting a reply from an engine or the prep worker, by the
+    // id the request carried (the reply, or an error, carries it back)
+    private pendingReplies = new Map<number, PendingReply>();
+    private nextRequestId: number = 1;
+
+    // Prep worker (partitioning and FFTs off the audio thread), started on
+    // first use with the compiled module
+    private prepWorker: Worker | null = null;
+    private wasmModule: WebAssembly.Module | null = null;
 
-    // Distortion curve cache (same as JS engine)
-    private distortionCurveCache: Map<number, Float32Array> = new Map();
-    private static readonly MAX_DISTORTION_CACHE = 20;
+    // Telemetry mirrors of the worklet's and the render worker's engines
+    private workletTelemetry: TelemetryView | null = null;
+    private workerTelemetry: TelemetryView | null = null;
 
     // Visualization
     private grainQueue: GrainEvent[] = [];
+    private stats: EngineStats = {
+        activeGrains: 0, gainReductionDb: 0, outputPeak: 0, limiterLatency: 0, cpuLoad: 0, grainCap: 128,
+    };
     private frequencyDataArray: Uint8Array | null = null;
     private timeDataArray: Float32Array | null = null;
 
@@ -47,10 +166,15 @@ export class AudioEngineWASM implements IAudioEngine {
     private isRecording: boolean = false;
     private destinationStream: MediaStream | null = null;
 
-    // Sample data (cached for getAudioData)
+    // Sample data (cached for getAudioData and the spectral analysis)
     private sampleData: Float32Array | null = null;
     private sampleDuration: number = 0;
 
+    // Loaded samples by bank slot (the single-engine sample is slot 0),
+    // analysed for spectral grains when first needed; frames for a source
+    // that has since been replaced are dropped
+    private spectralSources = new Map<number, SpectralSource>();
+
     // Freeze / Drift state (mirrored for queries)
     private frozen: boolean = false;
     private drifting: boolean = false;
@@ -59,9 +183,11 @@ export class AudioEngineWASM implements IAudioEngine {
     private driftReturn: number = 0.3;
 
     private params: GranularParams;
+    private options: AudioEngineWASMOptions;
 
-    constructor(initialParams: GranularParams) {
+    constructor(initialParams: GranularParams, options: AudioEngineWASMOptions = {}) {
         this.params = initialParams;
+        this.options = options;
     }
 
     async init(): Promise<void> {
@@ -86,6 +212,7 @@ export class AudioEngineWASM implements IAudioEngine {
         }
         const wasmBytes = await wasmResponse.arrayBuffer();
         const compiledModule = await WebAssembly.compile(wasmBytes);
+        this.wasmModule = compiledModule;
 
         // Load worklet processor
         await this.ctx.audioWorklet.addModule('/worklets/grain-processor.js');
@@ -93,46 +220,23 @@ export class AudioEngineWASM implements IAudioEngine {
         // Create worklet node with the pre-compiled WASM module
         this.workletNode = new AudioWorkletNode(this.ctx, 'grain-processor', {
             numberOfInputs: 0,
-            numberOfOutputs: 1,
-            outputChannelCount: [2],
+            // Output 0 is the mix; 1 and 2 are the delay and reverb aux buses
+            numberOfOutputs: 3,
+            outputChannelCount: [2, 2, 2],
             processorOptions: {
                 wasmModule: compiledModule,
+                layers: this.layerCount(),
             }
         });
 
         // Listen for messages from the worklet
-        this.workletNode.port.onmessage = (e: MessageEvent) => {
-            const msg = e.data;
-            switch (msg.type) {
-                case 'ready':
-                    this.isReady = true;
-                    break;
-                case 'grainEvents':
-                    this.grainQueue.push(...msg.events);
-                    break;
-                case 'error':
-                    console.error('[AudioEngineWASM] Worklet error:', msg.message);
-                    break;
-            }
-        };
-
-        // Create FX chain nodes
-        this.filterNode = this.ctx.createBiquadFilter();
-        this.filterNode.type = 'lowpass';
-
-        this.distNode = this.ctx.createWaveShaper();
-        this.distNode.curve = this.makeDistortionCurve(0);
-        this.distNode.oversample = '4x';
+        this.workletNode.port.onmessage = (e: MessageEvent) => this.handleEngineMessage(e.data, false);
 
-        this.delayNode = this.ctx.createDelay(5.0);
-        this.delayFeedbackNode = this.ctx.createGain();
-        this.delayDryGain = this.ctx.createGain();
-        this.delayWetGain = this.ctx.createGain();
-
-        this.reverbDryGain = this.ctx.createGain();
-        this.reverbWetGain = this.ctx.createGain();
-        this.convolver = this.ctx.createConvolver();
+        if (this.options.renderAhead) {
+            this.startRenderAhead(this.options.renderAhead);
+        }
 
+        // Create output nodes
         this.masterGain = this.ctx.createGain();
         this.analyser = this.ctx.createAnalyser();
         this.analyser.fftSize = 2048;
@@ -143,41 +247,13 @@ export class AudioEngineWASM implements IAudioEngine {
         this.timeDataArray = new Float32Array(fftSize);
 
         // Routing Graph:
-        // WorkletNode → Filter → Distortion → Delay → Reverb → Master → Analyser → destination
-        this.workletNode.connect(this.filterNode);
-
-        // 1. Filter → Distortion
-        this.filterNode.connect(this.distNode);
-
-        // 2. Distortion → Delay Section
-        this.distNode.connect(this.delayDryGain);
-        this.distNode.connect(this.delayNode);
-
-        this.delayNode.connect(this.delayFeedbackNode);
-        this.delayFeedbackNode.connect(this.delayNode); // Feedback Loop
-        this.delayNode.connect(this.delayWetGain);
-
-        // 3. Delay Output → preReverbNode (sum dry + wet)
-        const preReverbNode = this.ctx.createGain();
-        this.delayDryGain.connect(preReverbNode);
-        this.delayWetGain.connect(preReverbNode);
-
-        // 4. Reverb Section
-        preReverbNode.connect(this.reverbDryGain);
-        preReverbNode.connect(this.convolver);
-        this.convolver.connect(this.reverbWetGain);
-
-        // 5. To Master
-        this.reverbDryGain.connect(this.masterGain);
-        this.reverbWetGain.connect(this.masterGain);
+        // WorkletNode (includes the whole FX chain) → Master → Analyser → destination
+        this.workletNode.connect(this.masterGain);
 
         // Master → output
         this.masterGain.connect(this.analyser);
         this.masterGain.connect(this.ctx.destination);
 
-        // Initialize reverb impulse
-        this.updateReverbImpulse();
-
         // Send initial params
         this.updateParams(this.params);
 
@@ -186,6 +262,142 @@ export class AudioEngineWASM implements IAudioEngine {
         }
     }
 
+    /**
+     * Replies from the worklet and the render worker. While a render worker
+     * exists it owns the audible engine, so its events, meters and IR costs
+     * win and the worklet only reports ring state.
+     */
+    private handleEngineMessage(msg: any, fromWorker: boolean): void {
+        const primary = fromWorker || !this.renderWorker;
+        switch (msg.type) {
+            case 'ready':
+                if (!fromWorker) {
+                    this.isReady = true;
+                } else {
+                    this.workletNode?.port.postMessage({ type: 'renderAhead', ring: msg.ring });
+                }
+                break;
+            case 'grainEvents':
+                if (primary) this.grainQueue.push(...msg.events);
+                break;
+            case 'stats':
+                if (primary) this.stats = msg.stats;
+                break;
+            case 'renderAheadStats':
+                this.renderAheadStats = msg.stats;
+                break;
+            case 'impulseLoaded':
+                if (primary) this.settleReply(msg.id, msg.cost);
+                break;
+            case 'state':
+                if (primary) this.settleReply(msg.id, msg.data);
+                break;
+            case 'stateRestored':
+                if (primary) this.settleReply(msg.id, true);
+                break;
+            case 'telemetry': {
+                const view: TelemetryView = {
+                    control: new Int32Array(msg.buffer, 0, 2),
+                    bytes: new Uint8Array(msg.buffer),
+                    records: msg.records,
+                    recordBytes: msg.recordBytes,
+                };
+                if (fromWorker) this.workerTelemetry = view;
+                else this.workletTelemetry = view;
+                break;
+            }
+            case 'error':
+                console.error(`[AudioEngineWASM] ${fromWorker ? 'Render worker' : 'Worklet'} error:`, msg.message);
+                if (primary && msg.id !== undefined) this.failReply(msg.id, msg.message);
+                if (fromWorker && msg.fatal) this.stopRenderAhead();
+                break;
+        }
+    }
+
+    /** A promise for the reply to request `id`, settled by settleReply() / failReply(). */
+    private expectReply<T>(id: number): Promise<T> {
+        return new Promise<T>((resolve, reject) => this.pendingReplies.set(id, { resolve, reject }));
+    }
+
+    // Later replies to the same id (e.g. one per layer) find nothing to settle
+    private settleReply(id: number, value: unknown): void {
+        this.pendingReplies.get(id)?.resolve(value);
+        this.pendingReplies.delete(id);
+    }
+
+    private failReply(id: number, message: string): void {
+        this.pendingReplies.get(id)?.reject(new Error(message));
+        this.pendingReplies.delete(id);
+    }
+
+    /**
+     * Run a job on the prep worker (prep-worker.js) and resolve with its
+     * reply. The worker is started on first use.
+     */
+    private prepare<T>(msg: any, transfer: Transferable[] = []): Promise<T> {
+        if (!this.wasmModule) return Promise.reject(new Error('Audio engine not initialized'));
+        if (!this.prepWorker) {
+            this.prepWorker = new Worker('/worklets/prep-worker.js', { type: 'module' });
+            this.prepWorker.onmessage = (e: MessageEvent) => {
+                const reply = e.data;
+                if (reply.type === 'error') this.failReply(reply.id, reply.message);
+                else this.settleReply(reply.id, reply);
+            };
+            this.prepWorker.postMessage({ type: 'init', wasmModule: this.wasmModule });
+        }
+        const id = this.nextRequestId++;
+        const reply = this.expectReply<T>(id);
+        this.prepWorker.postMessage({ ...msg, id }, transfer);
+        return reply;
+    }
+
+    /** Send a control message to the worklet and, if running, the render worker. */
+    private post(msg: any, transfer: Transferable[] = []): void {
+        // The worker gets a structured clone; the worklet takes the transfer
+        this.renderWorker?.postMessage(msg);
+        this.workletNode?.port.postMessage(msg, transfer);
+    }
+
+    private startRenderAhead(options: RenderAheadOptions): void {
+        if (!this.ctx) return;
+        if (!globalThis.crossOriginIsolated) {
+            console.warn('[AudioEngineWASM] Render-ahead needs a cross-origin isolated page (COOP/COEP); rendering in the worklet');
+            return;
+        }
+
+        const threads = Math.max(0, Math.floor(options.renderThreads ?? 0));
+        const blockMs = 128 / this.ctx.sampleRate * 1000;
+        this.renderWorker = new Worker('/worklets/grain-render-worker.js', { type: 'module' });
+        this.renderWorker.onmessage = (e: MessageEvent) => this.handleEngineMessage(e.data, true);
+        this.renderWorker.onerror = (e: ErrorEvent) => {
+            console.error('[AudioEngineWASM] Render worker failed:', e.message);
+            this.stopRenderAhead();
+        };
+        this.renderWorker.postMessage({
+            type: 'init',
+            script: threads > 0 ? '/wasm/grain_engine_mt.js' : '/wasm/grain_engine.js',
+            sampleRate: this.ctx.sampleRate,
+            lookahead: Math.max(2, Math.ceil(options.lookaheadMs / blockMs)),
+            renderThreads: threads,
+            layers: this.layerCount(),
+        });
+    }
+
+    // Layers requested in the options (0 = a single engine)
+    private layerCount(): number {
+        return Math.max(0, Math.min(16, Math.floor(this.options.layers ?? 0)));
+    }
+
+    // Back to rendering in the worklet (after the worker failed)
+    private stopRenderAhead(): void {
+        if (!this.renderWorker) return;
+        this.workletNode?.port.postMessage({ type: 'renderAhead', ring: null });
+        this.renderWorker.postMessage({ type: 'shutdown' });
+        this.renderWorker = null;
+        this.renderAheadStats = null;
+        this.workerTelemetry = null;
+    }
+
     async loadSample(file: File): Promise<void> {
         await this.init();
         if (!this.ctx) return;
@@ -206,12 +418,13 @@ export class AudioEngineWASM implements IAudioEngine {
         this.sampleData = new Float32Array(channelData);
         this.sampleDuration = audioBuffer.duration;
 
-        // Transfer to worklet
+        // Transfer to the engine(s)
         const copy = new Float32Array(channelData);
-        this.workletNode!.port.postMessage(
+        this.post(
             { type: 'sampleBuffer', data: copy, channels: 1, length: copy.length },
             [copy.buffer]
         );
+        this.sampleLoaded(0, this.sampleData);
 
         this.params = { ...this.params, position: 0 };
     }
@@ -229,10 +442,11 @@ export class AudioEngineWASM implements IAudioEngine {
         this.sampleDuration = 5;
 
         const copy = new Float32Array(data);
-        this.workletNode?.port.postMessage(
+        this.post(
             { type: 'sampleBuffer', data: copy, channels: 1, length: copy.length },
             [copy.buffer]
         );
+        this.sampleLoaded(0, this.sampleData);
     }
 
     loadFromFloat32Data(data: Float32Array): void {
@@ -241,15 +455,49 @@ export class AudioEngineWASM implements IAudioEngine {
         this.sampleDuration = data.length / this.ctx.sampleRate;
 
         const copy = new Float32Array(data);
-        this.workletNode?.port.postMessage(
+        this.post(
             { type: 'sampleBuffer', data: copy, channels: 1, length: copy.length },
             [copy.buffer]
         );
+        this.sampleLoaded(0, this.sampleData);
         this.params = { ...this.params, position: 0 };
     }
 
+    // A new sample is in the engines: its frames are analysed when needed
+    private sampleLoaded(slot: number, data: Float32Array): void {
+        this.spectralSources.set(slot, { data, requested: false });
+        this.requestSpectralFrames(this.params);
+    }
+
+    /**
+     * Have the prep worker analyse the loaded samples for spectral grains,
+     * once per sample and only when `params` ask for them. Until the frames
+     * arrive the engines play spectral grains in the time domain.
+     */
+    private requestSpectralFrames(params: GranularParams): void {
+        if (params.grainMode !== 'spectral') return;
+        for (const [slot, source] of this.spectralSources) {
+            if (source.requested) continue;
+            source.requested = true;
+
+            const copy = new Float32Array(source.data);
+            this.prepare<PreparedFrames>({ type: 'spectralFrames', data: copy }, [copy.buffer])
+                .then((prepared) => {
+                    if (this.spectralSources.get(slot) !== source) return;
+                    this.post(
+                        {
+                            type: 'spectralFrames', slot,
+                            frames: prepared.frames, hop: prepared.hop, data: prepared.data,
+                        },
+                        [prepared.data.buffer]
+                    );
+                })
+                .catch((err) => console.error('[AudioEngineWASM] Spectral analysis failed:', err));
+        }
+    }
+
     start(): void {
-        this.workletNode?.port.postMessage({ type: 'start' });
+        this.post({ type: 'start' });
 
         // Restore gains that were zeroed on stop() with a short ramp to avoid clicks
         if (this.ctx) {
@@ -259,19 +507,16 @@ export class AudioEngineWASM implements IAudioEngine {
             if (this.masterGain) {
                 this.masterGain.gain.cancelScheduledValues(t);
                 this.masterGain.gain.setValueAtTime(0, t);
-                this.masterGain.gain.linearRampToValueAtTime(this.params.volume, t + rampUp);
-            }
-            if (this.delayFeedbackNode) {
-                this.delayFeedbackNode.gain.cancelScheduledValues(t);
-                this.delayFeedbackNode.gain.setValueAtTime(this.params.delayFeedback, t);
+                this.masterGain.gain.linearRampToValueAtTime(1, t + rampUp);
             }
         }
     }
 
     stop(): void {
-        this.workletNode?.port.postMessage({ type: 'stop' });
+        this.post({ type: 'stop' });
 
-        // Silence the FX chain: fast-ramp master gain to 0 and kill delay feedback
+        // Silence the FX chain: fast-ramp master gain to 0 (the engine stops
+        // rendering, delay tail included, once the worklet sees 'stop')
         if (this.ctx) {
             const t = this.ctx.currentTime;
             const fadeOut = 0.03; // 30ms fade-out
@@ -281,62 +526,274 @@ export class AudioEngineWASM implements IAudioEngine {
                 this.masterGain.gain.setValueAtTime(this.masterGain.gain.value, t);
                 this.masterGain.gain.linearRampToValueAtTime(0, t + fadeOut);
             }
-
-            // Kill delay feedback loop so it doesn't ring indefinitely
-            if (this.delayFeedbackNode) {
-                this.delayFeedbackNode.gain.cancelScheduledValues(t);
-                this.delayFeedbackNode.gain.setValueAtTime(0, t);
-            }
         }
     }
 
     updateParams(newParams: GranularParams): void {
         this.params = newParams;
 
-        // Send all params to the worklet (it extracts what it needs)
-        this.workletNode?.port.postMessage({ type: 'params', params: newParams });
+        // Send all params to the worklet (it extracts what it needs); volume
+        // is applied by the engine, so the master gain only does the fades
+        this.post({ type: 'params', params: newParams });
+        this.requestSpectralFrames(newParams);
+    }
 
-        // Update Web Audio FX nodes locally (Phase 1)
-        if (!this.ctx) return;
-        const t = this.ctx.currentTime;
-        const ramp = 0.1;
+    // --- Preset morphing ---
 
-        // Master volume
-        this.masterGain?.gain.setTargetAtTime(newParams.volume, t, ramp);
+    /**
+     * Store a morph snapshot in the engine. Snapshots are spread evenly over
+     * the 0..1 morph position in index order; at least two are needed.
+     */
+    setMorphSnapshot(index: number, params: GranularParams): void {
+        this.post({ type: 'morphSnapshot', index, params });
+    }
 
-        // Filter
-        if (this.filterNode && !newParams.lfoTargets.includes('filterFreq')) {
-            this.filterNode.frequency.setTargetAtTime(newParams.filterFreq, t, ramp);
-            this.filterNode.Q.setTargetAtTime(newParams.filterRes, t, ramp);
-        }
+    /** Move the morph position (0..1). One message replaces a full params update. */
+    setMorphPosition(position: number): void {
+        this.post({
+            type: 'morphPosition', position: Math.max(0, Math.min(1, position))
+        });
+    }
+
+    clearMorphSnapshots(): void {
+        this.post({ type: 'morphClear' });
+    }
+
+    /**
+     * Seed the engine's random streams. The same seed and parameter sequence
+     * reproduces the same render.
+     */
+    setSeed(seed: number): void {
+        this.post({ type: 'seed', seed: seed >>> 0 });
+    }
+
+    // --- Polyphonic notes ---
+
+    /**
+     * Switch between the free-running grain stream and note-driven streams.
+     * In polyphonic mode each held note plays its own stream, sharing the
+     * grain pool fairly with the others; start() is still needed.
+     */
+    setPolyphonic(enabled: boolean): void {
+        this.post({ type: 'polyphonic', enabled });
+    }
+
+    /**
+     * Start (or retrigger) note `note` (any id, e.g. a MIDI note number)
+     * `pitch` semitones above params.pitch, with velocity 0 - 1.
+     */
+    noteOn(note: number, pitch: number, velocity: number = 1): void {
+        this.post({ type: 'noteOn', note, pitch, velocity: Math.max(0, Math.min(1, velocity)) });
+    }
+
+    noteOff(note: number): void {
+        this.post({ type: 'noteOff', note });
+    }
+
+    allNotesOff(): void {
+        this.post({ type: 'allNotesOff' });
+    }
 
-        // Distortion
-        if (this.distNode) {
-            this.distNode.curve = this.makeDistortionCurve(newParams.distAmount);
+    // --- CPU budget ---
+
+    /**
+     * Let the engine spend at most `fraction` of each block's real-time
+     * duration rendering (0 = off). Over budget it sheds grains, fading the
+     * quietest out, and recovers once the load stays low; watch cpuLoad and
+     * grainCap in getEngineStats(). Layers split the budget evenly.
+     */
+    setCpuBudget(fraction: number): void {
+        this.post({ type: 'cpuBudget', budget: Math.max(0, Math.min(1, fraction)) });
+    }
+
+    // --- Telemetry ---
+
+    /**
+     * Have the engine publish telemetry after every block into shared
+     * memory, read with readTelemetry() without any messages. Needs a
+     * cross-origin isolated page; returns false otherwise.
+     */
+    async enableTelemetry(enabled: boolean = true): Promise<boolean> {
+        await this.init();
+        if (enabled && !globalThis.crossOriginIsolated) {
+            console.warn('[AudioEngineWASM] Telemetry needs a cross-origin isolated page (COOP/COEP)');
+            return false;
+        }
+        if (!enabled) {
+            this.workletTelemetry = null;
+            this.workerTelemetry = null;
         }
+        this.post({ type: 'telemetry', enabled });
+        return true;
+    }
 
-        // Delay
-        if (this.delayNode && this.delayFeedbackNode && this.delayDryGain && this.delayWetGain) {
-            this.delayNode.delayTime.setTargetAtTime(newParams.delayTime, t, ramp);
-            this.delayFeedbackNode.gain.setTargetAtTime(newParams.delayFeedback, t, ramp);
-            this.delayDryGain.gain.setTargetAtTime(1 - newParams.delayMix, t, ramp);
-            this.delayWetGain.gain.setTargetAtTime(newParams.delayMix, t, ramp);
+    /**
+     * Latest telemetry of the audible engine (of one layer when layered),
+     * or null until the first block after enableTelemetry(). Safe to call
+     * every frame: it copies a few hundred bytes and never blocks.
+     */
+    readTelemetry(layer: number = 0): EngineTelemetry | null {
+        const view = this.renderWorker ? this.workerTelemetry : this.workletTelemetry;
+        if (!view || layer < 0 || layer >= view.records) return null;
+
+        // Seqlock read: retry if a copy was in progress or completed meanwhile
+        const start = TELEMETRY_HEADER_BYTES + layer * view.recordBytes;
+        for (let attempt = 0; attempt < 4; attempt++) {
+            const before = Atomics.load(view.control, 0);
+            if (before & 1) continue;
+            const record = view.bytes.slice(start, start + view.recordBytes);
+            if (Atomics.load(view.control, 0) !== before) continue;
+            return before === 0 ? null : parseTelemetry(new DataView(record.buffer));
         }
+        return null;
+    }
+
+    // --- State snapshots ---
+
+    /**
+     * Snapshot the engine's grains, note voices, random streams, smoothers
+     * and transport (of one layer when layered, layer 0 by default). The
+     * bytes only restore into an engine built from the same sources at the
+     * same sample rate; effect tails are not included.
+     */
+    async captureState(layer: number = 0): Promise<ArrayBuffer> {
+        await this.init();
+        const id = this.nextRequestId++;
+        const captured = this.expectReply<ArrayBuffer>(id);
+        this.post({ type: 'captureState', id, layer });
+        return captured;
+    }
+
+    /**
+     * Continue from a captureState() snapshot. The grain layer picks up
+     * exactly where the saved engine was; grains are dropped if the loaded
+     * sample's length differs. Resolves once the engine has taken the
+     * snapshot; rejects if it doesn't match the engine or the layer.
+     */
+    async restoreState(state: ArrayBuffer, layer: number = 0): Promise<boolean> {
+        await this.init();
+        const id = this.nextRequestId++;
+        const restored = this.expectReply<boolean>(id);
+        this.post({ type: 'restoreState', id, layer, data: state });
+        return restored;
+    }
+
+    // --- Layers (options.layers) ---
 
-        // Reverb
-        if (this.reverbDryGain && this.reverbWetGain) {
-            this.reverbDryGain.gain.setTargetAtTime(1 - newParams.reverbMix, t, ramp);
-            this.reverbWetGain.gain.setTargetAtTime(newParams.reverbMix, t, ramp);
+    /** Params for one layer only; updateParams() sets every layer. */
+    setLayerParams(layer: number, params: GranularParams): void {
+        this.post({ type: 'params', layer, params });
+        this.requestSpectralFrames(params);
+    }
+
+    /** Output gain of one layer (linear, smoothed in the engine). */
+    setLayerGain(layer: number, gain: number): void {
+        this.post({ type: 'layerGain', layer, gain: Math.max(0, gain) });
+    }
+
+    /**
+     * Load mono sample data into a bank slot (0-15). Every layer that plays
+     * the slot shares it, and its spectral analysis (run on the prep worker
+     * once spectral grains are wanted).
+     */
+    loadBankSample(slot: number, data: Float32Array): void {
+        const copy = new Float32Array(data);
+        this.post(
+            { type: 'bankSample', slot, data: copy, channels: 1 },
+            [copy.buffer]
+        );
+        if (this.layerCount() > 0) this.sampleLoaded(slot, new Float32Array(data));
+    }
+
+    /** Play bank slot `slot` on a layer (-1 = silence it). */
+    setLayerSample(layer: number, slot: number): void {
+        this.post({ type: 'layerSample', layer, slot });
+    }
+
+    /** Cap on grains sounding at once across all layers (default 128). */
+    setGrainBudget(grains: number): void {
+        this.post({ type: 'grainBudget', grains: Math.max(0, Math.floor(grains)) });
+    }
+
+    // --- Convolution reverb ---
+
+    /**
+     * Load an impulse response for the convolution reverb (used when
+     * params.reverbType is 'convolution'). The file is decoded at the context
+     * rate; partitioning and FFTs run in the prep worker, and the engines
+     * only copy the finished spectra in. Resolves with the engine's
+     * CPU/memory estimate for this IR; rejects if the IR is invalid or too
+     * long.
+     */
+    async loadImpulseResponse(file: File): Promise<ImpulseCost> {
+        await this.init();
+        if (!this.ctx || !this.workletNode) throw new Error('Audio engine not initialized');
+
+        const audioBuffer = await this.ctx.decodeAudioData(await file.arrayBuffer());
+        const channels: Float32Array[] = [];
+        for (let c = 0; c < Math.min(2, audioBuffer.numberOfChannels); c++) {
+            channels.push(new Float32Array(audioBuffer.getChannelData(c)));
         }
 
-        // Update reverb impulse if decay changed significantly
-        if (Math.abs(newParams.reverbDecay - this.lastReverbDecay) > 0.1) {
-            this.updateReverbImpulse();
+        const prepared = await this.prepare<PreparedImpulse>(
+            { type: 'impulse', channels },
+            channels.map(c => c.buffer)
+        );
+
+        const id = this.nextRequestId++;
+        const loaded = this.expectReply<ImpulseCost>(id);
+        this.post(
+            {
+                type: 'impulse', id,
+                partitions: prepared.partitions,
+                channels: prepared.channels,
+                spectra: prepared.spectra,
+            },
+            [prepared.spectra.buffer]
+        );
+        return loaded;
+    }
+
+    /** Drop the loaded IR; 'convolution' falls back to the FDN reverb. */
+    clearImpulseResponse(): void {
+        this.post({ type: 'impulseClear' });
+    }
+
+    // --- Aux buses ---
+
+    /**
+     * Route a send bus to an external node. The buses carry the per-grain
+     * delay/reverb sends; with fxRouting 'external' they are dry, otherwise
+     * they carry the engine's wet returns. They are delayed by the limiter's
+     * latency (stats.limiterLatency), so they line up with the main output.
+     */
+    connectAuxBus(bus: 'delay' | 'reverb', destination: AudioNode): void {
+        this.workletNode?.connect(destination, bus === 'delay' ? 1 : 2);
+    }
+
+    disconnectAuxBus(bus: 'delay' | 'reverb', destination?: AudioNode): void {
+        if (!this.workletNode) return;
+        const output = bus === 'delay' ? 1 : 2;
+        try {
+            if (destination) this.workletNode.disconnect(destination, output);
+            else this.workletNode.disconnect(output);
+        } catch {
+            // Not connected
         }
     }
 
     // --- Visualization ---
 
+    /** Latest engine meters (gain reduction, output peak, active grains). */
+    getEngineStats(): EngineStats {
+        return this.stats;
+    }
+
+    /** Ring fill and underruns while rendering ahead; null otherwise. */
+    getRenderAheadStats(): RenderAheadStats | null {
+        return this.renderAheadStats;
+    }
+
     pollGrainEvents(): GrainEvent[] {
         const events = [...this.grainQueue];
         this.grainQueue = [];
@@ -386,14 +843,14 @@ export class AudioEngineWASM implements IAudioEngine {
 
     freeze(): void {
         this.frozen = true;
-        this.workletNode?.port.postMessage({
+        this.post({
             type: 'freeze', frozen: true, position: this.params.position
         });
     }
 
     unfreeze(): void {
         this.frozen = false;
-        this.workletNode?.port.postMessage({
+        this.post({
             type: 'freeze', frozen: false, position: 0
         });
     }
@@ -415,7 +872,7 @@ export class AudioEngineWASM implements IAudioEngine {
     startDrift(basePosition: number): void {
         this.drifting = true;
         this.driftPos = basePosition;
-        this.workletNode?.port.postMessage({
+        this.post({
             type: 'drift',
             enabled: true,
             basePosition,
@@ -426,7 +883,7 @@ export class AudioEngineWASM implements IAudioEngine {
 
     stopDrift(): void {
         this.drifting = false;
-        this.workletNode?.port.postMessage({
+        this.post({
             type: 'drift', enabled: false, basePosition: 0.5, speed: 0.5, returnTendency: 0.3
         });
     }
@@ -535,57 +992,6 @@ export class AudioEngineWASM implements IAudioEngine {
 
     // --- Private helpers ---
 
-    private makeDistortionCurve(amount: number): Float32Array {
-        const cacheKey = Math.round(amount * 1000) / 1000;
-        const cached = this.distortionCurveCache.get(cacheKey);
-        if (cached) return cached;
-
-        const k = amount * 100;
-        const n_samples = 44100;
-        const curve = new Float32Array(n_samples);
-        const deg = Math.PI / 180;
-
-        if (amount === 0) {
-            for (let i = 0; i < n_samples; ++i) {
-                const x = (i * 2) / n_samples - 1;
-                curve[i] = x;
-            }
-        } else {
-            for (let i = 0; i < n_samples; ++i) {
-                const x = (i * 2) / n_samples - 1;
-                curve[i] = (3 + k) * x * 20 * deg / (Math.PI + k * Math.abs(x));
-            }
-        }
-
-        if (this.distortionCurveCache.size >= AudioEngineWASM.MAX_DISTORTION_CACHE) {
-            const firstKey = this.distortionCurveCache.keys().next().value;
-            this.distortionCurveCache.delete(firstKey!);
-        }
-        this.distortionCurveCache.set(cacheKey, curve);
-        return curve;
-    }
-
-    private updateReverbImpulse(): void {
-        if (!this.ctx || !this.convolver) return;
-
-        const duration = this.params.reverbDecay;
-        this.lastReverbDecay = duration;
-
-        const rate = this.ctx.sampleRate;
-        const length = rate * duration;
-        const impulse = this.ctx.createBuffer(2, length, rate);
-
-        for (let c = 0; c < 2; c++) {
-            const channelData = impulse.getChannelData(c);
-            for (let i = 0; i < length; i++) {
-                const decay = Math.pow(1 - i / length, 4);
-                channelData[i] = (Math.random() * 2 - 1) * decay;
-            }
-        }
-
-        this.convolver.buffer = impulse;
-    }
-
     private async convertWebMToWav(webmBlob: Blob): Promise<Blob> {
         const arrayBuffer = await webmBlob.arrayBuffer();
         const audioBuffer = await this.ctx!.decodeAudioData(arrayBuffer);
@@ -644,3 +1050,30 @@ export class AudioEngineWASM implements IAudioEngine {
         }
     }
 }
+
+// Decode one EngineTelemetry record: 4-byte little-endian fields in the
+// struct's declaration order, the leading sequence word skipped
+function parseTelemetry(view: DataView): EngineTelemetry {
+    const u32 = (field: number) => view.getUint32(field * 4, true);
+    const i32 = (field: number) => view.getInt32(field * 4, true);
+    const f32 = (field: number) => view.getFloat32(field * 4, true);
+    const costHistogram: number[] = [];
+    for (let bin = 0; bin < TELEMETRY_COST_BINS; bin++) costHistogram.push(u32(17 + bin));
+    return {
+        blocks: u32(1),
+        activeGrains: i32(2),
+        grainCap: i32(3),
+        spawns: u32(4),
+        steals: u32(5),
+        endsNatural: u32(6),
+        endsBoundary: u32(7),
+        endsFaded: u32(8),
+        spawnMs: f32(9),
+        renderMs: f32(10),
+        fxMs: f32(11),
+        blockLoad: f32(12),
+        peak: [f32(13), f32(14)],
+        rms: [f32(15), f32(16)],
+        costHistogram,
+    };
+}
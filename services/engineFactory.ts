@@ -1,6 +1,6 @@
 import { GranularParams } from '../types';
 import { IAudioEngine } from './IAudioEngine';
-import { AudioEngineWASM } from './audioEngineWASM';
+import { AudioEngineWASM, AudioEngineWASMOptions } from './audioEngineWASM';
 import { AudioEngine } from './audioEngine';
 
 export type EngineType = 'wasm' | 'js';
@@ -10,11 +10,13 @@ export type EngineType = 'wasm' | 'js';
  *
  * The WASM engine runs grain synthesis in an AudioWorklet for better
  * performance and timing accuracy. If WASM or AudioWorklet is unavailable,
- * falls back to the original JS engine.
+ * falls back to the original JS engine. `wasmOptions` (e.g. render-ahead)
+ * only apply to the WASM engine.
  */
 export async function createEngine(
     params: GranularParams,
-    preferred: EngineType = 'wasm'
+    preferred: EngineType = 'wasm',
+    wasmOptions: AudioEngineWASMOptions = {}
 ): Promise<{ engine: IAudioEngine; type: EngineType }> {
 
     if (preferred === 'wasm') {
@@ -27,7 +29,7 @@ export async function createEngine(
                 throw new Error('WebAssembly not supported');
             }
 
-            const engine = new AudioEngineWASM(params);
+            const engine = new AudioEngineWASM(params, wasmOptions);
             await engine.init();
             console.log('[NodeGrain] Using WASM audio engine');
             return { engine, type: 'wasm' };
@@ -1,5 +1,6 @@
 export type EnvelopeCurve = 'linear' | 'exponential';
 export type LfoShape = 'sine' | 'triangle' | 'square' | 'sawtooth';
+export type FilterType = 'lowpass' | 'bandpass' | 'highpass' | 'notch';
 export type ScaleType = 'chromatic' | 'major' | 'minor' | 'pentaMajor' | 'pentaMinor';
 
 // Scale intervals in semitones from root
@@ -63,7 +64,7 @@ export interface GranularParams {
   delayFeedback: number; // Delay feedback (0 - 0.95)
   delayMix: number; // Delay wet mix (0 - 1)
   reverbMix: number; // 0 (dry) to 1 (wet)
-  reverbDecay: number; // Impulse response duration in seconds
+  reverbDecay: number; // Decay time in seconds (IR length in the JS engine, T60 in WASM)
 
   // LFO
   lfoRate: number; // Frequency in Hz (0.1 - 20)
@@ -75,6 +76,54 @@ export interface GranularParams {
   volume: number; // Master gain (0 - 1)
   filterFreq: number; // Lowpass filter cutoff (20 - 20000)
   filterRes: number; // Resonance (0 - 20)
+  filterType?: FilterType; // Filter response (defaults to lowpass)
+
+  // Per-grain filter (WASM engine only): each grain gets its own cutoff and
+  // resonance, randomized around the centre values
+  grainFilterMode?: 'off' | FilterType;
+  grainFilterFreq?: number; // Centre cutoff (20 - 20000)
+  grainFilterRes?: number; // Centre resonance, read like filterRes: dB for LP/HP, linear Q for BP/notch (0 - 20)
+  grainFilterSpread?: number; // Randomization (0 - 1): up to ±4 octaves, ±10 resonance
+  // Spectral grains resynthesize precomputed STFT frames: pitch without
+  // formant shift, and freeze holds a frame instead of a position
+  grainMode?: 'time' | 'spectral';
+  spectralFormant?: number; // Formant preservation when pitched (0 - 1)
+  spectralSmear?: number; // Phase randomization (0 - 1)
+
+  // FX routing (WASM engine only). 'insert' runs delay and reverb on the whole
+  // mix; 'sends' feeds them from per-grain sends (delayMix / reverbMix become
+  // return levels); 'external' leaves the send buses to the host on the
+  // worklet's aux outputs (see AudioEngineWASM.connectAuxBus).
+  fxRouting?: 'insert' | 'sends' | 'external';
+  sendDelay?: number; // Per-grain delay send (0 - 1)
+  sendReverb?: number; // Per-grain reverb send (0 - 1)
+  sendSpread?: number; // Per-grain send randomization (0 - 1)
+
+  // Distortion oversampling factor (WASM engine only, defaults to 4)
+  distOversample?: 1 | 2 | 4;
+
+  // Delay feedback damping (WASM engine only): 0 = off, 1 = 200 Hz lowpass
+  delayDamping?: number;
+
+  // Reverb high-frequency damping (WASM engine only, defaults to 0.3)
+  reverbDamping?: number;
+
+  // Reverb algorithm (WASM engine only). 'convolution' uses the IR loaded with
+  // loadImpulseResponse() and falls back to 'fdn' until one is loaded.
+  reverbType?: 'fdn' | 'convolution';
+
+  // Master output protection (WASM engine only). 'limit' is a 2 ms lookahead
+  // true-peak limiter (defaults on), 'softclip' a zero-latency saturator.
+  limiterMode?: 'off' | 'limit' | 'softclip';
+  limiterCeiling?: number; // Output ceiling in dBFS (-24 - 0, defaults to -1)
+  limiterRelease?: number; // Limiter release in seconds (0.01 - 1, defaults to 0.1)
+
+  // Note amplitude envelope for polyphonic mode (WASM engine only, see
+  // AudioEngineWASM.setPolyphonic), shared by every held note
+  noteAttack?: number; // Seconds (0 - 10, defaults to 0.01)
+  noteDecay?: number; // Seconds (0 - 10, defaults to 0.1)
+  noteSustain?: number; // Level (0 - 1, defaults to 1)
+  noteRelease?: number; // Seconds (0 - 10, defaults to 0.3)
 }
 
 export const DEFAULT_PARAMS: GranularParams = {
@@ -2,16 +2,23 @@ import path from 'path';
 import { defineConfig } from 'vite';
 import react from '@vitejs/plugin-react';
 
+// Cross-origin isolation, required for SharedArrayBuffer (render-ahead ring,
+// telemetry and the pthreads build). 'credentialless' keeps the CDN scripts
+// in index.html loading without CORP headers. Production hosts must send
+// the same headers (see Deployment in the README).
+const crossOriginIsolation = {
+  'Cross-Origin-Opener-Policy': 'same-origin',
+  'Cross-Origin-Embedder-Policy': 'credentialless',
+};
+
 export default defineConfig({
   server: {
     port: 3000,
     host: '0.0.0.0',
-    headers: {
-      // Required for SharedArrayBuffer (not currently used, but future-proofing)
-      // Uncomment if you switch to SharedArrayBuffer for parameter passing:
-      // 'Cross-Origin-Opener-Policy': 'same-origin',
-      // 'Cross-Origin-Embedder-Policy': 'require-corp',
-    },
+    headers: crossOriginIsolation,
+  },
+  preview: {
+    headers: crossOriginIsolation,
   },
   plugins: [react()],
   resolve: {